@@ -3,6 +3,14 @@ const std = @import("std");
 pub fn build(b: *std.Build) void {
     const target = b.standardTargetOptions(.{});
     const optimize = b.standardOptimizeOption(.{});
+    const enable_simd = b.option(bool, "simd", "Enable SIMD optimizations (AVX2)") orelse true;
+
+    // Generation pipeline + exports, shared by the UI app and the CLI
+    const core = b.addStaticLibrary(.{
+        .name = "ymirge_core",
+        .target = target,
+        .optimize = optimize,
+    });
 
     // Main executable
     const exe = b.addExecutable(.{
@@ -18,6 +26,12 @@ pub fn build(b: *std.Build) void {
         "-DIMGUI_IMPL_OPENGL_LOADER_GLAD",
     };
 
+    // ymirge_core flags (ImageExporter defines the stb_image_write implementation)
+    const core_flags = &[_][]const u8{
+        "-std=c++17",
+        "-DYMIRGE_CORE_LIBRARY",
+    };
+
     // ImGui-specific flags (use our custom config to disable SSE)
     const imgui_flags = &[_][]const u8{
         "-std=c++17",
@@ -30,38 +44,48 @@ pub fn build(b: *std.Build) void {
     else
         &[_][]const u8{ "-g", "-O0" };
 
+    // Same as CMake's PUBLIC flags on ymirge_core: everything built on core
+    // gets them, so inline AVX2 paths in headers agree across targets
+    const simd_flags = if (enable_simd and target.result.cpu.arch.isX86())
+        &[_][]const u8{ "-mavx2", "-mfma" }
+    else
+        &[_][]const u8{};
+
     // Include paths
-    exe.addIncludePath(.{ .cwd_relative = "src" });
-    exe.addIncludePath(.{ .cwd_relative = "src/core" });
-    exe.addIncludePath(.{ .cwd_relative = "src/algorithms" });
+    addCoreIncludePaths(core);
+    addCoreIncludePaths(exe);
     exe.addIncludePath(.{ .cwd_relative = "src/gpu" });
     exe.addIncludePath(.{ .cwd_relative = "src/rendering" });
     exe.addIncludePath(.{ .cwd_relative = "src/layers" });
     exe.addIncludePath(.{ .cwd_relative = "src/tools" });
-    exe.addIncludePath(.{ .cwd_relative = "src/ui" });
-    exe.addIncludePath(.{ .cwd_relative = "src/export" });
-    exe.addIncludePath(.{ .cwd_relative = "vendor" });
     exe.addIncludePath(.{ .cwd_relative = "vendor/glad/include" });
     exe.addIncludePath(.{ .cwd_relative = "vendor/imgui" });
     exe.addIncludePath(.{ .cwd_relative = "vendor/imgui/backends" });
-    exe.addIncludePath(.{ .cwd_relative = "vendor/glm" });
 
 
-    // Source files
-    const cpp_sources = &[_][]const u8{
+    // ymirge_core source files
+    const core_sources = &[_][]const u8{
         // Core
+        "src/core/BatchGenerator.cpp",
         "src/core/HeightMap.cpp",
         "src/core/HeightMapEditCommand.cpp",
         "src/core/PerlinNoise.cpp",
         "src/core/ResolutionManager.cpp",
+        "src/core/TerrainCache.cpp",
         "src/core/TerrainGenerator.cpp",
         "src/core/ThreadPool.cpp",
+        "src/core/TileQueue.cpp",
         "src/core/UndoStack.cpp",
 
         // Algorithms
+        "src/algorithms/ArchipelagoMask.cpp",
+        "src/algorithms/DistanceTransform.cpp",
         "src/algorithms/EdgeSmoothing.cpp",
+        "src/algorithms/Filters.cpp",
         "src/algorithms/HydraulicErosion.cpp",
+        "src/algorithms/Hydrology.cpp",
         "src/algorithms/Peaks.cpp",
+        "src/algorithms/PolylineRasterizer.cpp",
         "src/algorithms/RiverEnhancements.cpp",
         "src/algorithms/Rivers.cpp",
         "src/algorithms/TerrainSoftening.cpp",
@@ -69,6 +93,16 @@ pub fn build(b: *std.Build) void {
         "src/algorithms/ValleyConnectivity.cpp",
         "src/algorithms/ValleyFlattening.cpp",
 
+        // Export
+        "src/export/AdvancedSplatmap.cpp",
+        "src/export/ImageExporter.cpp",
+
+        // Presets (UI-free)
+        "src/ui/PresetManager.cpp",
+    };
+
+    // UI application source files
+    const cpp_sources = &[_][]const u8{
         // GPU
         "src/gpu/ComputeShader.cpp",
         "src/gpu/GaussianBlurGPU.cpp",
@@ -98,13 +132,8 @@ pub fn build(b: *std.Build) void {
         "src/tools/StampTool.cpp",
 
         // UI
-        "src/ui/PresetManager.cpp",
         "src/ui/UIManagerImGui.cpp",
 
-        // Export
-        "src/export/AdvancedSplatmap.cpp",
-        "src/export/ImageExporter.cpp",
-
         // Main
         "src/main_ui_sdl.cpp",
     };
@@ -125,11 +154,21 @@ pub fn build(b: *std.Build) void {
         "vendor/glad/src/glad.c",
     };
 
+    // Add ymirge_core sources
+    for (core_sources) |src| {
+        core.addCSourceFile(.{
+            .file = .{ .cwd_relative = src },
+            .flags = core_flags ++ simd_flags ++ release_flags,
+        });
+    }
+    core.linkLibC();
+    core.linkLibCpp();
+
     // Add C++ sources
     for (cpp_sources) |src| {
         exe.addCSourceFile(.{
             .file = .{ .cwd_relative = src },
-            .flags = cpp_flags ++ release_flags,
+            .flags = cpp_flags ++ simd_flags ++ release_flags,
         });
     }
 
@@ -150,6 +189,7 @@ pub fn build(b: *std.Build) void {
     }
 
     // Link system libraries
+    exe.linkLibrary(core);
     exe.linkLibC();
     exe.linkLibCpp();
     exe.linkSystemLibrary("SDL2");
@@ -162,6 +202,26 @@ pub fn build(b: *std.Build) void {
         .dest_dir = .{ .override = .prefix },
     }).step);
 
+    // Headless batch generator (no display or GL context)
+    const cli = b.addExecutable(.{
+        .name = "ymirge-cli",
+        .target = target,
+        .optimize = optimize,
+    });
+    addCoreIncludePaths(cli);
+    cli.addCSourceFile(.{
+        .file = .{ .cwd_relative = "src/main_cli.cpp" },
+        .flags = core_flags ++ simd_flags ++ release_flags,
+    });
+    cli.linkLibrary(core);
+    cli.linkLibC();
+    cli.linkLibCpp();
+    cli.linkSystemLibrary("pthread");
+
+    b.getInstallStep().dependOn(&b.addInstallArtifact(cli, .{
+        .dest_dir = .{ .override = .prefix },
+    }).step);
+
     // Install shaders directory alongside executable
     b.installDirectory(.{
         .source_dir = .{ .cwd_relative = "shaders" },
@@ -189,3 +249,14 @@ pub fn build(b: *std.Build) void {
     const run_step = b.step("run", "Run Ymirge");
     run_step.dependOn(&run_cmd.step);
 }
+
+// Headers needed by anything built on ymirge_core
+fn addCoreIncludePaths(step: *std.Build.Step.Compile) void {
+    step.addIncludePath(.{ .cwd_relative = "src" });
+    step.addIncludePath(.{ .cwd_relative = "src/core" });
+    step.addIncludePath(.{ .cwd_relative = "src/algorithms" });
+    step.addIncludePath(.{ .cwd_relative = "src/export" });
+    step.addIncludePath(.{ .cwd_relative = "src/ui" });
+    step.addIncludePath(.{ .cwd_relative = "vendor" });
+    step.addIncludePath(.{ .cwd_relative = "vendor/glm" });
+}
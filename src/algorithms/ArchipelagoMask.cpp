@@ -0,0 +1,120 @@
+#include "ArchipelagoMask.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr float PI = 3.14159265f;
+
+// atan2 to ~1e-5 rad, far below one angle step (6e-3 rad)
+inline float fastAtan2(float y, float x) {
+    float ax = std::abs(x);
+    float ay = std::abs(y);
+    float a = std::min(ax, ay) / std::max(std::max(ax, ay), 1e-20f);
+    float s = a * a;
+    float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+    r = ay > ax ? 1.57079637f - r : r;
+    r = x < 0.0f ? PI - r : r;
+    return y < 0.0f ? -r : r;
+}
+}
+
+ArchipelagoMask::ArchipelagoMask(const std::vector<Island>& islands,
+                                 uint32_t noiseSeed,
+                                 float variation,
+                                 float shape,
+                                 int width,
+                                 int height)
+    : shape_(shape), width_(width), height_(height) {
+
+    // Create noise for irregular island shapes
+    PerlinNoise shapeNoise(noiseSeed);
+
+    islands_.reserve(islands.size());
+    for (const auto& island : islands) {
+        IslandShape entry;
+        entry.centerX = island.centerX;
+        entry.centerY = island.centerY;
+        entry.radius = island.radius;
+        entry.maxRadius = 0.0f;
+        entry.radiusByAngle.resize(ANGLE_STEPS + 1);
+
+        // Add noise to radius for irregular shapes
+        for (int i = 0; i <= ANGLE_STEPS; ++i) {
+            float angle = -PI + 2.0f * PI * i / ANGLE_STEPS;
+            float noiseVal = shapeNoise.octaveNoise(
+                island.centerX * 10.0f + std::cos(angle) * 3.0f,
+                island.centerY * 10.0f + std::sin(angle) * 3.0f,
+                3, 0.5f, 2.0f);
+            float radius = island.radius * (1.0f + noiseVal * variation * 0.4f);
+            entry.radiusByAngle[i] = radius;
+            entry.maxRadius = std::max(entry.maxRadius, radius);
+        }
+
+        islands_.push_back(std::move(entry));
+    }
+
+    // Bin islands by the row bands their bounding circle covers
+    int numBands = (height + BAND_ROWS - 1) / BAND_ROWS;
+    bands_.resize(std::max(0, numBands));
+    for (size_t i = 0; i < islands_.size(); ++i) {
+        const auto& island = islands_[i];
+        if (island.maxRadius <= 0.0f) continue;
+
+        int y0 = static_cast<int>(std::floor((island.centerY - island.maxRadius) * height));
+        int y1 = static_cast<int>(std::ceil((island.centerY + island.maxRadius) * height));
+        y0 = std::max(0, y0);
+        y1 = std::min(height - 1, y1);
+
+        for (int band = y0 / BAND_ROWS; y0 <= y1 && band <= y1 / BAND_ROWS; ++band) {
+            bands_[band].push_back(static_cast<int>(i));
+        }
+    }
+}
+
+float ArchipelagoMask::noisyRadius(const IslandShape& island, float angle) const {
+    float pos = (angle + PI) * (ANGLE_STEPS / (2.0f * PI));
+    pos = std::clamp(pos, 0.0f, static_cast<float>(ANGLE_STEPS));
+    int i = std::min(static_cast<int>(pos), ANGLE_STEPS - 1);
+    float t = pos - i;
+    return island.radiusByAngle[i] + (island.radiusByAngle[i + 1] - island.radiusByAngle[i]) * t;
+}
+
+void ArchipelagoMask::evaluateRow(int y, float* out) const {
+    std::fill(out, out + width_, 0.0f);
+    if (y < 0 || y >= height_) return;
+
+    float ny = static_cast<float>(y) / height_;
+
+    for (int index : bands_[y / BAND_ROWS]) {
+        const IslandShape& island = islands_[index];
+
+        // x-span where this row crosses the bounding circle
+        float dy = ny - island.centerY;
+        float maxRadiusSq = island.maxRadius * island.maxRadius;
+        float halfChordSq = maxRadiusSq - dy * dy;
+        if (halfChordSq <= 0.0f) continue;
+        float halfChord = std::sqrt(halfChordSq);
+
+        int x0 = std::max(0, static_cast<int>(std::floor((island.centerX - halfChord) * width_)));
+        int x1 = std::min(width_ - 1, static_cast<int>(std::ceil((island.centerX + halfChord) * width_)));
+
+        for (int x = x0; x <= x1; ++x) {
+            float nx = static_cast<float>(x) / width_;
+            float dx = nx - island.centerX;
+            float distSq = dx * dx + dy * dy;
+            if (distSq >= maxRadiusSq) continue;
+
+            float dist = std::sqrt(distSq);
+            float radius = noisyRadius(island, fastAtan2(dy, dx));
+
+            if (dist < radius) {
+                // Smooth falloff from center to edge
+                float normalizedDist = dist / radius;
+                float falloff = std::max(0.0f, 1.0f - std::pow(normalizedDist, shape_));
+
+                // Use max to combine overlapping islands
+                out[x] = std::max(out[x], falloff);
+            }
+        }
+    }
+}
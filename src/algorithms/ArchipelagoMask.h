@@ -0,0 +1,55 @@
+#pragma once
+
+#include "PerlinNoise.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * ArchipelagoMask - Island coverage for multi-island terrain
+ *
+ * Each island is a circle (in normalized map coordinates) whose radius is
+ * perturbed by noise sampled around its center. The noise only depends on
+ * island and angle, so it is tabulated once per island (ANGLE_STEPS
+ * entries). Islands are binned by the row bands their bounding circle
+ * covers, and each row only visits the x-span an island can reach.
+ */
+class ArchipelagoMask {
+public:
+    struct Island {
+        float centerX;  // 0-1 across the map
+        float centerY;  // 0-1 down the map
+        float radius;   // 0-1 of the map
+    };
+
+    /**
+     * @param variation Shape variation (0 = circular, 1 = irregular)
+     * @param shape Falloff exponent: effect = 1 - (dist / radius)^shape
+     */
+    ArchipelagoMask(const std::vector<Island>& islands,
+                    uint32_t noiseSeed,
+                    float variation,
+                    float shape,
+                    int width,
+                    int height);
+
+    // Strongest island effect (0-1) for every pixel of row y, written to out[0..width)
+    void evaluateRow(int y, float* out) const;
+
+private:
+    static constexpr int ANGLE_STEPS = 1024;
+    static constexpr int BAND_ROWS = 32;
+
+    struct IslandShape {
+        float centerX, centerY;
+        float radius;
+        float maxRadius;                  // Largest noisy radius (bounding circle)
+        std::vector<float> radiusByAngle; // Noisy radius per angle step, ANGLE_STEPS + 1 entries
+    };
+
+    float noisyRadius(const IslandShape& island, float angle) const;
+
+    std::vector<IslandShape> islands_;
+    std::vector<std::vector<int>> bands_;  // Islands touching each row band
+    float shape_;
+    int width_, height_;
+};
@@ -0,0 +1,272 @@
+#include "DistanceTransform.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+// Columns per strip in the column pass, so each row step touches whole
+// cache lines instead of one float per row
+constexpr int COLUMN_STRIP = 64;
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+}
+
+void DistanceTransform::compute(const std::vector<uint8_t>& mask,
+                                HeightMap& distance,
+                                ThreadPool* pool,
+                                std::vector<int>* nearest) {
+    run(mask, false, distance, pool, nearest);
+}
+
+void DistanceTransform::computeSigned(const std::vector<uint8_t>& mask,
+                                      HeightMap& distance,
+                                      ThreadPool* pool) {
+    HeightMap inside(distance.getWidth(), distance.getHeight());
+    run(mask, false, distance, pool, nullptr);
+    run(mask, true, inside, pool, nullptr);
+
+    float* out = distance.getData();
+    const float* in = inside.getData();
+    for (size_t i = 0; i < distance.getSize(); ++i) {
+        if (mask[i]) {
+            out[i] = -in[i];
+        }
+    }
+}
+
+void DistanceTransform::run(const std::vector<uint8_t>& mask, bool invert,
+                            HeightMap& distance, ThreadPool* pool,
+                            std::vector<int>* nearest) {
+    int width = distance.getWidth();
+    int height = distance.getHeight();
+    size_t size = distance.getSize();
+
+    if (mask.size() != size) {
+        throw std::invalid_argument("DistanceTransform: mask size doesn't match output");
+    }
+
+    std::vector<float> squared(size);
+    std::vector<int> nearestRow;
+    if (nearest) {
+        nearestRow.resize(size);
+        nearest->assign(size, -1);
+    }
+
+    int numStrips = (width + COLUMN_STRIP - 1) / COLUMN_STRIP;
+    auto processStrip = [&](size_t strip) {
+        int x0 = static_cast<int>(strip) * COLUMN_STRIP;
+        columnPass(mask, invert, width, height, x0, std::min(COLUMN_STRIP, width - x0),
+                   squared.data(), nearest ? nearestRow.data() : nullptr);
+    };
+
+    auto processRow = [&](size_t y) {
+        thread_local std::vector<int> hull;
+        thread_local std::vector<double> bounds;
+        rowPass(squared.data(), nearest ? nearestRow.data() : nullptr,
+                width, static_cast<int>(y), distance.getData(),
+                nearest ? nearest->data() : nullptr, hull, bounds);
+    };
+
+    if (pool) {
+        pool->parallelFor(0, numStrips, processStrip);
+        pool->parallelFor(0, height, processRow, 16);
+    } else {
+        for (int strip = 0; strip < numStrips; ++strip) {
+            processStrip(strip);
+        }
+        for (int y = 0; y < height; ++y) {
+            processRow(y);
+        }
+    }
+}
+
+void DistanceTransform::columnPass(const std::vector<uint8_t>& mask, bool invert,
+                                   int width, int height, int x0, int lanes,
+                                   float* squared, int* nearestRow) {
+    // Forward then backward sweep; squared holds the vertical distance
+    // (not yet squared) until the final loop
+    for (int y = 0; y < height; ++y) {
+        size_t row = static_cast<size_t>(y) * width + x0;
+        for (int l = 0; l < lanes; ++l) {
+            bool feature = (mask[row + l] != 0) != invert;
+            if (feature) {
+                squared[row + l] = 0.0f;
+                if (nearestRow) nearestRow[row + l] = y;
+            } else if (y > 0) {
+                squared[row + l] = squared[row + l - width] + 1.0f;
+                if (nearestRow) nearestRow[row + l] = nearestRow[row + l - width];
+            } else {
+                squared[row + l] = INF;
+                if (nearestRow) nearestRow[row + l] = -1;
+            }
+        }
+    }
+
+    for (int y = height - 2; y >= 0; --y) {
+        size_t row = static_cast<size_t>(y) * width + x0;
+        for (int l = 0; l < lanes; ++l) {
+            float below = squared[row + l + width] + 1.0f;
+            if (below < squared[row + l]) {
+                squared[row + l] = below;
+                if (nearestRow) nearestRow[row + l] = nearestRow[row + l + width];
+            }
+        }
+    }
+
+    for (int y = 0; y < height; ++y) {
+        size_t row = static_cast<size_t>(y) * width + x0;
+        for (int l = 0; l < lanes; ++l) {
+            float d = squared[row + l];
+            squared[row + l] = d * d;
+        }
+    }
+}
+
+void DistanceTransform::rowPass(const float* squared, const int* nearestRow,
+                                int width, int y,
+                                float* distance, int* nearest,
+                                std::vector<int>& hull, std::vector<double>& bounds) {
+    size_t row = static_cast<size_t>(y) * width;
+    thread_local std::vector<int> column;
+    column.resize(width);
+
+    float* out = distance + row;
+    if (!lowerEnvelope(squared + row, width, out, column.data(), hull, bounds)) {
+        // No features reachable from this row
+        std::fill(out, out + width, INF);
+        return;
+    }
+
+    for (int x = 0; x < width; ++x) {
+        out[x] = std::sqrt(out[x]);
+        if (nearest) {
+            int q = column[x];
+            nearest[row + x] = nearestRow[row + q] * width + q;
+        }
+    }
+}
+
+void DistanceTransform::computePower(const std::vector<float>& radius,
+                                     HeightMap& power,
+                                     ThreadPool* pool,
+                                     std::vector<int>* nearest) {
+    int width = power.getWidth();
+    int height = power.getHeight();
+    size_t size = power.getSize();
+
+    if (radius.size() != size) {
+        throw std::invalid_argument("DistanceTransform: radius size doesn't match output");
+    }
+
+    // Columns: min over discs in the same column of dy^2 - r^2. Unlike a
+    // binary mask the weights differ per disc, so this needs the envelope
+    // rather than the two-sweep pass.
+    std::vector<float> columnPower(size);
+    std::vector<int> nearestRow(nearest ? size : 0);
+
+    auto processColumn = [&](size_t column) {
+        int x = static_cast<int>(column);
+        thread_local std::vector<float> f;
+        thread_local std::vector<float> out;
+        thread_local std::vector<int> argmin;
+        thread_local std::vector<int> hull;
+        thread_local std::vector<double> bounds;
+        f.resize(height);
+        out.resize(height);
+        argmin.resize(height);
+
+        for (int y = 0; y < height; ++y) {
+            float r = radius[static_cast<size_t>(y) * width + x];
+            f[y] = r > 0.0f ? -r * r : INF;
+        }
+
+        bool any = lowerEnvelope(f.data(), height, out.data(), argmin.data(), hull, bounds);
+        for (int y = 0; y < height; ++y) {
+            size_t idx = static_cast<size_t>(y) * width + x;
+            columnPower[idx] = any ? out[y] : INF;
+            if (nearest) nearestRow[idx] = any ? argmin[y] : -1;
+        }
+    };
+
+    // Rows: same envelope over the column results
+    if (nearest) {
+        nearest->assign(size, -1);
+    }
+    auto processRow = [&](size_t y) {
+        size_t row = y * width;
+        thread_local std::vector<int> argmin;
+        thread_local std::vector<int> hull;
+        thread_local std::vector<double> bounds;
+        argmin.resize(width);
+
+        float* out = power.getData() + row;
+        if (!lowerEnvelope(columnPower.data() + row, width, out, argmin.data(), hull, bounds)) {
+            std::fill(out, out + width, INF);
+            return;
+        }
+        if (nearest) {
+            for (int x = 0; x < width; ++x) {
+                int q = argmin[x];
+                (*nearest)[row + x] = nearestRow[row + q] * width + q;
+            }
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, width, processColumn, 16);
+        pool->parallelFor(0, height, processRow, 16);
+    } else {
+        for (int x = 0; x < width; ++x) {
+            processColumn(x);
+        }
+        for (int y = 0; y < height; ++y) {
+            processRow(y);
+        }
+    }
+}
+
+bool DistanceTransform::lowerEnvelope(const float* f, int n,
+                                      float* out, int* argmin,
+                                      std::vector<int>& hull, std::vector<double>& bounds) {
+    // Lower envelope of parabolas (x - q)^2 + f[q]. Intersections in double:
+    // f + q^2 exceeds float's exact integer range on large maps.
+    hull.resize(n);
+    bounds.resize(n + 1);
+    int k = -1;
+
+    for (int q = 0; q < n; ++q) {
+        if (f[q] == INF) continue;
+
+        double fq = static_cast<double>(f[q]) + static_cast<double>(q) * q;
+        double s = -std::numeric_limits<double>::infinity();
+        while (k >= 0) {
+            int v = hull[k];
+            double fv = static_cast<double>(f[v]) + static_cast<double>(v) * v;
+            s = (fq - fv) / (2.0 * (q - v));
+            if (s > bounds[k]) break;
+            --k;
+        }
+
+        ++k;
+        hull[k] = q;
+        bounds[k] = k == 0 ? -std::numeric_limits<double>::infinity() : s;
+        bounds[k + 1] = std::numeric_limits<double>::infinity();
+    }
+
+    if (k < 0) {
+        return false;
+    }
+
+    int j = 0;
+    for (int x = 0; x < n; ++x) {
+        while (bounds[j + 1] < x) {
+            ++j;
+        }
+        int q = hull[j];
+        float dx = static_cast<float>(x - q);
+        out[x] = dx * dx + f[q];
+        argmin[x] = q;
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "HeightMap.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * DistanceTransform - Exact Euclidean distance transform in O(n)
+ *
+ * Felzenszwalb & Huttenlocher (2012) separable algorithm:
+ * 1. Columns: 1D distance to the nearest feature pixel in the same column
+ * 2. Rows: lower envelope of parabolas over the column results
+ *
+ * Columns run in parallel strips, rows in parallel. Replaces brute-force
+ * window scans ("distance to the nearest river/boundary within r pixels"),
+ * which cost O(n * r^2).
+ */
+class DistanceTransform {
+public:
+    /**
+     * Distance from every pixel to the nearest feature pixel (mask != 0)
+     *
+     * @param mask Feature mask, width * height entries
+     * @param distance Output distances in pixels (same size as mask);
+     *                 +infinity everywhere if the mask has no features
+     * @param nearest Optional output: index (y * width + x) of the nearest
+     *                feature pixel, -1 if none
+     */
+    static void compute(const std::vector<uint8_t>& mask,
+                        HeightMap& distance,
+                        ThreadPool* pool,
+                        std::vector<int>* nearest = nullptr);
+
+    /**
+     * Signed distance: positive outside the mask (distance to the nearest
+     * feature pixel), negative inside (distance to the nearest non-feature
+     * pixel). Pixels on either side of the boundary are +1 / -1.
+     */
+    static void computeSigned(const std::vector<uint8_t>& mask,
+                              HeightMap& distance,
+                              ThreadPool* pool);
+
+    /**
+     * Power distance to a set of discs: min over discs c of
+     * |p - c|^2 - radius[c]^2, for every pixel p. Negative inside at least
+     * one disc; the minimizing disc is the one covering p most deeply, so a
+     * wide disc wins over a narrow one whose center happens to be closer.
+     *
+     * @param radius Disc radius per pixel, width * height entries;
+     *               pixels with radius <= 0 are not discs
+     * @param power Output power distances in squared pixels (same size);
+     *              +infinity everywhere if there are no discs
+     * @param nearest Optional output: index of the minimizing disc center,
+     *                -1 if none
+     */
+    static void computePower(const std::vector<float>& radius,
+                             HeightMap& power,
+                             ThreadPool* pool,
+                             std::vector<int>* nearest = nullptr);
+
+private:
+    // Column pass on `lanes` adjacent columns starting at x0
+    static void columnPass(const std::vector<uint8_t>& mask, bool invert,
+                           int width, int height, int x0, int lanes,
+                           float* squared, int* nearestRow);
+
+    // Row pass for row y: squared column distances -> final distances
+    static void rowPass(const float* squared, const int* nearestRow,
+                        int width, int y,
+                        float* distance, int* nearest,
+                        std::vector<int>& hull, std::vector<double>& bounds);
+
+    // 1D transform of a sampled function: out[x] = min_q (x - q)^2 + f[q]
+    // and argmin[x] = q. Entries of f that are +infinity are skipped.
+    // Returns false (outputs untouched) if every entry is +infinity.
+    static bool lowerEnvelope(const float* f, int n,
+                              float* out, int* argmin,
+                              std::vector<int>& hull, std::vector<double>& bounds);
+
+    static void run(const std::vector<uint8_t>& mask, bool invert,
+                    HeightMap& distance, ThreadPool* pool,
+                    std::vector<int>* nearest);
+};
@@ -1,33 +1,171 @@
 #include "EdgeSmoothing.h"
+#include "Filters.h"
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+#if defined(__AVX2__)
+// pow(x, e) as exp2(e * log2(x)) with Cephes' logf/exp2f polynomials,
+// within a few ulp of std::pow for x in (0, 2]. The scalar version repeats
+// the vector one op for op (fused where it fuses), so row tails match.
+constexpr float SQRT_HALF = 0.70710678f;
+constexpr float LOG2_E = 1.44269504f;
+constexpr float LOG_POLY[] = {
+    7.0376836292e-2f, -1.1514610310e-1f, 1.1676998740e-1f,
+    -1.2420140846e-1f, 1.4249322787e-1f, -1.6668057665e-1f,
+    2.0000714765e-1f, -2.4999993993e-1f, 3.3333331174e-1f
+};
+constexpr float EXP2_POLY[] = {
+    1.535336188319500e-4f, 1.339887440266574e-3f, 9.618437357674640e-3f,
+    5.550332471162809e-2f, 2.402264791363012e-1f, 6.931472028550421e-1f
+};
+
+inline float powScalar(float x, float e) {
+    if (x <= 0.0f) return 0.0f;
+
+    // x = m * 2^k, m in [sqrt(0.5), sqrt(2))
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    float k = static_cast<float>(static_cast<int32_t>(bits >> 23) - 126);
+    uint32_t mantissa = (bits & 0x807fffffu) | 0x3f000000u;
+    float m;
+    std::memcpy(&m, &mantissa, sizeof(m));
+    bool small = m < SQRT_HALF;
+    k -= small ? 1.0f : 0.0f;
+    float f = (m + (small ? m : 0.0f)) - 1.0f;
+
+    float z = f * f;
+    float poly = LOG_POLY[0];
+    for (int i = 1; i < 9; ++i) {
+        poly = std::fma(poly, f, LOG_POLY[i]);
+    }
+    float y = poly * f * z;
+    y = std::fma(-0.5f, z, y);
+    float log2x = std::fma(f + y, LOG2_E, k);
+
+    // 2^t = 2^n * 2^r, r in [-0.5, 0.5]
+    float t = std::max(e * log2x, -126.0f);
+    float n = std::floor(t + 0.5f);
+    float r = t - n;
+    float p = EXP2_POLY[0];
+    for (int i = 1; i < 6; ++i) {
+        p = std::fma(p, r, EXP2_POLY[i]);
+    }
+    p = std::fma(p, r, 1.0f);
+
+    uint32_t scaleBits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &scaleBits, sizeof(scale));
+    return p * scale;
+}
+
+inline __m256 powVector(__m256 x, __m256 e) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256i bits = _mm256_castps_si256(x);
+    __m256 k = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x807fffff)),
+                                                   _mm256_set1_epi32(0x3f000000)));
+    __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+    k = _mm256_sub_ps(k, _mm256_and_ps(small, one));
+    __m256 f = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), one);
+
+    __m256 z = _mm256_mul_ps(f, f);
+    __m256 poly = _mm256_set1_ps(LOG_POLY[0]);
+    for (int i = 1; i < 9; ++i) {
+        poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(LOG_POLY[i]));
+    }
+    __m256 y = _mm256_mul_ps(_mm256_mul_ps(poly, f), z);
+    y = _mm256_fmadd_ps(_mm256_set1_ps(-0.5f), z, y);
+    __m256 log2x = _mm256_fmadd_ps(_mm256_add_ps(f, y), _mm256_set1_ps(LOG2_E), k);
+
+    __m256 t = _mm256_max_ps(_mm256_mul_ps(e, log2x), _mm256_set1_ps(-126.0f));
+    __m256 n = _mm256_floor_ps(_mm256_add_ps(t, _mm256_set1_ps(0.5f)));
+    __m256 r = _mm256_sub_ps(t, n);
+    __m256 p = _mm256_set1_ps(EXP2_POLY[0]);
+    for (int i = 1; i < 6; ++i) {
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(EXP2_POLY[i]));
+    }
+    p = _mm256_fmadd_ps(p, r, one);
+
+    __m256i scaleBits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    __m256 result = _mm256_mul_ps(p, _mm256_castsi256_ps(scaleBits));
+
+    // log2(0) isn't representable; pow(0, e) is 0
+    return _mm256_and_ps(result, _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ));
+}
+#endif
+
+// out[i] = in[i]^exponent for in[i] >= 0
+void powRow(const float* in, float exponent, float* out, int count) {
+    int i = 0;
+#if defined(__AVX2__)
+    __m256 e = _mm256_set1_ps(exponent);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, powVector(_mm256_loadu_ps(in + i), e));
+    }
+    for (; i < count; ++i) {
+        out[i] = powScalar(in[i], exponent);
+    }
+#else
+    for (; i < count; ++i) {
+        out[i] = std::pow(in[i], exponent);
+    }
+#endif
+}
+} // namespace
+
 void EdgeSmoothing::execute(HeightMap& map,
                            float edgePadding,
                            float islandShape,
                            uint32_t seed,
-                           ThreadPool* pool) {
+                           ThreadPool* pool,
+                           DistanceCache* cache) {
 
     if (edgePadding < 0.01f) return;
 
-    // Pass 1: Calculate distance map with noise
-    auto distanceMap = calculateDistanceMap(map, islandShape, seed);
+    int width = map.getWidth();
+    int height = map.getHeight();
+
+    // Pass 1: Calculate distance map with noise (depends only on size, shape and seed)
+    std::vector<float> localMap;
+    const std::vector<float>* distanceMap = &localMap;
+    if (cache) {
+        if (cache->width != width || cache->height != height ||
+            cache->islandShape != islandShape || cache->seed != seed ||
+            cache->distanceMap.empty()) {
+            cache->distanceMap = calculateDistanceMap(map, islandShape, seed, pool);
+            cache->width = width;
+            cache->height = height;
+            cache->islandShape = islandShape;
+            cache->seed = seed;
+        }
+        distanceMap = &cache->distanceMap;
+    } else {
+        localMap = calculateDistanceMap(map, islandShape, seed, pool);
+    }
 
     // Pass 2: Multiple rounds of aggressive smoothing (3 passes)
-    smoothEdges(map, distanceMap, edgePadding, 3, pool);
+    smoothEdges(map, *distanceMap, edgePadding, 3, pool);
 
     // Pass 3: Apply triple smoothstep for ultra-smooth taper
-    applyTripleSmoothstep(map, distanceMap, edgePadding, pool);
+    applyTripleSmoothstep(map, *distanceMap, edgePadding, pool);
 }
 
 std::vector<float> EdgeSmoothing::calculateDistanceMap(
     const HeightMap& map,
     float islandShape,
-    uint32_t seed) {
+    uint32_t seed,
+    ThreadPool* pool) {
 
     int width = map.getWidth();
     int height = map.getHeight();
-    std::vector<float> distMap(width * height);
+    std::vector<float> distMap(static_cast<size_t>(width) * height);
 
     float centerX = width * 0.5f;
     float centerY = height * 0.5f;
@@ -36,33 +174,64 @@ std::vector<float> EdgeSmoothing::calculateDistanceMap(
     PerlinNoise edgeNoise(seed);
     const float noiseScale = 15.0f;
 
-    for (int y = 0; y < height; ++y) {
+    // Minkowski distance (controls shape)
+    // p=1 -> diamond, p=2 -> circle, p>2 -> square with rounded corners
+    float p = 1.0f + (islandShape - 1.0f) * 1.5f;
+    float invP = 1.0f / p;
+
+    // |nx|^p only depends on the column, so it's computed once per column
+    std::vector<float> columnTerms(width);
+    for (int x = 0; x < width; ++x) {
+        float nx = std::abs((x - centerX) / centerX);
+        columnTerms[x] = (p == 1.0f) ? nx : (p == 2.0f) ? nx * nx : std::pow(nx, p);
+    }
+
+    auto processRow = [&](size_t row) {
+        int y = static_cast<int>(row);
+        float* out = distMap.data() + row * width;
+
+        // Add subtle noise for natural variation (whole row at once)
+        edgeNoise.octaveNoiseRow(0, noiseScale, y / noiseScale, width,
+                                 3, 0.5f, 2.0f, out);
+
+        float ny = std::abs((y - centerY) / centerY);
+        float rowTerm = (p == 1.0f) ? ny : (p == 2.0f) ? ny * ny : std::pow(ny, p);
+
+        // Every preset's p is fractional, so the root is the per-pixel cost:
+        // taken for the whole row at once, vectorized
+        thread_local std::vector<float> distances;
+        distances.resize(width);
+        for (int x = 0; x < width; ++x) {
+            distances[x] = columnTerms[x] + rowTerm;
+        }
+        if (p == 2.0f) {
+            for (int x = 0; x < width; ++x) {
+                distances[x] = std::sqrt(distances[x]);
+            }
+        } else if (p != 1.0f) {
+            powRow(distances.data(), invP, distances.data(), width);
+        }
+
         for (int x = 0; x < width; ++x) {
-            // Normalize coordinates to [-1, 1]
-            float nx = (x - centerX) / centerX;
-            float ny = (y - centerY) / centerY;
-
-            // Minkowski distance (controls shape)
-            // p=1 → diamond, p=2 → circle, p>2 → square with rounded corners
-            float p = 1.0f + (islandShape - 1.0f) * 1.5f;
-            float minkowskiDist = std::pow(
-                std::pow(std::abs(nx), p) + std::pow(std::abs(ny), p),
-                1.0f / p
-            );
-
-            // Add subtle noise for natural variation
-            float noiseValue = edgeNoise.octaveNoise(
-                x / noiseScale, y / noiseScale, 3, 0.5f, 2.0f);
+            float minkowskiDist = distances[x];
 
             // CRITICAL: Noise strength fades out near edges
             // This prevents jagged pillars at coastlines
             float noiseStrength = std::min(1.0f, minkowskiDist * 2.0f);
 
             // Only 3% noise influence (reduced from 15% to fix pillars)
-            float noisyDist = minkowskiDist + noiseValue * 0.03f * noiseStrength;
+            float noisyDist = minkowskiDist + out[x] * 0.03f * noiseStrength;
 
             // Convert to 0-1 range (0 = ocean, 1 = island center)
-            distMap[y * width + x] = std::max(0.0f, 1.0f - noisyDist);
+            out[x] = std::max(0.0f, 1.0f - noisyDist);
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, height, processRow, 8);
+    } else {
+        for (int y = 0; y < height; ++y) {
+            processRow(y);
         }
     }
 
@@ -81,54 +250,36 @@ void EdgeSmoothing::smoothEdges(
 
     // Expanded padding zone for wider smoothing area
     float expandedPadding = edgePadding * 3.5f;
+    float zone = expandedPadding * 0.7f;
 
-    // Multiple rounds of smoothing
-    for (int round = 0; round < rounds; ++round) {
-        HeightMap tempMap = map;
+    // Blend weights only depend on the distance map, so they serve every round
+    HeightMap weights(width, height);
+    float* weightData = weights.getData();
 
-        pool->parallelFor(0, height, [&](size_t y) {
-            int yi = static_cast<int>(y);
-            for (int x = 0; x < width; ++x) {
-                int idx = static_cast<int>(y * width + x);
-                float normalizedDist = distanceMap[idx];
-
-                // Only smooth within the edge zone
-                if (normalizedDist < expandedPadding * 0.7f) {
-                    float t = normalizedDist / (expandedPadding * 0.7f);
-
-                    // Apply Gaussian blur
-                    float sum = 0.0f;
-                    float weightSum = 0.0f;
-                    const int radius = 8;
-
-                    for (int dy = -radius; dy <= radius; ++dy) {
-                        for (int dx = -radius; dx <= radius; ++dx) {
-                            int maxX = static_cast<int>(width) - 1;
-                            int maxY = static_cast<int>(height) - 1;
-                            int nx = std::clamp<int>(x + dx, 0, maxX);
-                            int ny = std::clamp<int>(y + dy, 0, maxY);
-
-                            float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
-                            if (dist > radius) continue;
-
-                            // Gaussian weight
-                            float weight = 1.0f - (dist / radius);
-                            sum += map.at(nx, ny) * weight;
-                            weightSum += weight;
-                        }
-                    }
-
-                    float smoothed = sum / weightSum;
-
-                    // Extremely aggressive blending (up to 99% smoothed at edges)
-                    float blendFactor = 1.0f - t;
-                    tempMap.at(x, yi) = map.at(x, yi) * (1.0f - blendFactor * 0.99f) +
-                                       smoothed * blendFactor * 0.99f;
-                }
+    pool->parallelFor(0, height, [&](size_t y) {
+        size_t rowOffset = y * width;
+        for (int x = 0; x < width; ++x) {
+            float normalizedDist = distanceMap[rowOffset + x];
+
+            // Only smooth within the edge zone; extremely aggressive blending
+            // (up to 99% smoothed at edges)
+            float blendFactor = 0.0f;
+            if (normalizedDist < zone) {
+                blendFactor = (1.0f - normalizedDist / zone) * 0.99f;
             }
-        }, 4);
+            weightData[rowOffset + x] = blendFactor;
+        }
+    }, 16);
 
-        map = std::move(tempMap);
+    // Gaussian matching the variance of the former radius-8 cone kernel
+    // (sigma = 0.387 * radius)
+    const int radius = 8;
+    const float sigma = 0.387f * radius;
+
+    HeightMap smoothed(width, height);
+    for (int round = 0; round < rounds; ++round) {
+        Filters::gaussianBlur(map, smoothed, sigma, pool, radius);
+        Filters::blend(map, smoothed, weights, pool);
     }
 }
 
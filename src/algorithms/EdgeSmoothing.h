@@ -8,17 +8,28 @@
 // Three-pass island edge smoothing: distance map, aggressive smoothing, triple smoothstep
 class EdgeSmoothing {
 public:
+    // Distance map from an earlier call, reused while size, shape and seed match
+    struct DistanceCache {
+        int width = 0;
+        int height = 0;
+        float islandShape = 0.0f;
+        uint32_t seed = 0;
+        std::vector<float> distanceMap;
+    };
+
     static void execute(HeightMap& map,
                        float edgePadding,
                        float islandShape,
                        uint32_t seed,
-                       ThreadPool* pool);
+                       ThreadPool* pool,
+                       DistanceCache* cache = nullptr);
 
 private:
     static std::vector<float> calculateDistanceMap(
         const HeightMap& map,
         float islandShape,
-        uint32_t seed);
+        uint32_t seed,
+        ThreadPool* pool);
 
     static void smoothEdges(
         HeightMap& map,
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../core/HeightMap.h"
+
+/**
+ * ErosionMaps - By-product masks captured during erosion passes
+ *
+ * Filled by ThermalErosion and HydraulicErosion when a pointer is passed
+ * to apply(), so material masks come from the same simulation run:
+ * - flow:       Droplet visits weighted by water volume (hydraulic only)
+ * - deposition: Material deposited per cell
+ * - erosion:    Material removed per cell (wear)
+ *
+ * Values are raw accumulated amounts in height units. Passes add to the
+ * existing contents, so clear() before a fresh run.
+ */
+struct ErosionMaps {
+    HeightMap flow;
+    HeightMap deposition;
+    HeightMap erosion;
+
+    ErosionMaps(int width, int height)
+        : flow(width, height)
+        , deposition(width, height)
+        , erosion(width, height) {}
+
+    void clear() {
+        flow.clear();
+        deposition.clear();
+        erosion.clear();
+    }
+
+    int getWidth() const { return flow.getWidth(); }
+    int getHeight() const { return flow.getHeight(); }
+};
@@ -0,0 +1,602 @@
+#include "Filters.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+// Columns per strip for passes that run down columns
+constexpr int COLUMN_STRIP = 64;
+
+// Rows handed to a worker at a time
+constexpr size_t ROW_GRAIN = 8;
+
+void checkSize(const HeightMap& a, const HeightMap& b) {
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) {
+        throw std::invalid_argument("Filters: map sizes don't match");
+    }
+}
+
+void forEach(ThreadPool* pool, size_t count, const std::function<void(size_t)>& func, size_t grain = 1) {
+    if (pool) {
+        pool->parallelFor(0, count, func, grain);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+    }
+}
+
+// a * b + c, fused whenever the vector loops are, so a pixel gets the same
+// bits whether it lands in a vector body or a scalar tail (chunk seams
+// depend on this)
+inline float multiplyAdd(float a, float b, float c) {
+#if defined(__AVX2__)
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
+// acc[i] += weight * src[i]
+void accumulate(float* acc, const float* src, float weight, int count) {
+    int i = 0;
+#if defined(__AVX2__)
+    __m256 w = _mm256_set1_ps(weight);
+    for (; i + 8 <= count; i += 8) {
+        __m256 a = _mm256_loadu_ps(acc + i);
+        __m256 s = _mm256_loadu_ps(src + i);
+        _mm256_storeu_ps(acc + i, _mm256_fmadd_ps(s, w, a));
+    }
+#endif
+    for (; i < count; ++i) {
+        acc[i] = multiplyAdd(src[i], weight, acc[i]);
+    }
+}
+
+// out[i] = min/max(a[i], b[i])
+template<bool IsMin>
+void extremum(float* out, const float* a, const float* b, int count) {
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8) {
+        __m256 va = _mm256_loadu_ps(a + i);
+        __m256 vb = _mm256_loadu_ps(b + i);
+        _mm256_storeu_ps(out + i, IsMin ? _mm256_min_ps(va, vb) : _mm256_max_ps(va, vb));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = IsMin ? std::min(a[i], b[i]) : std::max(a[i], b[i]);
+    }
+}
+
+// Source taps of one resampled coordinate, indices clamped to the map
+struct ResampleTaps {
+    int index[4];
+    float weight[4];
+};
+
+// Taps for every destination coordinate; pixel centres aligned. Bilinear
+// uses the first two
+std::vector<ResampleTaps> resampleTaps(int srcCount, int dstCount, bool cubic) {
+    std::vector<ResampleTaps> taps(dstCount);
+    float ratio = static_cast<float>(srcCount) / dstCount;
+
+    for (int i = 0; i < dstCount; ++i) {
+        float position = std::clamp((i + 0.5f) * ratio - 0.5f, 0.0f, static_cast<float>(srcCount - 1));
+        int base = static_cast<int>(position);
+        float t = position - base;
+        ResampleTaps& tap = taps[i];
+
+        if (cubic) {
+            // Catmull-Rom
+            float t2 = t * t;
+            float t3 = t2 * t;
+            tap.weight[0] = -0.5f * t3 + t2 - 0.5f * t;
+            tap.weight[1] = 1.5f * t3 - 2.5f * t2 + 1.0f;
+            tap.weight[2] = -1.5f * t3 + 2.0f * t2 + 0.5f * t;
+            tap.weight[3] = 0.5f * t3 - 0.5f * t2;
+            for (int k = 0; k < 4; ++k) {
+                tap.index[k] = std::clamp(base - 1 + k, 0, srcCount - 1);
+            }
+        } else {
+            tap.weight[0] = 1.0f - t;
+            tap.weight[1] = t;
+            tap.weight[2] = tap.weight[3] = 0.0f;
+            tap.index[0] = base;
+            tap.index[1] = std::min(base + 1, srcCount - 1);
+            tap.index[2] = tap.index[3] = base;
+        }
+    }
+
+    return taps;
+}
+
+// Convolve one padded sequence (padded[i + k] for tap k) into out
+void convolveRow(const float* padded, float* out, int count,
+                 const std::vector<float>& kernel) {
+    std::fill(out, out + count, 0.0f);
+    for (size_t k = 0; k < kernel.size(); ++k) {
+        accumulate(out, padded + k, kernel[k], count);
+    }
+}
+
+// Copy a row into scratch with `radius` clamped pixels on both sides
+void padRow(const float* row, int width, int radius, std::vector<float>& padded) {
+    padded.resize(static_cast<size_t>(width) + 2 * radius);
+    std::fill(padded.begin(), padded.begin() + radius, row[0]);
+    std::memcpy(padded.data() + radius, row, width * sizeof(float));
+    std::fill(padded.begin() + radius + width, padded.end(), row[width - 1]);
+}
+
+std::vector<float> gaussianKernel(float sigma, int radius) {
+    std::vector<float> kernel(2 * radius + 1);
+    float sum = 0.0f;
+    for (int k = -radius; k <= radius; ++k) {
+        float w = std::exp(-(k * k) / (2.0f * sigma * sigma));
+        kernel[k + radius] = w;
+        sum += w;
+    }
+    for (float& w : kernel) {
+        w /= sum;
+    }
+    return kernel;
+}
+
+// Separable convolution with a symmetric normalized kernel
+void convolve(const HeightMap& src, HeightMap& dst,
+              const std::vector<float>& kernel, ThreadPool* pool) {
+    int width = src.getWidth();
+    int height = src.getHeight();
+    int radius = static_cast<int>(kernel.size() / 2);
+
+    HeightMap temp(width, height);
+    const float* in = src.getData();
+    float* mid = temp.getData();
+
+    forEach(pool, height, [&](size_t y) {
+        thread_local std::vector<float> padded;
+        padRow(in + y * width, width, radius, padded);
+        convolveRow(padded.data(), mid + y * width, width, kernel);
+    }, ROW_GRAIN);
+
+    // Vertical: each output row is a weighted sum of whole input rows
+    float* out = dst.getData();
+    forEach(pool, height, [&](size_t y) {
+        float* row = out + y * width;
+        std::fill(row, row + width, 0.0f);
+        for (int k = -radius; k <= radius; ++k) {
+            int sy = std::clamp(static_cast<int>(y) + k, 0, height - 1);
+            accumulate(row, mid + static_cast<size_t>(sy) * width, kernel[k + radius], width);
+        }
+    }, ROW_GRAIN);
+}
+
+// One box pass along rows (horizontal) with clamped edges
+void boxRows(const float* in, float* out, int width, int height,
+             int radius, ThreadPool* pool) {
+    float scale = 1.0f / (2 * radius + 1);
+    forEach(pool, height, [&](size_t y) {
+        thread_local std::vector<float> padded;
+        padRow(in + y * width, width, radius, padded);
+
+        // Double running sum: no drift across long rows
+        double sum = 0.0;
+        for (int k = 0; k <= 2 * radius; ++k) {
+            sum += padded[k];
+        }
+
+        float* row = out + y * width;
+        row[0] = static_cast<float>(sum) * scale;
+        for (int x = 1; x < width; ++x) {
+            sum += padded[x + 2 * radius] - padded[x - 1];
+            row[x] = static_cast<float>(sum) * scale;
+        }
+    }, ROW_GRAIN);
+}
+
+// One box pass down columns, strips of columns at a time
+void boxColumns(const float* in, float* out, int width, int height,
+                int radius, ThreadPool* pool) {
+    float scale = 1.0f / (2 * radius + 1);
+    int numStrips = (width + COLUMN_STRIP - 1) / COLUMN_STRIP;
+
+    forEach(pool, numStrips, [&](size_t strip) {
+        int x0 = static_cast<int>(strip) * COLUMN_STRIP;
+        int lanes = std::min(COLUMN_STRIP, width - x0);
+        double sums[COLUMN_STRIP];
+
+        auto rowAt = [&](int y) {
+            return in + static_cast<size_t>(std::clamp(y, 0, height - 1)) * width + x0;
+        };
+
+        for (int l = 0; l < lanes; ++l) {
+            sums[l] = 0.0;
+        }
+        for (int k = -radius; k <= radius; ++k) {
+            const float* row = rowAt(k);
+            for (int l = 0; l < lanes; ++l) {
+                sums[l] += row[l];
+            }
+        }
+
+        for (int y = 0; y < height; ++y) {
+            float* row = out + static_cast<size_t>(y) * width + x0;
+            for (int l = 0; l < lanes; ++l) {
+                row[l] = static_cast<float>(sums[l]) * scale;
+            }
+
+            const float* entering = rowAt(y + radius + 1);
+            const float* leaving = rowAt(y - radius);
+            for (int l = 0; l < lanes; ++l) {
+                sums[l] += entering[l] - leaving[l];
+            }
+        }
+    });
+}
+
+/**
+ * Running min/max over [i - radius, i + radius] for `lanes` sequences at
+ * once: element j of lane l is src[j * stride + l]. Out-of-range elements
+ * are the identity (+inf for min, -inf for max).
+ */
+template<bool IsMin>
+void runningExtremum(const float* src, float* dst,
+                     int length, int lanes, size_t stride,
+                     int radius, std::vector<float>& scratch) {
+    const float identity = IsMin ? std::numeric_limits<float>::infinity()
+                                 : -std::numeric_limits<float>::infinity();
+    const int window = 2 * radius + 1;
+    const int padded = length + 2 * radius;
+    const size_t laneBytes = static_cast<size_t>(lanes) * sizeof(float);
+
+    // p: padded input, g: prefix extremum within each block of `window`
+    // elements, h: suffix extremum within each block
+    size_t plane = static_cast<size_t>(padded) * lanes;
+    scratch.resize(plane * 3);
+    float* p = scratch.data();
+    float* g = p + plane;
+    float* h = g + plane;
+
+    std::fill(p, p + static_cast<size_t>(radius) * lanes, identity);
+    std::fill(p + static_cast<size_t>(radius + length) * lanes, p + plane, identity);
+    for (int i = 0; i < length; ++i) {
+        std::memcpy(p + static_cast<size_t>(i + radius) * lanes, src + i * stride, laneBytes);
+    }
+
+    for (int blockStart = 0; blockStart < padded; blockStart += window) {
+        int blockEnd = std::min(blockStart + window, padded);
+
+        std::memcpy(g + static_cast<size_t>(blockStart) * lanes,
+                    p + static_cast<size_t>(blockStart) * lanes, laneBytes);
+        for (int j = blockStart + 1; j < blockEnd; ++j) {
+            size_t at = static_cast<size_t>(j) * lanes;
+            extremum<IsMin>(g + at, g + at - lanes, p + at, lanes);
+        }
+
+        std::memcpy(h + static_cast<size_t>(blockEnd - 1) * lanes,
+                    p + static_cast<size_t>(blockEnd - 1) * lanes, laneBytes);
+        for (int j = blockEnd - 2; j >= blockStart; --j) {
+            size_t at = static_cast<size_t>(j) * lanes;
+            extremum<IsMin>(h + at, h + at + lanes, p + at, lanes);
+        }
+    }
+
+    // Window [i - radius, i + radius] is padded [i, i + 2 * radius]: one
+    // suffix and one prefix cover it whichever block boundary it straddles
+    for (int i = 0; i < length; ++i) {
+        extremum<IsMin>(dst + i * stride,
+                        h + static_cast<size_t>(i) * lanes,
+                        g + static_cast<size_t>(i + 2 * radius) * lanes, lanes);
+    }
+}
+
+template<bool IsMin>
+void extremumFilter(const HeightMap& src, HeightMap& dst, int radius, ThreadPool* pool) {
+    checkSize(src, dst);
+    if (radius <= 0) {
+        if (&src != &dst) src.copyTo(dst);
+        return;
+    }
+
+    int width = src.getWidth();
+    int height = src.getHeight();
+
+    HeightMap temp(width, height);
+    const float* in = src.getData();
+    float* mid = temp.getData();
+    float* out = dst.getData();
+
+    forEach(pool, height, [&](size_t y) {
+        thread_local std::vector<float> scratch;
+        runningExtremum<IsMin>(in + y * width, mid + y * width, width, 1, 1, radius, scratch);
+    }, ROW_GRAIN);
+
+    int numStrips = (width + COLUMN_STRIP - 1) / COLUMN_STRIP;
+    forEach(pool, numStrips, [&](size_t strip) {
+        thread_local std::vector<float> scratch;
+        int x0 = static_cast<int>(strip) * COLUMN_STRIP;
+        runningExtremum<IsMin>(mid + x0, out + x0, height, std::min(COLUMN_STRIP, width - x0),
+                               width, radius, scratch);
+    });
+}
+}
+
+void Filters::gaussianBlur(const HeightMap& src, HeightMap& dst,
+                           float sigma, ThreadPool* pool, int radius) {
+    checkSize(src, dst);
+    if (sigma <= 0.0f) {
+        if (&src != &dst) src.copyTo(dst);
+        return;
+    }
+
+    if (radius <= 0) {
+        radius = static_cast<int>(std::ceil(3.0f * sigma));
+    }
+
+    if (radius > MAX_DIRECT_RADIUS) {
+        boxGaussian(src, dst, sigma, pool);
+        return;
+    }
+
+    convolve(src, dst, gaussianKernel(sigma, radius), pool);
+}
+
+void Filters::boxBlur(const HeightMap& src, HeightMap& dst,
+                      int radius, ThreadPool* pool) {
+    checkSize(src, dst);
+    if (radius <= 0) {
+        if (&src != &dst) src.copyTo(dst);
+        return;
+    }
+
+    int width = src.getWidth();
+    int height = src.getHeight();
+
+    HeightMap temp(width, height);
+    boxRows(src.getData(), temp.getData(), width, height, radius, pool);
+    boxColumns(temp.getData(), dst.getData(), width, height, radius, pool);
+}
+
+void Filters::boxGaussian(const HeightMap& src, HeightMap& dst,
+                          float sigma, ThreadPool* pool, int passes) {
+    checkSize(src, dst);
+    if (sigma <= 0.0f || passes <= 0) {
+        if (&src != &dst) src.copyTo(dst);
+        return;
+    }
+
+    // Box widths whose summed variance matches sigma^2 (Kovesi 2010):
+    // the first m passes use width wl, the rest wl + 2
+    float ideal = std::sqrt(12.0f * sigma * sigma / passes + 1.0f);
+    int wl = static_cast<int>(std::floor(ideal));
+    if (wl % 2 == 0) wl--;
+    wl = std::max(1, wl);
+    int wu = wl + 2;
+    float mIdeal = (12.0f * sigma * sigma - passes * wl * wl - 4.0f * passes * wl - 3.0f * passes) /
+                   (-4.0f * wl - 4.0f);
+    int m = std::clamp(static_cast<int>(std::round(mIdeal)), 0, passes);
+
+    // One scratch map for all passes; rows land in temp, columns in dst
+    int width = src.getWidth();
+    int height = src.getHeight();
+    HeightMap temp(width, height);
+
+    const float* current = src.getData();
+    for (int pass = 0; pass < passes; ++pass) {
+        int boxWidth = pass < m ? wl : wu;
+        int radius = (boxWidth - 1) / 2;
+        if (radius == 0) continue;
+
+        boxRows(current, temp.getData(), width, height, radius, pool);
+        boxColumns(temp.getData(), dst.getData(), width, height, radius, pool);
+        current = dst.getData();
+    }
+
+    if (current != dst.getData()) {
+        src.copyTo(dst);
+    }
+}
+
+void Filters::minFilter(const HeightMap& src, HeightMap& dst,
+                        int radius, ThreadPool* pool) {
+    extremumFilter<true>(src, dst, radius, pool);
+}
+
+void Filters::maxFilter(const HeightMap& src, HeightMap& dst,
+                        int radius, ThreadPool* pool) {
+    extremumFilter<false>(src, dst, radius, pool);
+}
+
+void Filters::blend(HeightMap& target, const HeightMap& filtered,
+                    const HeightMap& weights, ThreadPool* pool) {
+    checkSize(target, filtered);
+    checkSize(target, weights);
+
+    int width = target.getWidth();
+    float* out = target.getData();
+    const float* in = filtered.getData();
+    const float* w = weights.getData();
+
+    forEach(pool, target.getHeight(), [&](size_t y) {
+        size_t offset = y * width;
+        int x = 0;
+#if defined(__AVX2__)
+        for (; x + 8 <= width; x += 8) {
+            __m256 t = _mm256_loadu_ps(out + offset + x);
+            __m256 f = _mm256_loadu_ps(in + offset + x);
+            __m256 wt = _mm256_loadu_ps(w + offset + x);
+            _mm256_storeu_ps(out + offset + x, _mm256_fmadd_ps(_mm256_sub_ps(f, t), wt, t));
+        }
+#endif
+        for (; x < width; ++x) {
+            size_t i = offset + x;
+            out[i] = multiplyAdd(in[i] - out[i], w[i], out[i]);
+        }
+    }, ROW_GRAIN * 4);
+}
+
+namespace {
+// Central differences for one row; writes gx/gy, or the magnitude when gy is null
+void differenceRow(const float* up, const float* row, const float* down,
+                   float* gx, float* gy, int width) {
+    auto scalar = [&](int x) {
+        float left = row[x > 0 ? x - 1 : 0];
+        float right = row[x < width - 1 ? x + 1 : width - 1];
+        float dx = (right - left) * 0.5f;
+        float dy = (down[x] - up[x]) * 0.5f;
+        if (gy) {
+            gx[x] = dx;
+            gy[x] = dy;
+        } else {
+            gx[x] = std::sqrt(dx * dx + dy * dy);
+        }
+    };
+
+    scalar(0);
+    int x = 1;
+#if defined(__AVX2__)
+    __m256 half = _mm256_set1_ps(0.5f);
+    for (; x + 8 < width; x += 8) {
+        __m256 dx = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(row + x + 1),
+                                                _mm256_loadu_ps(row + x - 1)), half);
+        __m256 dy = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(down + x),
+                                                _mm256_loadu_ps(up + x)), half);
+        if (gy) {
+            _mm256_storeu_ps(gx + x, dx);
+            _mm256_storeu_ps(gy + x, dy);
+        } else {
+            __m256 lengthSq = _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx));
+            _mm256_storeu_ps(gx + x, _mm256_sqrt_ps(lengthSq));
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        scalar(x);
+    }
+}
+
+void differences(const HeightMap& src, float* gx, float* gy, ThreadPool* pool) {
+    int width = src.getWidth();
+    int height = src.getHeight();
+    const float* data = src.getData();
+
+    forEach(pool, height, [&](size_t y) {
+        int yi = static_cast<int>(y);
+        const float* row = data + y * width;
+        const float* up = data + static_cast<size_t>(std::max(0, yi - 1)) * width;
+        const float* down = data + static_cast<size_t>(std::min(height - 1, yi + 1)) * width;
+        differenceRow(up, row, down, gx + y * width, gy ? gy + y * width : nullptr, width);
+    }, ROW_GRAIN * 4);
+}
+}
+
+void Filters::gradient(const HeightMap& src, HeightMap& gradX, HeightMap& gradY,
+                       ThreadPool* pool) {
+    checkSize(src, gradX);
+    checkSize(src, gradY);
+    if (&gradX == &src || &gradY == &src || &gradX == &gradY) {
+        throw std::invalid_argument("Filters::gradient: outputs may not alias");
+    }
+    differences(src, gradX.getData(), gradY.getData(), pool);
+}
+
+void Filters::slope(const HeightMap& src, HeightMap& dst, ThreadPool* pool) {
+    checkSize(src, dst);
+    if (&dst == &src) {
+        throw std::invalid_argument("Filters::slope: dst may not alias src");
+    }
+    differences(src, dst.getData(), nullptr, pool);
+}
+
+void Filters::resample(const HeightMap& src, HeightMap& dst, ThreadPool* pool,
+                       Interpolation interpolation) {
+    if (&dst == &src) {
+        throw std::invalid_argument("Filters::resample: dst may not alias src");
+    }
+
+    const int srcWidth = src.getWidth();
+    const int srcHeight = src.getHeight();
+    const int dstWidth = dst.getWidth();
+    const int dstHeight = dst.getHeight();
+
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        std::memcpy(dst.getData(), src.getData(), src.getSize() * sizeof(float));
+        return;
+    }
+
+    resampleRegion(src, dst, 0, 0, dstWidth, dstHeight, pool, interpolation);
+}
+
+void Filters::resampleRegion(const HeightMap& src, HeightMap& dst,
+                             int x, int y, int width, int height, ThreadPool* pool,
+                             Interpolation interpolation) {
+    if (&dst == &src) {
+        throw std::invalid_argument("Filters::resampleRegion: dst may not alias src");
+    }
+
+    const int srcWidth = src.getWidth();
+    const int srcHeight = src.getHeight();
+    const int dstWidth = dst.getWidth();
+    const int dstHeight = dst.getHeight();
+
+    int x0 = std::max(0, x);
+    int y0 = std::max(0, y);
+    int x1 = std::min(dstWidth, x + width);
+    int y1 = std::min(dstHeight, y + height);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        for (int row = y0; row < y1; ++row) {
+            const float* in = src.getData() + static_cast<size_t>(row) * srcWidth;
+            std::copy(in + x0, in + x1, dst.getData() + static_cast<size_t>(row) * dstWidth + x0);
+        }
+        return;
+    }
+
+    const bool cubic = interpolation == Interpolation::BICUBIC;
+    const int tapCount = cubic ? 4 : 2;
+    const std::vector<ResampleTaps> columns = resampleTaps(srcWidth, dstWidth, cubic);
+    const std::vector<ResampleTaps> rows = resampleTaps(srcHeight, dstHeight, cubic);
+
+    // Source columns the region's taps read; each one blends independently,
+    // so the rest of the row can be skipped without changing any sum
+    int srcX0 = srcWidth;
+    int srcX1 = 0;
+    for (int dx = x0; dx < x1; ++dx) {
+        for (int k = 0; k < tapCount; ++k) {
+            srcX0 = std::min(srcX0, columns[dx].index[k]);
+            srcX1 = std::max(srcX1, columns[dx].index[k] + 1);
+        }
+    }
+    const int span = srcX1 - srcX0;
+
+    forEach(pool, y1 - y0, [&](size_t i) {
+        thread_local std::vector<float> row;
+        row.assign(span, 0.0f);
+
+        int dy = y0 + static_cast<int>(i);
+        const ResampleTaps& rowTaps = rows[dy];
+        for (int k = 0; k < tapCount; ++k) {
+            const float* srcRow = src.getData() + static_cast<size_t>(rowTaps.index[k]) * srcWidth;
+            accumulate(row.data(), srcRow + srcX0, rowTaps.weight[k], span);
+        }
+
+        float* out = dst.getData() + static_cast<size_t>(dy) * dstWidth;
+        for (int dx = x0; dx < x1; ++dx) {
+            const ResampleTaps& taps = columns[dx];
+            float sum = 0.0f;
+            for (int k = 0; k < tapCount; ++k) {
+                sum = multiplyAdd(row[taps.index[k] - srcX0], taps.weight[k], sum);
+            }
+            out[dx] = sum;
+        }
+    }, ROW_GRAIN);
+}
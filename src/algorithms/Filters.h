@@ -0,0 +1,89 @@
+#pragma once
+
+#include "HeightMap.h"
+#include "ThreadPool.h"
+
+/**
+ * Filters - CPU image filters for heightmaps
+ *
+ * All filters are separable: a horizontal pass over rows and a vertical pass
+ * over rows of the intermediate (vectorized across the row), both split
+ * across the thread pool. Inner loops use AVX2 when the build enables it.
+ * Edges clamp (the border pixel repeats), matching the clamped-index loops
+ * these replace. Gradient and slope use central differences on the same
+ * clamped edges.
+ *
+ * src and dst may be the same map. pool may be null (single-threaded).
+ */
+class Filters {
+public:
+    /**
+     * Gaussian blur with precomputed weights
+     * @param radius Kernel half-width; <= 0 picks ceil(3 * sigma)
+     *
+     * Wide kernels (radius > MAX_DIRECT_RADIUS) switch to three box passes,
+     * which approximate the Gaussian at O(1) cost per pixel.
+     */
+    static void gaussianBlur(const HeightMap& src, HeightMap& dst,
+                             float sigma, ThreadPool* pool, int radius = 0);
+
+    // Mean over a (2 * radius + 1)^2 square, running sums: O(1) per pixel
+    static void boxBlur(const HeightMap& src, HeightMap& dst,
+                        int radius, ThreadPool* pool);
+
+    /**
+     * Gaussian approximation from repeated box blurs (Kovesi's box sizes)
+     * Cost doesn't depend on sigma.
+     */
+    static void boxGaussian(const HeightMap& src, HeightMap& dst,
+                            float sigma, ThreadPool* pool, int passes = 3);
+
+    /**
+     * Min / max over a (2 * radius + 1)^2 square (van Herk/Gil-Werman)
+     * Three comparisons per pixel and pass regardless of radius.
+     * +infinity inputs are ignored by minFilter, so callers can mask pixels.
+     */
+    static void minFilter(const HeightMap& src, HeightMap& dst,
+                          int radius, ThreadPool* pool);
+    static void maxFilter(const HeightMap& src, HeightMap& dst,
+                          int radius, ThreadPool* pool);
+
+    /**
+     * Masked blend: target += (filtered - target) * weights
+     * Weights of 0 leave target untouched, 1 takes the filtered value.
+     */
+    static void blend(HeightMap& target, const HeightMap& filtered,
+                      const HeightMap& weights, ThreadPool* pool);
+
+    /**
+     * Central-difference gradient: gradX = (right - left) / 2,
+     * gradY = (down - up) / 2, clamped at the border
+     */
+    static void gradient(const HeightMap& src, HeightMap& gradX, HeightMap& gradY,
+                         ThreadPool* pool);
+
+    // Gradient magnitude, the slope measure used by splatmaps and wetness
+    static void slope(const HeightMap& src, HeightMap& dst, ThreadPool* pool);
+
+    enum class Interpolation {
+        BILINEAR,
+        BICUBIC   // Catmull-Rom; sharper when enlarging, may overshoot slightly
+    };
+
+    /**
+     * Resample src onto dst's size, pixel centres aligned (the one filter
+     * here whose maps differ in size; dst may not alias src). Separable: a
+     * vertical pass blends source rows (vectorized), a horizontal pass
+     * gathers from precomputed taps.
+     */
+    static void resample(const HeightMap& src, HeightMap& dst, ThreadPool* pool,
+                         Interpolation interpolation = Interpolation::BILINEAR);
+
+    // resample() for the dst pixels in [x, x + width) x [y, y + height) only,
+    // with the same result there (for patching a copy after a local edit)
+    static void resampleRegion(const HeightMap& src, HeightMap& dst,
+                               int x, int y, int width, int height, ThreadPool* pool,
+                               Interpolation interpolation = Interpolation::BILINEAR);
+
+    static constexpr int MAX_DIRECT_RADIUS = 32;
+};
@@ -3,7 +3,8 @@
 #include <cmath>
 #include <algorithm>
 
-void HydraulicErosion::apply(HeightMap& heightMap, const Params& params, ThreadPool* pool, int iterations) {
+void HydraulicErosion::apply(HeightMap& heightMap, const Params& params, ThreadPool* pool, int iterations,
+                             ErosionMaps* maps) {
     int width = heightMap.getWidth();
     int height = heightMap.getHeight();
 
@@ -19,12 +20,15 @@ void HydraulicErosion::apply(HeightMap& heightMap, const Params& params, ThreadP
             float startX = distX(gen);
             float startY = distY(gen);
 
-            simulateDroplet(heightMap, params, startX, startY);
+            // Droplets run serially (each one reads the terrain the previous
+            // one carved), so the maps are accumulated directly
+            simulateDroplet(heightMap, params, startX, startY, maps);
         }
     }
 }
 
-void HydraulicErosion::simulateDroplet(HeightMap& heightMap, const Params& params, float startX, float startY) {
+void HydraulicErosion::simulateDroplet(HeightMap& heightMap, const Params& params, float startX, float startY,
+                                       ErosionMaps* maps) {
     float x = startX;
     float y = startY;
     float dirX = 0.0f;
@@ -46,6 +50,10 @@ void HydraulicErosion::simulateDroplet(HeightMap& heightMap, const Params& param
             break;
         }
 
+        if (maps) {
+            maps->flow.at(cellX, cellY) += water;
+        }
+
         // Calculate height and gradient
         float gradX, gradY;
         float currentHeight = calculateHeightAndGradient(heightMap, x, y, gradX, gradY);
@@ -87,12 +95,14 @@ void HydraulicErosion::simulateDroplet(HeightMap& heightMap, const Params& param
                 (sediment - capacity) * params.deposition_rate;
 
             sediment -= amountToDeposit;
-            depositAt(heightMap, x, y, amountToDeposit, params.erosion_radius);
+            depositAt(heightMap, x, y, amountToDeposit, params.erosion_radius,
+                      maps ? &maps->deposition : nullptr);
         } else {
             // Erode terrain
             float amountToErode = (std::min)((capacity - sediment) * params.erosion_rate, -deltaHeight);
 
-            erodeAt(heightMap, x, y, amountToErode, params.erosion_radius);
+            erodeAt(heightMap, x, y, amountToErode, params.erosion_radius,
+                    maps ? &maps->erosion : nullptr);
             sediment += amountToErode;
         }
 
@@ -140,7 +150,8 @@ float HydraulicErosion::calculateHeightAndGradient(const HeightMap& heightMap, f
     return interpolatedHeight;
 }
 
-void HydraulicErosion::erodeAt(HeightMap& heightMap, float x, float y, float amount, int radius) {
+void HydraulicErosion::erodeAt(HeightMap& heightMap, float x, float y, float amount, int radius,
+                               HeightMap* accumulation) {
     int width = heightMap.getWidth();
     int height = heightMap.getHeight();
 
@@ -163,13 +174,17 @@ void HydraulicErosion::erodeAt(HeightMap& heightMap, float x, float y, float amo
                     float erosion = amount * weight;
 
                     heightMap.at(nx, ny) -= erosion;
+                    if (accumulation) {
+                        accumulation->at(nx, ny) += erosion;
+                    }
                 }
             }
         }
     }
 }
 
-void HydraulicErosion::depositAt(HeightMap& heightMap, float x, float y, float amount, int radius) {
+void HydraulicErosion::depositAt(HeightMap& heightMap, float x, float y, float amount, int radius,
+                                 HeightMap* accumulation) {
     int width = heightMap.getWidth();
     int height = heightMap.getHeight();
 
@@ -192,6 +207,9 @@ void HydraulicErosion::depositAt(HeightMap& heightMap, float x, float y, float a
                     float deposition = amount * weight;
 
                     heightMap.at(nx, ny) += deposition;
+                    if (accumulation) {
+                        accumulation->at(nx, ny) += deposition;
+                    }
                 }
             }
         }
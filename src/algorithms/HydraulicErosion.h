@@ -2,6 +2,7 @@
 
 #include "../core/HeightMap.h"
 #include "../core/ThreadPool.h"
+#include "ErosionMaps.h"
 
 /**
  * HydraulicErosion
@@ -51,8 +52,10 @@ public:
      * @param params Erosion parameters
      * @param pool Thread pool for parallel processing (optional)
      * @param iterations Number of erosion passes (default 1)
+     * @param maps Optional flow/deposition/wear accumulation
      */
-    static void apply(HeightMap& heightMap, const Params& params, ThreadPool* pool = nullptr, int iterations = 1);
+    static void apply(HeightMap& heightMap, const Params& params, ThreadPool* pool = nullptr, int iterations = 1,
+                      ErosionMaps* maps = nullptr);
 
 private:
     /**
@@ -61,8 +64,10 @@ private:
      * @param heightMap Terrain heightmap
      * @param params Erosion parameters
      * @param startX, startY Starting position
+     * @param maps Optional by-product accumulation (may be null)
      */
-    static void simulateDroplet(HeightMap& heightMap, const Params& params, float startX, float startY);
+    static void simulateDroplet(HeightMap& heightMap, const Params& params, float startX, float startY,
+                                ErosionMaps* maps);
 
     /**
      * Calculate height and gradient at position (bilinear interpolation)
@@ -81,8 +86,10 @@ private:
      * @param x, y Position (can be fractional)
      * @param amount Erosion amount
      * @param radius Brush radius
+     * @param accumulation Optional per-cell record of removed material
      */
-    static void erodeAt(HeightMap& heightMap, float x, float y, float amount, int radius);
+    static void erodeAt(HeightMap& heightMap, float x, float y, float amount, int radius,
+                        HeightMap* accumulation);
 
     /**
      * Deposit sediment at position
@@ -91,6 +98,8 @@ private:
      * @param x, y Position (can be fractional)
      * @param amount Deposition amount
      * @param radius Brush radius
+     * @param accumulation Optional per-cell record of deposited material
      */
-    static void depositAt(HeightMap& heightMap, float x, float y, float amount, int radius);
+    static void depositAt(HeightMap& heightMap, float x, float y, float amount, int radius,
+                          HeightMap* accumulation);
 };
@@ -0,0 +1,490 @@
+#include "Hydrology.h"
+#include "Filters.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace {
+// Frontier size below which a wave is processed inline; tiny waves near the
+// end of long channels aren't worth a round trip through the pool
+constexpr size_t PARALLEL_WAVE_MIN = 4096;
+constexpr size_t WAVE_CHUNK = 1024;
+
+struct FloodCell {
+    float height;
+    int index;
+
+    // Min-heap on height; index breaks ties so the fill is deterministic
+    bool operator>(const FloodCell& other) const {
+        if (height != other.height) {
+            return height > other.height;
+        }
+        return index > other.index;
+    }
+};
+}
+
+void Hydrology::fillDepressions(const HeightMap& input, HeightMap& output, float epsilon) {
+    int width = input.getWidth();
+    int height = input.getHeight();
+
+    const float* in = input.getData();
+    float* out = output.getData();
+    size_t total = input.getSize();
+
+    std::vector<uint8_t> closed(total, 0);
+    std::priority_queue<FloodCell, std::vector<FloodCell>, std::greater<FloodCell>> open;
+    std::queue<int> pit;  // Cells inside a depression, all at their spill level
+
+    // Seed with the map border: water there can always leave the map
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (x != 0 && y != 0 && x != width - 1 && y != height - 1) {
+                continue;
+            }
+            int idx = y * width + x;
+            out[idx] = in[idx];
+            closed[idx] = 1;
+            open.push({in[idx], idx});
+        }
+    }
+
+    while (!open.empty() || !pit.empty()) {
+        int c;
+        if (!pit.empty()) {
+            c = pit.front();
+            pit.pop();
+        } else {
+            c = open.top().index;
+            open.pop();
+        }
+
+        int cx = c % width;
+        int cy = c / width;
+
+        // Lowest height a neighbor may have so it still drains into c
+        float spill = out[c];
+        if (epsilon > 0.0f) {
+            spill = out[c] + epsilon;
+            if (spill <= out[c]) {
+                spill = std::nextafter(out[c], std::numeric_limits<float>::infinity());
+            }
+        }
+
+        for (uint8_t n = 0; n < 8; ++n) {
+            int nx = cx + NEIGHBOR_DX[n];
+            int ny = cy + NEIGHBOR_DY[n];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
+                continue;
+            }
+
+            int ni = ny * width + nx;
+            if (closed[ni]) {
+                continue;
+            }
+            closed[ni] = 1;
+
+            if (in[ni] <= spill) {
+                // Inside a depression (or flat): raise to spill level
+                out[ni] = (epsilon > 0.0f) ? spill : out[c];
+                pit.push(ni);
+            } else {
+                out[ni] = in[ni];
+                open.push({in[ni], ni});
+            }
+        }
+    }
+}
+
+Hydrology::FlowDirections Hydrology::computeFlowDirections(const HeightMap& filled,
+                                                           FlowMethod method,
+                                                           ThreadPool* pool) {
+    FlowDirections directions;
+    directions.width = filled.getWidth();
+    directions.height = filled.getHeight();
+    directions.primary.assign(filled.getSize(), NO_FLOW);
+    directions.secondary.assign(filled.getSize(), NO_FLOW);
+    directions.primaryFraction.assign(filled.getSize(), 1.0f);
+
+    auto processRow = [&](size_t y) {
+        if (method == FlowMethod::DINF) {
+            computeDInf(filled, directions, static_cast<int>(y));
+        } else {
+            computeD8(filled, directions, static_cast<int>(y));
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, directions.height, processRow, 16);
+    } else {
+        for (int y = 0; y < directions.height; ++y) {
+            processRow(y);
+        }
+    }
+
+    return directions;
+}
+
+void Hydrology::computeD8(const HeightMap& filled, FlowDirections& directions, int y) {
+    int width = directions.width;
+    int height = directions.height;
+    const float* h = filled.getData();
+
+    for (int x = 0; x < width; ++x) {
+        size_t idx = static_cast<size_t>(y) * width + x;
+        float center = h[idx];
+
+        float bestSlope = 0.0f;
+        uint8_t best = NO_FLOW;
+
+        for (uint8_t n = 0; n < 8; ++n) {
+            int nx = x + NEIGHBOR_DX[n];
+            int ny = y + NEIGHBOR_DY[n];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
+                continue;
+            }
+
+            float slope = (center - h[static_cast<size_t>(ny) * width + nx]) / NEIGHBOR_DIST[n];
+            if (slope > bestSlope) {
+                bestSlope = slope;
+                best = n;
+            }
+        }
+
+        directions.primary[idx] = best;
+    }
+}
+
+void Hydrology::computeDInf(const HeightMap& filled, FlowDirections& directions, int y) {
+    int width = directions.width;
+    int height = directions.height;
+    const float* h = filled.getData();
+    const float quarterPi = 0.78539816f;
+
+    for (int x = 0; x < width; ++x) {
+        size_t idx = static_cast<size_t>(y) * width + x;
+        float e0 = h[idx];
+
+        float bestSlope = 0.0f;
+        float bestAngle = 0.0f;
+        uint8_t bestCardinal = NO_FLOW;
+        uint8_t bestDiagonal = NO_FLOW;
+
+        // Eight triangular facets, each spanned by a cardinal and a diagonal neighbor
+        for (uint8_t facet = 0; facet < 8; ++facet) {
+            uint8_t cardinal = (facet % 2 == 0) ? facet : static_cast<uint8_t>((facet + 1) & 7);
+            uint8_t diagonal = (facet % 2 == 0) ? static_cast<uint8_t>(facet + 1) : facet;
+
+            int x1 = x + NEIGHBOR_DX[cardinal];
+            int y1 = y + NEIGHBOR_DY[cardinal];
+            int x2 = x + NEIGHBOR_DX[diagonal];
+            int y2 = y + NEIGHBOR_DY[diagonal];
+            if (x1 < 0 || x1 >= width || y1 < 0 || y1 >= height ||
+                x2 < 0 || x2 >= width || y2 < 0 || y2 >= height) {
+                continue;
+            }
+
+            float e1 = h[static_cast<size_t>(y1) * width + x1];
+            float e2 = h[static_cast<size_t>(y2) * width + x2];
+
+            float s1 = e0 - e1;
+            float s2 = e1 - e2;
+            float angle = std::atan2(s2, s1);
+            float slope = std::sqrt(s1 * s1 + s2 * s2);
+
+            // Clamp the steepest direction to the facet
+            if (angle < 0.0f) {
+                angle = 0.0f;
+                slope = s1;
+            } else if (angle > quarterPi) {
+                angle = quarterPi;
+                slope = (e0 - e2) / NEIGHBOR_DIST[diagonal];
+            }
+
+            if (slope > bestSlope) {
+                bestSlope = slope;
+                bestAngle = angle;
+                bestCardinal = cardinal;
+                bestDiagonal = diagonal;
+            }
+        }
+
+        if (bestCardinal == NO_FLOW) {
+            continue;  // Outlet or flat
+        }
+
+        float diagonalShare = bestAngle / quarterPi;
+        if (diagonalShare <= 0.0f) {
+            directions.primary[idx] = bestCardinal;
+        } else if (diagonalShare >= 1.0f) {
+            directions.primary[idx] = bestDiagonal;
+        } else {
+            directions.primary[idx] = bestCardinal;
+            directions.secondary[idx] = bestDiagonal;
+            directions.primaryFraction[idx] = 1.0f - diagonalShare;
+        }
+    }
+}
+
+float Hydrology::flowFraction(const FlowDirections& directions, size_t index, uint8_t toward) {
+    if (directions.primary[index] == toward) {
+        return directions.primaryFraction[index];
+    }
+    if (directions.secondary[index] == toward) {
+        return 1.0f - directions.primaryFraction[index];
+    }
+    return 0.0f;
+}
+
+void Hydrology::accumulateFlow(const FlowDirections& directions,
+                               HeightMap& accumulation,
+                               ThreadPool* pool,
+                               const HeightMap* weights) {
+    int width = directions.width;
+    int height = directions.height;
+    size_t total = static_cast<size_t>(width) * height;
+
+    float* acc = accumulation.getData();
+    const float* runoff = weights ? weights->getData() : nullptr;
+
+    // Wave in which each cell was finalized; donors always finish in an
+    // earlier wave than their receivers
+    const int NOT_DONE = -1;
+    std::vector<int> doneWave(total, NOT_DONE);
+
+    // Visit every donor of cell (x, y): neighbors whose flow points back at it
+    auto forEachDonor = [&](int x, int y, auto&& fn) {
+        for (uint8_t n = 0; n < 8; ++n) {
+            int nx = x + NEIGHBOR_DX[n];
+            int ny = y + NEIGHBOR_DY[n];
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
+                continue;
+            }
+            size_t ni = static_cast<size_t>(ny) * width + nx;
+            float fraction = flowFraction(directions, ni, opposite(n));
+            if (fraction > 0.0f) {
+                fn(ni, fraction);
+            }
+        }
+    };
+
+    // Initial frontier: cells nothing flows into (ridges, peaks)
+    std::vector<int> frontier;
+    {
+        std::vector<std::vector<int>> rowSources(height);
+        auto findSources = [&](size_t y) {
+            int yi = static_cast<int>(y);
+            for (int x = 0; x < width; ++x) {
+                bool hasDonor = false;
+                forEachDonor(x, yi, [&](size_t, float) { hasDonor = true; });
+                if (!hasDonor) {
+                    rowSources[y].push_back(yi * width + x);
+                }
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor(0, height, findSources, 16);
+        } else {
+            for (int y = 0; y < height; ++y) {
+                findSources(y);
+            }
+        }
+
+        for (const auto& row : rowSources) {
+            frontier.insert(frontier.end(), row.begin(), row.end());
+        }
+    }
+
+    std::vector<std::vector<int>> chunkNext;
+    int wave = 0;
+
+    while (!frontier.empty()) {
+        size_t numChunks = (frontier.size() + WAVE_CHUNK - 1) / WAVE_CHUNK;
+        bool parallel = pool && frontier.size() >= PARALLEL_WAVE_MIN;
+
+        // Phase 1: finalize frontier cells by pulling from (finished) donors
+        auto finalize = [&](size_t chunk) {
+            size_t begin = chunk * WAVE_CHUNK;
+            size_t end = std::min(frontier.size(), begin + WAVE_CHUNK);
+            for (size_t i = begin; i < end; ++i) {
+                int c = frontier[i];
+                float sum = runoff ? runoff[c] : 1.0f;
+                forEachDonor(c % width, c / width, [&](size_t donor, float fraction) {
+                    sum += acc[donor] * fraction;
+                });
+                acc[c] = sum;
+                doneWave[c] = wave;
+            }
+        };
+
+        // Phase 2: receivers whose donors are now all finished form the next
+        // wave. Only the lowest-index donor finished in this wave adds a
+        // receiver, so each one is queued exactly once.
+        chunkNext.assign(numChunks, {});
+        auto advance = [&](size_t chunk) {
+            size_t begin = chunk * WAVE_CHUNK;
+            size_t end = std::min(frontier.size(), begin + WAVE_CHUNK);
+            std::vector<int>& next = chunkNext[chunk];
+
+            for (size_t i = begin; i < end; ++i) {
+                int c = frontier[i];
+                const uint8_t receivers[2] = {directions.primary[c], directions.secondary[c]};
+
+                for (uint8_t code : receivers) {
+                    if (code == NO_FLOW) {
+                        continue;
+                    }
+                    int rx = c % width + NEIGHBOR_DX[code];
+                    int ry = c / width + NEIGHBOR_DY[code];
+                    int r = ry * width + rx;
+
+                    bool ready = true;
+                    int firstThisWave = std::numeric_limits<int>::max();
+                    forEachDonor(rx, ry, [&](size_t donor, float) {
+                        if (doneWave[donor] == NOT_DONE) {
+                            ready = false;
+                        } else if (doneWave[donor] == wave) {
+                            firstThisWave = std::min(firstThisWave, static_cast<int>(donor));
+                        }
+                    });
+
+                    if (ready && firstThisWave == c) {
+                        next.push_back(r);
+                    }
+                }
+            }
+        };
+
+        if (parallel) {
+            pool->parallelFor(0, numChunks, finalize);
+            pool->parallelFor(0, numChunks, advance);
+        } else {
+            for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+                finalize(chunk);
+            }
+            for (size_t chunk = 0; chunk < numChunks; ++chunk) {
+                advance(chunk);
+            }
+        }
+
+        frontier.clear();
+        for (const auto& next : chunkNext) {
+            frontier.insert(frontier.end(), next.begin(), next.end());
+        }
+        ++wave;
+    }
+}
+
+Hydrology::Analysis Hydrology::analyze(const HeightMap& map,
+                                       ThreadPool* pool,
+                                       FlowMethod method,
+                                       float epsilon) {
+    Analysis analysis(map.getWidth(), map.getHeight());
+
+    fillDepressions(map, analysis.filled, epsilon);
+    analysis.directions = computeFlowDirections(analysis.filled, method, pool);
+    accumulateFlow(analysis.directions, analysis.accumulation, pool);
+
+    return analysis;
+}
+
+HeightMap Hydrology::wetnessIndex(const HeightMap& filled,
+                                  const HeightMap& accumulation,
+                                  ThreadPool* pool) {
+    int width = filled.getWidth();
+    int height = filled.getHeight();
+    HeightMap wetness(width, height);
+
+    // Slope first (vectorized), then ln(a / slope) in place
+    Filters::slope(filled, wetness, pool);
+
+    const float minSlope = 1e-4f;  // Keeps flats finite
+    float* wet = wetness.getData();
+    const float* acc = accumulation.getData();
+
+    auto processRow = [&](size_t y) {
+        size_t rowOffset = y * width;
+        for (int x = 0; x < width; ++x) {
+            size_t idx = rowOffset + x;
+            wet[idx] = std::log(acc[idx] / std::max(minSlope, wet[idx]));
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, height, processRow, 16);
+    } else {
+        for (int y = 0; y < height; ++y) {
+            processRow(y);
+        }
+    }
+
+    wetness.normalize();
+    return wetness;
+}
+
+std::vector<std::vector<int>> Hydrology::extractChannels(const FlowDirections& directions,
+                                                         const HeightMap& accumulation,
+                                                         float threshold,
+                                                         int minLength) {
+    int width = directions.width;
+    int height = directions.height;
+    const float* acc = accumulation.getData();
+
+    // Heads: over threshold, but no donor over threshold
+    std::vector<int> heads;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int idx = y * width + x;
+            if (acc[idx] < threshold) {
+                continue;
+            }
+
+            bool hasChannelDonor = false;
+            for (uint8_t n = 0; n < 8 && !hasChannelDonor; ++n) {
+                int nx = x + NEIGHBOR_DX[n];
+                int ny = y + NEIGHBOR_DY[n];
+                if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
+                    continue;
+                }
+                int ni = ny * width + nx;
+                if (directions.primary[ni] == opposite(n) && acc[ni] >= threshold) {
+                    hasChannelDonor = true;
+                }
+            }
+
+            if (!hasChannelDonor) {
+                heads.push_back(idx);
+            }
+        }
+    }
+
+    std::vector<uint8_t> visited(directions.primary.size(), 0);
+    std::vector<std::vector<int>> channels;
+
+    for (int head : heads) {
+        std::vector<int> channel;
+        int c = head;
+
+        while (true) {
+            channel.push_back(c);
+            if (visited[c]) {
+                break;  // Joined an existing channel
+            }
+            visited[c] = 1;
+
+            uint8_t code = directions.primary[c];
+            if (code == NO_FLOW) {
+                break;  // Outlet
+            }
+            c = (c / width + NEIGHBOR_DY[code]) * width + (c % width + NEIGHBOR_DX[code]);
+        }
+
+        if (static_cast<int>(channel.size()) >= minLength) {
+            channels.push_back(std::move(channel));
+        }
+    }
+
+    return channels;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../core/HeightMap.h"
+#include "../core/ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Hydrology - Drainage analysis for rivers, wetlands and splatmaps
+ *
+ * Pipeline:
+ * 1. fillDepressions: Priority-Flood (Barnes et al. 2014) raises pits to
+ *    their spill level in O(n log n). With epsilon > 0 every cell keeps a
+ *    strictly lower neighbor, so flats and filled pits still drain.
+ * 2. computeFlowDirections: D8 (steepest of 8 neighbors) or D-infinity
+ *    (Tarboton 1997, flow split between the two cells of the steepest facet)
+ * 3. accumulateFlow: Contributing area per cell, evaluated in topological
+ *    waves (sources first) so each wave runs in parallel without atomics
+ *
+ * Neighbor codes run counter-clockwise from east:
+ * 0=E, 1=NE, 2=N, 3=NW, 4=W, 5=SW, 6=S, 7=SE (y grows downward)
+ */
+class Hydrology {
+public:
+    static constexpr uint8_t NO_FLOW = 0xFF;  // Outlet: drains off-map or nowhere
+
+    enum class FlowMethod {
+        D8,     // Single receiver, good for channel tracing
+        DINF    // Up to two receivers, smoother dispersion on hillslopes
+    };
+
+    struct FlowDirections {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> primary;         // Receiver neighbor code or NO_FLOW
+        std::vector<uint8_t> secondary;       // Second receiver (D-inf only) or NO_FLOW
+        std::vector<float> primaryFraction;   // Share of flow sent to primary (1.0 for D8)
+    };
+
+    // Full analysis result, convenient for callers that need everything
+    struct Analysis {
+        HeightMap filled;
+        FlowDirections directions;
+        HeightMap accumulation;  // Contributing area in cells (>= 1)
+
+        Analysis(int width, int height)
+            : filled(width, height), accumulation(width, height) {}
+    };
+
+    /**
+     * Fill depressions with Priority-Flood
+     * @param input Terrain heights
+     * @param output Filled heights (same size, may not alias input)
+     * @param epsilon 0 = flat fill; > 0 = minimum rise per cell across filled areas
+     */
+    static void fillDepressions(const HeightMap& input, HeightMap& output, float epsilon = 0.0f);
+
+    /**
+     * Compute flow directions on a (filled) heightmap
+     */
+    static FlowDirections computeFlowDirections(const HeightMap& filled,
+                                                FlowMethod method,
+                                                ThreadPool* pool);
+
+    /**
+     * Accumulate flow along directions
+     * @param weights Optional per-cell runoff (defaults to 1 per cell)
+     */
+    static void accumulateFlow(const FlowDirections& directions,
+                               HeightMap& accumulation,
+                               ThreadPool* pool,
+                               const HeightMap* weights = nullptr);
+
+    /**
+     * Fill (epsilon), D8 directions and accumulation in one call
+     */
+    static Analysis analyze(const HeightMap& map,
+                            ThreadPool* pool,
+                            FlowMethod method = FlowMethod::D8,
+                            float epsilon = 1e-5f);
+
+    /**
+     * Topographic wetness index ln(a / tan(slope)), normalized to 0-1
+     * High values mark valley floors and wet ground (wetlands, splatmaps)
+     */
+    static HeightMap wetnessIndex(const HeightMap& filled,
+                                  const HeightMap& accumulation,
+                                  ThreadPool* pool);
+
+    /**
+     * Trace channels where accumulation reaches threshold
+     *
+     * Each channel runs from a head (first cell over threshold) downstream
+     * along primary receivers, ending at an outlet or where it joins a
+     * channel traced earlier (the junction cell is included).
+     *
+     * @return Cell indices (y * width + x) per channel, upstream first
+     */
+    static std::vector<std::vector<int>> extractChannels(const FlowDirections& directions,
+                                                         const HeightMap& accumulation,
+                                                         float threshold,
+                                                         int minLength = 8);
+
+    static int offsetX(uint8_t code) { return NEIGHBOR_DX[code]; }
+    static int offsetY(uint8_t code) { return NEIGHBOR_DY[code]; }
+
+private:
+    static constexpr int NEIGHBOR_DX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+    static constexpr int NEIGHBOR_DY[8] = {0, -1, -1, -1, 0, 1, 1, 1};
+    static constexpr float NEIGHBOR_DIST[8] = {1.0f, 1.41421356f, 1.0f, 1.41421356f,
+                                               1.0f, 1.41421356f, 1.0f, 1.41421356f};
+
+    // Code of the neighbor that points back (E <-> W etc.)
+    static uint8_t opposite(uint8_t code) { return static_cast<uint8_t>((code + 4) & 7); }
+
+    // Fraction of flow cell (x, y) sends toward neighbor code toward, 0 if none
+    static float flowFraction(const FlowDirections& directions, size_t index, uint8_t toward);
+
+    static void computeD8(const HeightMap& filled, FlowDirections& directions, int y);
+    static void computeDInf(const HeightMap& filled, FlowDirections& directions, int y);
+};
@@ -12,6 +12,11 @@ public:
                        uint32_t seed,
                        ThreadPool* pool);
 
+    // Peaks for one row in place, for passes that fuse several stages per row
+    // row[i] is world pixel (xStart + i, y); peakNoise: PerlinNoise(seed), built once per pass
+    static void applyRow(float* row, int xStart, int y, int width, float intensity,
+                         const PerlinNoise& peakNoise);
+
 private:
     static float ridgedNoise(const PerlinNoise& noise, float x, float y);
 };
@@ -0,0 +1,138 @@
+#include "PolylineRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void PolylineRasterizer::rasterize(int width,
+                                   int height,
+                                   const std::vector<Vertex>& path,
+                                   ThreadPool* pool,
+                                   const RowFunction& apply) {
+    if (path.empty() || width <= 0 || height <= 0) return;
+
+    // A single vertex is a zero-length segment (a disc)
+    size_t numSegments = std::max<size_t>(1, path.size() - 1);
+    auto segmentStart = [&](size_t s) -> const Vertex& { return path[s]; };
+    auto segmentEnd = [&](size_t s) -> const Vertex& { return path[std::min(s + 1, path.size() - 1)]; };
+
+    // Bin segments by the row bands their capsule touches
+    int numBands = (height + BAND_ROWS - 1) / BAND_ROWS;
+    std::vector<std::vector<int>> bandSegments(numBands);
+    int firstBand = numBands;
+    int lastBand = -1;
+
+    for (size_t s = 0; s < numSegments; ++s) {
+        const Vertex& a = segmentStart(s);
+        const Vertex& b = segmentEnd(s);
+        float r = std::max(a.radius, b.radius);
+        if (r <= 0.0f) continue;
+
+        float minY = std::min(a.pos.y, b.pos.y) - r;
+        float maxY = std::max(a.pos.y, b.pos.y) + r;
+        int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+        int y1 = std::min(height - 1, static_cast<int>(std::ceil(maxY)));
+        if (y0 > y1) continue;
+
+        for (int band = y0 / BAND_ROWS; band <= y1 / BAND_ROWS; ++band) {
+            bandSegments[band].push_back(static_cast<int>(s));
+        }
+        firstBand = std::min(firstBand, y0 / BAND_ROWS);
+        lastBand = std::max(lastBand, y1 / BAND_ROWS);
+    }
+
+    if (lastBand < firstBand) return;
+
+    const float inf = std::numeric_limits<float>::infinity();
+
+    auto processBand = [&](size_t bandIndex) {
+        int band = firstBand + static_cast<int>(bandIndex);
+        const auto& segments = bandSegments[band];
+        if (segments.empty()) return;
+
+        // Best normalized distance (distance / radius) per column
+        std::vector<float> best(width, inf);
+        std::vector<Sample> samples(width, Sample{inf, 0.0f, 0.0f});
+
+        int rowStart = band * BAND_ROWS;
+        int rowEnd = std::min(height, rowStart + BAND_ROWS);
+
+        for (int y = rowStart; y < rowEnd; ++y) {
+            float py = static_cast<float>(y);
+            int spanStart = width;
+            int spanEnd = 0;
+
+            for (int s : segments) {
+                const Vertex& a = segmentStart(s);
+                const Vertex& b = segmentEnd(s);
+                float r = std::max(a.radius, b.radius);
+
+                // Columns where this segment's capsule can reach row y
+                glm::vec2 ab = b.pos - a.pos;
+                float tMin = 0.0f;
+                float tMax = 1.0f;
+                if (std::abs(ab.y) > 1e-6f) {
+                    float t0 = (py - r - a.pos.y) / ab.y;
+                    float t1 = (py + r - a.pos.y) / ab.y;
+                    tMin = std::max(0.0f, std::min(t0, t1));
+                    tMax = std::min(1.0f, std::max(t0, t1));
+                    if (tMin > tMax) continue;
+                } else if (std::abs(py - a.pos.y) > r) {
+                    continue;
+                }
+
+                float xa = a.pos.x + ab.x * tMin;
+                float xb = a.pos.x + ab.x * tMax;
+                int x0 = std::max(0, static_cast<int>(std::floor(std::min(xa, xb) - r)));
+                int x1 = std::min(width - 1, static_cast<int>(std::ceil(std::max(xa, xb) + r)));
+                if (x0 > x1) continue;
+
+                float lengthSq = glm::dot(ab, ab);
+                float invLengthSq = lengthSq > 0.0f ? 1.0f / lengthSq : 0.0f;
+
+                for (int x = x0; x <= x1; ++x) {
+                    glm::vec2 ap(static_cast<float>(x) - a.pos.x, py - a.pos.y);
+                    float t = std::clamp(glm::dot(ap, ab) * invLengthSq, 0.0f, 1.0f);
+                    glm::vec2 offset = ap - ab * t;
+                    float distance = std::sqrt(glm::dot(offset, offset));
+                    float radius = a.radius + (b.radius - a.radius) * t;
+                    if (distance >= radius) continue;
+
+                    float score = distance / radius;
+                    if (score < best[x]) {
+                        best[x] = score;
+                        samples[x] = Sample{distance, radius, a.depth + (b.depth - a.depth) * t};
+                    }
+                }
+
+                spanStart = std::min(spanStart, x0);
+                spanEnd = std::max(spanEnd, x1 + 1);
+            }
+
+            if (spanStart >= spanEnd) continue;
+
+            apply(y, spanStart, spanEnd, samples.data() + spanStart);
+
+            std::fill(best.begin() + spanStart, best.begin() + spanEnd, inf);
+            std::fill(samples.begin() + spanStart, samples.begin() + spanEnd, Sample{inf, 0.0f, 0.0f});
+        }
+    };
+
+    size_t bandCount = static_cast<size_t>(lastBand - firstBand + 1);
+    if (pool) {
+        pool->parallelFor(0, bandCount, processBand, 1);
+    } else {
+        for (size_t band = 0; band < bandCount; ++band) {
+            processBand(band);
+        }
+    }
+}
+
+float PolylineRasterizer::averageSpacing(const std::vector<Vertex>& path) {
+    if (path.size() < 2) return 1.0f;
+
+    float length = 0.0f;
+    for (size_t i = 1; i < path.size(); ++i) {
+        length += glm::distance(path[i - 1].pos, path[i].pos);
+    }
+    return std::max(1.0f, length / static_cast<float>(path.size() - 1));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * PolylineRasterizer - Per-pixel distance to a variable-width polyline
+ *
+ * Path carving used to stamp a disc every few pixels along the path, so
+ * cost grew with path length * width^2 and overlapping stamps hit the same
+ * pixel many times. The rasterizer instead visits each pixel inside the
+ * path's band once, finds the nearest segment (relative to its width) and
+ * reports the distance plus width and depth interpolated along it.
+ *
+ * Segments are binned into fixed row bands, bands run in parallel, and each
+ * row only scans the x-span where a segment's capsule crosses it.
+ */
+class PolylineRasterizer {
+public:
+    struct Vertex {
+        glm::vec2 pos;
+        float radius;  // Half width in pixels
+        float depth;   // Caller-defined strength, interpolated like radius
+    };
+
+    struct Sample {
+        float distance;  // Pixels to the nearest point on the path
+        float radius;    // Interpolated radius at that point
+        float depth;     // Interpolated depth at that point
+        bool inside() const { return distance < radius; }
+    };
+
+    /**
+     * Called once per row that the path touches, with samples for columns
+     * [x0, x1). Samples outside every segment have inside() == false.
+     * Rows may be delivered concurrently, but each row exactly once.
+     */
+    using RowFunction = std::function<void(int y, int x0, int x1, const Sample* samples)>;
+
+    static void rasterize(int width,
+                          int height,
+                          const std::vector<Vertex>& path,
+                          ThreadPool* pool,
+                          const RowFunction& apply);
+
+    // Average distance between consecutive vertices (the old stamp spacing)
+    static float averageSpacing(const std::vector<Vertex>& path);
+
+private:
+    static constexpr int BAND_ROWS = 16;  // Rows per parallel band
+};
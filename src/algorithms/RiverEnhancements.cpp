@@ -1,392 +1,341 @@
 #include "RiverEnhancements.h"
+#include "DistanceTransform.h"
+#include "PolylineRasterizer.h"
+#include "SweptProfile.h"
 #include <algorithm>
 #include <cmath>
-#include <random>
 
 void RiverEnhancements::apply(HeightMap& heightMap, const Params& params, ThreadPool* pool) {
-    (void)pool;  // Reserved for future parallel implementation
-
     if (params.intensity < 0.01f) return;
 
+    int width = heightMap.getWidth();
+    int height = heightMap.getHeight();
+
     int numRivers = static_cast<int>(params.intensity * 6) + 2;  // 2-8 main rivers
 
-    // Calculate flow field for gradient-based rivers
-    FlowField flowField = calculateFlowField(heightMap);
+    Hydrology::Analysis hydrology = Hydrology::analyze(heightMap, pool);
 
-    // Find river sources and destinations
-    auto sources = findRiverSources(heightMap, numRivers);
-    auto destinations = findRiverDestinations(heightMap, numRivers);
+    // Channels start where 1% of the map drains through a cell
+    float threshold = static_cast<float>(width) * height * 0.01f;
+    int minLength = std::max(8, width / 32);
+    auto channels = Hydrology::extractChannels(
+        hydrology.directions, hydrology.accumulation, threshold, minLength);
 
-    // Ensure we have at least some rivers
-    size_t riverCount = std::min(sources.size(), destinations.size());
+    auto sources = findRiverSources(heightMap, channels, numRivers);
 
+    // owner[cell] = river id + 1, so rivers stop where they meet an earlier one
+    std::vector<int> owner(static_cast<size_t>(width) * height, 0);
     std::vector<RiverPath> allRivers;
 
-    // Generate main rivers
-    for (size_t i = 0; i < riverCount; ++i) {
-        RiverPath mainRiver = generateFlowBasedRiver(
-            heightMap, flowField,
-            sources[i], destinations[i],
-            params);
+    // Main rivers run from their source all the way to the outlet
+    for (int source : sources) {
+        RiverPath mainRiver = traceRiver(hydrology, source, static_cast<int>(allRivers.size()) + 1,
+                                         owner, threshold, params.width);
         mainRiver.isMain = true;
-        allRivers.push_back(mainRiver);
-
-        // Generate tributaries for this main river
-        if (params.enableTributaries && mainRiver.points.size() > 10) {
-            // Branch points at 25%, 50%, 75% along main river
-            std::vector<float> branchPositions = {0.25f, 0.5f, 0.75f};
-
-            for (int t = 0; t < params.tributariesPerRiver && t < static_cast<int>(branchPositions.size()); ++t) {
-                size_t branchIdx = static_cast<size_t>(mainRiver.points.size() * branchPositions[t]);
-                if (branchIdx >= mainRiver.points.size()) branchIdx = mainRiver.points.size() - 1;
-
-                RiverPath tributary = generateTributary(
-                    heightMap, flowField,
-                    mainRiver.points[branchIdx].pos,
-                    params);
-                tributary.isMain = false;
-                allRivers.push_back(tributary);
+        if (mainRiver.points.size() >= 2) {
+            allRivers.push_back(std::move(mainRiver));
+        }
+    }
+
+    // Tributaries: channels that drain into a main river, longest first
+    if (params.enableTributaries) {
+        size_t mainCount = allRivers.size();
+        std::vector<const std::vector<int>*> byLength;
+        for (const auto& channel : channels) {
+            byLength.push_back(&channel);
+        }
+        std::stable_sort(byLength.begin(), byLength.end(),
+            [](const std::vector<int>* a, const std::vector<int>* b) {
+                return a->size() > b->size();
+            });
+
+        std::vector<int> tributaryCount(mainCount, 0);
+        for (const auto* channel : byLength) {
+            int head = channel->front();
+            if (owner[head] != 0) continue;  // Part of an existing river
+
+            // Follow drainage to the first river cell below the head
+            int junction = 0;
+            for (int cell = head; cell >= 0 && junction == 0; ) {
+                junction = owner[cell];
+                uint8_t code = hydrology.directions.primary[cell];
+                if (code == Hydrology::NO_FLOW) break;
+                cell += Hydrology::offsetY(code) * width + Hydrology::offsetX(code);
+            }
+            if (junction < 1 || junction > static_cast<int>(mainCount)) continue;
+            if (tributaryCount[junction - 1] >= params.tributariesPerRiver) continue;
+
+            RiverPath tributary = traceRiver(hydrology, head, static_cast<int>(allRivers.size()) + 1,
+                                             owner, threshold, params.width * params.tributaryWidth);
+            tributary.isMain = false;
+            if (tributary.points.size() >= 2) {
+                tributaryCount[junction - 1]++;
+                allRivers.push_back(std::move(tributary));
             }
         }
     }
 
+    for (auto& river : allRivers) {
+        if (!params.useGradientFlow) {
+            // Straight line from source to outlet at the original 2 px step
+            glm::vec2 start = river.points.front().pos;
+            glm::vec2 end = river.points.back().pos;
+            RiverPoint first = river.points.front();
+            RiverPoint last = river.points.back();
+            int steps = std::max(1, static_cast<int>(glm::distance(start, end) / 2.0f));
+
+            river.points.clear();
+            for (int i = 0; i <= steps; ++i) {
+                float t = static_cast<float>(i) / steps;
+                RiverPoint point;
+                point.pos = glm::mix(start, end, t);
+                point.width = first.width + (last.width - first.width) * t;
+                point.depth = first.depth + (last.depth - first.depth) * t;
+                river.points.push_back(point);
+            }
+        } else {
+            smoothPath(river, params.flowSmoothing);
+        }
+    }
+
     // Carve all rivers
     for (const auto& river : allRivers) {
         float riverIntensity = river.isMain ? params.intensity : params.intensity * 0.5f;
-        carveRiverPath(heightMap, river, riverIntensity);
+        carveRiverPath(heightMap, river, riverIntensity, pool);
     }
 
     // Apply wetlands
     if (params.enableWetlands) {
-        for (const auto& river : allRivers) {
-            if (river.isMain) {  // Only main rivers create wetlands
-                applyWetlands(heightMap, river, params);
-            }
-        }
+        HeightMap wetness = Hydrology::wetnessIndex(hydrology.filled, hydrology.accumulation, pool);
+        applyWetlands(heightMap, allRivers, wetness, params, pool);
     }
 }
 
-RiverEnhancements::FlowField RiverEnhancements::calculateFlowField(const HeightMap& map) {
-    int width = map.getWidth();
-    int height = map.getHeight();
-
-    FlowField field(width, height);
-
-    // Calculate gradient at each point
-    for (int y = 1; y < height - 1; ++y) {
-        for (int x = 1; x < width - 1; ++x) {
-            // Central difference for gradient
-            float gradX = (map.at(x + 1, y) - map.at(x - 1, y)) * 0.5f;
-            float gradY = (map.at(x, y + 1) - map.at(x, y - 1)) * 0.5f;
-
-            // Flow direction is negative gradient (downhill)
-            glm::vec2 flowDir(-gradX, -gradY);
-
-            // Normalize
-            float len = glm::length(flowDir);
-            if (len > 0.0001f) {
-                flowDir /= len;
-            }
-
-            field.at(x, y) = flowDir;
-        }
-    }
-
-    return field;
-}
-
-RiverEnhancements::RiverPath RiverEnhancements::generateFlowBasedRiver(
-    const HeightMap& map,
-    const FlowField& flowField,
-    const glm::vec2& start,
-    const glm::vec2& target,
-    const Params& params) {
+RiverEnhancements::RiverPath RiverEnhancements::traceRiver(
+    const Hydrology::Analysis& hydrology,
+    int sourceCell,
+    int riverId,
+    std::vector<int>& owner,
+    float threshold,
+    float width) {
 
     RiverPath path;
     path.isMain = true;
 
-    glm::vec2 currentPos = start;
-    glm::vec2 currentDir(0.0f);
-
-    const int maxSteps = 2000;
-    const float stepSize = 2.0f;
-    const float targetRadius = 15.0f;
+    const auto& directions = hydrology.directions;
+    const float* accumulation = hydrology.accumulation.getData();
+    int mapWidth = directions.width;
 
-    for (int step = 0; step < maxSteps; ++step) {
-        // Add current point to path
-        RiverPoint point;
-        point.pos = currentPos;
-        point.width = params.width;
-        point.depth = 0.5f + (static_cast<float>(step) / maxSteps) * 0.5f;  // Depth increases
-        path.points.push_back(point);
+    // Full depth once the river drains 16x the channel threshold
+    float fullFlow = threshold * 16.0f;
 
-        // Check if reached target
-        if (glm::distance(currentPos, target) < targetRadius) {
-            break;
+    // D8 cells are 1-1.4 px apart; keep every other one for the original 2 px step
+    int cell = sourceCell;
+    for (int step = 0; cell >= 0; ++step) {
+        bool junction = owner[cell] != 0;
+        if (!junction) {
+            owner[cell] = riverId;
         }
 
-        // Get flow direction at current position
-        int x = static_cast<int>(currentPos.x);
-        int y = static_cast<int>(currentPos.y);
+        if (step % 2 == 0 || junction) {
+            float flow = std::min(1.0f, accumulation[cell] / fullFlow);
 
-        if (x < 1 || x >= map.getWidth() - 1 || y < 1 || y >= map.getHeight() - 1) {
-            break;  // Out of bounds
+            RiverPoint point;
+            point.pos = glm::vec2(static_cast<float>(cell % mapWidth), static_cast<float>(cell / mapWidth));
+            point.width = width;
+            point.depth = 0.5f + 0.5f * flow;  // Depth increases downstream
+            path.points.push_back(point);
         }
 
-        glm::vec2 flowDir = flowField.at(x, y);
-
-        // Direction toward target
-        glm::vec2 targetDir = glm::normalize(target - currentPos);
-
-        // Blend flow direction with target direction
-        glm::vec2 desiredDir = glm::normalize(flowDir * 0.3f + targetDir * 0.7f);
+        if (junction) break;
 
-        // Apply inertia (smooth direction changes)
-        currentDir = glm::normalize(currentDir * params.flowSmoothing + desiredDir * (1.0f - params.flowSmoothing));
+        uint8_t code = directions.primary[cell];
+        if (code == Hydrology::NO_FLOW) break;
 
-        // Move to next position
-        currentPos += currentDir * stepSize;
-
-        // Clamp to map bounds
-        currentPos.x = std::clamp(currentPos.x, 1.0f, static_cast<float>(map.getWidth() - 2));
-        currentPos.y = std::clamp(currentPos.y, 1.0f, static_cast<float>(map.getHeight() - 2));
+        int x = cell % mapWidth + Hydrology::offsetX(code);
+        int y = cell / mapWidth + Hydrology::offsetY(code);
+        cell = y * mapWidth + x;
     }
 
-    // Smooth the path
-    smoothPath(path, 0.5f);
-
     return path;
 }
 
-RiverEnhancements::RiverPath RiverEnhancements::generateTributary(
-    const HeightMap& map,
-    const FlowField& flowField,
-    const glm::vec2& branchPoint,
-    const Params& params) {
-
-    RiverPath tributary;
-    tributary.isMain = false;
-
-    // Find a spawn point perpendicular to main river
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> angleDist(-1.57f, 1.57f);  // -90° to +90°
-
-    float angle = angleDist(gen);
-    float spawnDist = 100.0f;
-
-    glm::vec2 tributaryStart = branchPoint + glm::vec2(
-        std::cos(angle) * spawnDist,
-        std::sin(angle) * spawnDist);
-
-    // Clamp to map
-    tributaryStart.x = std::clamp(tributaryStart.x, 1.0f, static_cast<float>(map.getWidth() - 2));
-    tributaryStart.y = std::clamp(tributaryStart.y, 1.0f, static_cast<float>(map.getHeight() - 2));
-
-    // Flow from tributary start to branch point
-    Params tributaryParams = params;
-    tributaryParams.width *= params.tributaryWidth;
-
-    tributary = generateFlowBasedRiver(map, flowField, tributaryStart, branchPoint, tributaryParams);
-    tributary.isMain = false;
-
-    return tributary;
-}
-
 void RiverEnhancements::carveRiverPath(
     HeightMap& map,
     const RiverPath& path,
-    float intensity) {
+    float intensity,
+    ThreadPool* pool) {
 
-    int mapWidth = map.getWidth();
-    int mapHeight = map.getHeight();
+    if (path.points.empty()) return;
 
+    std::vector<PolylineRasterizer::Vertex> vertices;
+    vertices.reserve(path.points.size());
     for (const auto& point : path.points) {
-        int cx = static_cast<int>(point.pos.x);
-        int cy = static_cast<int>(point.pos.y);
-
         float radius = point.width * 800.0f;  // Convert to pixels
-        int iRadius = static_cast<int>(std::max(2.0f, radius));
-
-        for (int dy = -iRadius; dy <= iRadius; ++dy) {
-            for (int dx = -iRadius; dx <= iRadius; ++dx) {
-                int x = cx + dx;
-                int y = cy + dy;
+        vertices.push_back({point.pos, radius, point.depth});
+    }
 
-                if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight) continue;
+    // Smooth falloff from center, summed as if stamped at the path's point spacing
+    static const SweptProfile profile([](float r) { return std::pow(1.0f - r, 1.8f); });
+    float spacing = PolylineRasterizer::averageSpacing(vertices);
 
-                float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
-                if (dist > radius) continue;
+    int mapWidth = map.getWidth();
+    float* data = map.getData();
 
-                // Smooth falloff from center
-                float falloff = std::pow(1.0f - (dist / radius), 1.8f);
+    PolylineRasterizer::rasterize(mapWidth, map.getHeight(), vertices, pool,
+        [&](int y, int x0, int x1, const PolylineRasterizer::Sample* samples) {
+            float* row = data + static_cast<size_t>(y) * mapWidth;
+            for (int x = x0; x < x1; ++x) {
+                const auto& sample = samples[x - x0];
+                if (!sample.inside()) continue;
 
                 // Carve based on intensity and depth
-                float carvingAmount = intensity * 0.12f * falloff * point.depth;
+                float carvingAmount = intensity * 0.12f * sample.depth *
+                                      profile.swept(sample.distance, sample.radius, spacing);
 
                 // Lower the terrain (create river channel)
-                map.at(x, y) = std::max(0.0f, map.at(x, y) - carvingAmount);
+                row[x] = std::max(0.0f, row[x] - carvingAmount);
             }
-        }
-    }
+        });
 }
 
 void RiverEnhancements::applyWetlands(
     HeightMap& map,
-    const RiverPath& path,
-    const Params& params) {
+    const std::vector<RiverPath>& rivers,
+    const HeightMap& wetness,
+    const Params& params,
+    ThreadPool* pool) {
 
     int mapWidth = map.getWidth();
     int mapHeight = map.getHeight();
 
     const float wetlandRadius = params.wetlandRadius;
     const float wetlandStrength = params.wetlandStrength;
+    if (wetlandRadius <= 0.0f) return;
+
+    // Only main rivers create wetlands
+    std::vector<uint8_t> mask(map.getSize(), 0);
+    bool any = false;
+    for (const auto& river : rivers) {
+        if (river.isMain) {
+            rasterizePath(river, mask, mapWidth, mapHeight);
+            any = true;
+        }
+    }
+    if (!any) return;
 
-    // For each point on the river, create moisture zone
-    for (const auto& point : path.points) {
-        int cx = static_cast<int>(point.pos.x);
-        int cy = static_cast<int>(point.pos.y);
+    HeightMap distance(mapWidth, mapHeight);
+    DistanceTransform::compute(mask, distance, pool);
 
-        int iRadius = static_cast<int>(wetlandRadius);
+    // Squared falloff from river to dry land, at the strength the former
+    // per-point stamps (one every 2 px) added up to along the river
+    static const SweptProfile profile([](float r) { return (1.0f - r) * (1.0f - r); });
 
-        for (int dy = -iRadius; dy <= iRadius; ++dy) {
-            for (int dx = -iRadius; dx <= iRadius; ++dx) {
-                int x = cx + dx;
-                int y = cy + dy;
+    float* data = map.getData();
+    const float* dist = distance.getData();
+    const float* wet = wetness.getData();
 
-                if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight) continue;
+    auto processRow = [&](size_t y) {
+        size_t rowOffset = y * mapWidth;
+        for (int x = 0; x < mapWidth; ++x) {
+            size_t idx = rowOffset + x;
+            if (dist[idx] >= wetlandRadius) continue;
 
-                float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
-                if (dist > wetlandRadius) continue;
+            float moistureFactor = profile.swept(dist[idx], wetlandRadius, 2.0f);
 
-                // Smooth gradient from river to dry land
-                float moistureFactor = 1.0f - (dist / wetlandRadius);
-                moistureFactor = moistureFactor * moistureFactor;  // Squared falloff
+            // Flat, convergent ground stays marshy; slopes drain and stay dry
+            moistureFactor *= 0.5f + wet[idx];
 
-                // Slightly lower wetland areas (marshy depression)
-                float lowering = wetlandStrength * 0.02f * moistureFactor;
+            // Slightly lower wetland areas (marshy depression)
+            float lowering = wetlandStrength * 0.02f * moistureFactor;
 
-                map.at(x, y) = std::max(0.0f, map.at(x, y) - lowering);
-            }
+            data[idx] = std::max(0.0f, data[idx] - lowering);
+        }
+    };
+
+    if (pool) {
+        pool->parallelFor(0, mapHeight, processRow, 16);
+    } else {
+        for (int y = 0; y < mapHeight; ++y) {
+            processRow(y);
         }
     }
 }
 
-std::vector<glm::vec2> RiverEnhancements::findRiverSources(
-    const HeightMap& map,
-    int numRivers) {
-
-    std::vector<glm::vec2> sources;
-
-    int width = map.getWidth();
-    int height = map.getHeight();
-
-    // Find high-elevation edge points (mountain springs)
-    std::vector<glm::vec2> candidates;
-
-    // Sample edges
-    const int step = 20;
+void RiverEnhancements::rasterizePath(
+    const RiverPath& path,
+    std::vector<uint8_t>& mask,
+    int width,
+    int height) {
 
-    // Top and bottom edges
-    for (int x = 0; x < width; x += step) {
-        candidates.push_back(glm::vec2(x, 0));
-        candidates.push_back(glm::vec2(x, height - 1));
-    }
+    auto plot = [&](int x, int y) {
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            mask[static_cast<size_t>(y) * width + x] = 1;
+        }
+    };
 
-    // Left and right edges
-    for (int y = 0; y < height; y += step) {
-        candidates.push_back(glm::vec2(0, y));
-        candidates.push_back(glm::vec2(width - 1, y));
+    if (path.points.size() == 1) {
+        plot(static_cast<int>(path.points[0].pos.x), static_cast<int>(path.points[0].pos.y));
     }
 
-    // Sort by elevation (prefer higher elevations as sources)
-    std::sort(candidates.begin(), candidates.end(),
-        [&map](const glm::vec2& a, const glm::vec2& b) {
-            int ax = static_cast<int>(a.x);
-            int ay = static_cast<int>(a.y);
-            int bx = static_cast<int>(b.x);
-            int by = static_cast<int>(b.y);
-            return map.at(ax, ay) > map.at(bx, by);
-        });
-
-    // Select well-spaced sources
-    float minSpacing = width * 0.25f;
-
-    for (const auto& candidate : candidates) {
-        if (sources.size() >= static_cast<size_t>(numRivers)) break;
+    for (size_t i = 1; i < path.points.size(); ++i) {
+        glm::vec2 a = path.points[i - 1].pos;
+        glm::vec2 b = path.points[i].pos;
+        int steps = std::max(1, static_cast<int>(std::ceil(std::max(std::abs(b.x - a.x), std::abs(b.y - a.y)))));
 
-        // Check spacing
-        bool tooClose = false;
-        for (const auto& existing : sources) {
-            if (glm::distance(candidate, existing) < minSpacing) {
-                tooClose = true;
-                break;
-            }
-        }
-
-        if (!tooClose) {
-            sources.push_back(candidate);
+        for (int s = 0; s <= steps; ++s) {
+            glm::vec2 p = glm::mix(a, b, static_cast<float>(s) / steps);
+            plot(static_cast<int>(p.x), static_cast<int>(p.y));
         }
     }
-
-    return sources;
 }
 
-std::vector<glm::vec2> RiverEnhancements::findRiverDestinations(
+std::vector<int> RiverEnhancements::findRiverSources(
     const HeightMap& map,
+    const std::vector<std::vector<int>>& channels,
     int numRivers) {
 
-    std::vector<glm::vec2> destinations;
+    std::vector<int> sources;
 
     int width = map.getWidth();
-    int height = map.getHeight();
-
-    // Find lowest valleys
-    std::vector<glm::vec2> valleys;
+    const float* data = map.getData();
 
-    const int margin = static_cast<int>(width * 0.15f);
-    const int step = 8;
-
-    for (int y = margin; y < height - margin; y += step) {
-        for (int x = margin; x < width - margin; x += step) {
-            float h = map.at(x, y);
-
-            if (h < 0.35f) {  // Low elevation
-                valleys.push_back(glm::vec2(x, y));
-            }
-        }
+    // Channel heads are where enough water gathers to form a stream
+    std::vector<int> candidates;
+    for (const auto& channel : channels) {
+        candidates.push_back(channel.front());
     }
 
-    // Sort by elevation (lowest first)
-    std::sort(valleys.begin(), valleys.end(),
-        [&map](const glm::vec2& a, const glm::vec2& b) {
-            int ax = static_cast<int>(a.x);
-            int ay = static_cast<int>(a.y);
-            int bx = static_cast<int>(b.x);
-            int by = static_cast<int>(b.y);
-            return map.at(ax, ay) < map.at(bx, by);
+    // Sort by elevation (prefer higher elevations as sources)
+    std::stable_sort(candidates.begin(), candidates.end(),
+        [data](int a, int b) {
+            return data[a] > data[b];
         });
 
-    // Select well-spaced destinations
-    float minSpacing = width * 0.2f;
+    // Select well-spaced sources
+    float minSpacing = width * 0.25f;
+
+    for (int candidate : candidates) {
+        if (sources.size() >= static_cast<size_t>(numRivers)) break;
 
-    for (const auto& valley : valleys) {
-        if (destinations.size() >= static_cast<size_t>(numRivers)) break;
+        glm::vec2 pos(static_cast<float>(candidate % width), static_cast<float>(candidate / width));
 
+        // Check spacing
         bool tooClose = false;
-        for (const auto& existing : destinations) {
-            if (glm::distance(valley, existing) < minSpacing) {
+        for (int existing : sources) {
+            glm::vec2 other(static_cast<float>(existing % width), static_cast<float>(existing / width));
+            if (glm::distance(pos, other) < minSpacing) {
                 tooClose = true;
                 break;
             }
         }
 
         if (!tooClose) {
-            destinations.push_back(valley);
+            sources.push_back(candidate);
         }
     }
 
-    return destinations;
+    return sources;
 }
 
 void RiverEnhancements::smoothPath(RiverPath& path, float amount) {
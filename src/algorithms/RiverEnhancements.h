@@ -2,6 +2,8 @@
 
 #include "HeightMap.h"
 #include "ThreadPool.h"
+#include "Hydrology.h"
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -9,9 +11,9 @@
  * River Enhancements (Phase 2)
  *
  * Advanced river generation with:
- * - Realistic flow following terrain gradients
- * - Tributary generation (branching streams)
- * - Wetland zones around rivers
+ * - Rivers traced along D8 drainage from high channel heads to the outlet
+ * - Tributary generation (channels joining a main river)
+ * - Wetland zones around rivers, strongest where the wetness index is high
  */
 class RiverEnhancements {
 public:
@@ -21,8 +23,8 @@ public:
         float width = 0.03f;             // Base river width
 
         // Flow algorithm
-        bool useGradientFlow = true;     // Follow terrain gradients (vs straight lines)
-        float flowSmoothing = 0.3f;      // Direction smoothing (0-1)
+        bool useGradientFlow = true;     // Follow drainage (vs straight source-to-outlet lines)
+        float flowSmoothing = 0.3f;      // Path smoothing (0-1), softens D8 stair-steps
 
         // Tributaries
         bool enableTributaries = true;   // Generate branching streams
@@ -52,62 +54,43 @@ private:
         bool isMain;          // Main river vs tributary
     };
 
-    // Flow field for gradient-based pathfinding
-    struct FlowField {
-        std::vector<glm::vec2> directions;  // Flow direction at each pixel
-        int width, height;
-
-        FlowField(int w, int h) : width(w), height(h) {
-            directions.resize(w * h, glm::vec2(0.0f));
-        }
-
-        glm::vec2& at(int x, int y) {
-            return directions[y * width + x];
-        }
-
-        const glm::vec2& at(int x, int y) const {
-            return directions[y * width + x];
-        }
-    };
-
-    // Calculate flow directions based on terrain gradient
-    static FlowField calculateFlowField(const HeightMap& map);
-
-    // Generate river path following flow field
-    static RiverPath generateFlowBasedRiver(
-        const HeightMap& map,
-        const FlowField& flowField,
-        const glm::vec2& start,
-        const glm::vec2& target,
-        const Params& params);
-
-    // Generate tributary starting from point on main river
-    static RiverPath generateTributary(
-        const HeightMap& map,
-        const FlowField& flowField,
-        const glm::vec2& branchPoint,
-        const Params& params);
-
-    // Carve river path into heightmap
+    // Follow D8 receivers from a source cell until an outlet or a cell
+    // already claimed by another river (the junction is included).
+    // Claims visited cells with riverId.
+    static RiverPath traceRiver(
+        const Hydrology::Analysis& hydrology,
+        int sourceCell,
+        int riverId,
+        std::vector<int>& owner,
+        float threshold,
+        float width);
+
+    // Carve river path in one pass over its distance field
     static void carveRiverPath(
         HeightMap& map,
         const RiverPath& path,
-        float intensity);
+        float intensity,
+        ThreadPool* pool);
 
-    // Apply wetland effect around river
+    // Apply wetland effect around main rivers, scaled by wetness index
     static void applyWetlands(
         HeightMap& map,
-        const RiverPath& path,
-        const Params& params);
+        const std::vector<RiverPath>& rivers,
+        const HeightMap& wetness,
+        const Params& params,
+        ThreadPool* pool);
 
-    // Find spawn points for rivers (map edges + high elevation springs)
-    static std::vector<glm::vec2> findRiverSources(
-        const HeightMap& map,
-        int numRivers);
+    // Mark the pixels along a path (segments between consecutive points)
+    static void rasterizePath(
+        const RiverPath& path,
+        std::vector<uint8_t>& mask,
+        int width,
+        int height);
 
-    // Find river destinations (lowest valleys)
-    static std::vector<glm::vec2> findRiverDestinations(
+    // Pick well-spaced channel heads, highest first (mountain springs)
+    static std::vector<int> findRiverSources(
         const HeightMap& map,
+        const std::vector<std::vector<int>>& channels,
         int numRivers);
 
     // Smooth river path to remove sharp turns
@@ -1,4 +1,7 @@
 #include "Rivers.h"
+#include "Hydrology.h"
+#include "DistanceTransform.h"
+#include "SweptProfile.h"
 #include <algorithm>
 #include <cmath>
 
@@ -6,179 +9,92 @@ void Rivers::execute(HeightMap& map,
                     float intensity,
                     float width,
                     ThreadPool* pool) {
-    (void)pool;  // Unused - reserved for future parallel implementation
-
     if (intensity < 0.01f) return;
 
-    // Number of rivers based on intensity (3-11 rivers)
-    int numRivers = static_cast<int>(intensity * 8) + 3;
-
-    // Find lowest valley areas as destinations
-    auto valleyTargets = findLowestValleys(map, numRivers);
-
-    // Create rivers from edges to these valleys
-    for (const auto& target : valleyTargets) {
-        createRiverFromEdge(map, target, intensity, width);
-    }
-}
-
-std::vector<Rivers::Point> Rivers::findLowestValleys(
-    const HeightMap& map, int count) {
-
-    std::vector<Point> valleys;
-
-    int width = map.getWidth();
-    int height = map.getHeight();
-
-    // Sample interior points (not near edges)
-    int margin = static_cast<int>(width * 0.15f);
-    const int step = 8;  // Sample every 8th pixel for performance
-
-    for (int y = margin; y < height - margin; y += step) {
-        for (int x = margin; x < width - margin; x += step) {
-            float h = map.at(x, y);
-
-            // Look for low elevation areas (valleys)
-            if (h < 0.35f) {
-                valleys.push_back({x, y, h});
-            }
-        }
-    }
-
-    // Sort by elevation (lowest first)
-    std::sort(valleys.begin(), valleys.end(),
-        [](const Point& a, const Point& b) { return a.height < b.height; });
-
-    // Select valleys that are spread out
-    std::vector<Point> selectedValleys;
-    float minSpacing = width * 0.2f;  // Minimum 20% of map width apart
+    Hydrology::Analysis hydrology = Hydrology::analyze(map, pool);
 
-    for (const auto& valley : valleys) {
-        if (selectedValleys.size() >= static_cast<size_t>(count)) break;
+    // Channel threshold as a share of map area draining through a cell:
+    // 2% at low intensity down to 0.5% at full intensity (denser network)
+    float area = static_cast<float>(map.getWidth()) * map.getHeight();
+    float threshold = area * (0.02f - 0.015f * intensity);
 
-        // Check if far enough from already selected valleys
-        bool tooClose = false;
-        for (const auto& selected : selectedValleys) {
-            float dx = static_cast<float>(valley.x - selected.x);
-            float dy = static_cast<float>(valley.y - selected.y);
-            float dist = std::sqrt(dx * dx + dy * dy);
-
-            if (dist < minSpacing) {
-                tooClose = true;
-                break;
-            }
-        }
-
-        if (!tooClose) {
-            selectedValleys.push_back(valley);
-        }
-    }
+    int minLength = std::max(8, map.getWidth() / 32);
+    auto channels = Hydrology::extractChannels(
+        hydrology.directions, hydrology.accumulation, threshold, minLength);
 
-    return selectedValleys;
+    carveChannels(map, channels, hydrology.accumulation, threshold, intensity, width, pool);
 }
 
-void Rivers::createRiverFromEdge(
+void Rivers::carveChannels(
     HeightMap& map,
-    const Point& target,
+    const std::vector<std::vector<int>>& channels,
+    const HeightMap& accumulation,
+    float threshold,
     float intensity,
-    float width) {
+    float riverWidth,
+    ThreadPool* pool) {
+
+    if (channels.empty()) return;
 
     int mapWidth = map.getWidth();
     int mapHeight = map.getHeight();
-
-    // Find closest edge point to this valley
-    std::vector<Point> edges = {
-        {0, target.y, 0.0f},                    // Left edge
-        {mapWidth - 1, target.y, 0.0f},        // Right edge
-        {target.x, 0, 0.0f},                   // Top edge
-        {target.x, mapHeight - 1, 0.0f}        // Bottom edge
-    };
-
-    // Find nearest edge
-    Point closestEdge = edges[0];
-    float minDist = std::numeric_limits<float>::infinity();
-
-    for (const auto& edge : edges) {
-        float dx = static_cast<float>(edge.x - target.x);
-        float dy = static_cast<float>(edge.y - target.y);
-        float dist = std::sqrt(dx * dx + dy * dy);
-
-        if (dist < minDist) {
-            minDist = dist;
-            closestEdge = edge;
-        }
-    }
-
-    // Create river path from edge to valley
-    carveRiverPath(map, closestEdge, target, intensity, width);
-}
-
-void Rivers::carveRiverPath(
-    HeightMap& map,
-    const Point& start,
-    const Point& end,
-    float intensity,
-    float riverWidth) {
-
-    float dx = static_cast<float>(end.x - start.x);
-    float dy = static_cast<float>(end.y - start.y);
-    float distance = std::sqrt(dx * dx + dy * dy);
-
-    int steps = static_cast<int>(distance / 2.0f);
-    if (steps < 2) return;
-
+    size_t size = map.getSize();
     float baseWidth = riverWidth * 800.0f;  // Convert to pixels
 
-    for (int i = 0; i <= steps; ++i) {
-        float t = static_cast<float>(i) / steps;
+    // Rivers reach full width and depth once they drain 16x the threshold area
+    float fullFlow = threshold * 16.0f;
 
-        // Smooth interpolation (smoothstep)
-        float smoothT = t * t * (3.0f - 2.0f * t);
+    // Each channel cell remembers its own width and depth (a cell shared
+    // by several channels keeps the widest)
+    std::vector<float> cellRadius(size, 0.0f);
+    std::vector<float> cellDepth(size, 0.0f);
+    const float* flowData = accumulation.getData();
 
-        int x = static_cast<int>(start.x + dx * smoothT);
-        int y = static_cast<int>(start.y + dy * smoothT);
+    for (const auto& channel : channels) {
+        for (int cell : channel) {
+            float flow = std::min(1.0f, flowData[cell] / fullFlow);
 
-        // Width stays relatively consistent (90-100%)
-        float width = baseWidth * (0.9f + t * 0.1f);
-
-        // Depth increases as river approaches valley
-        float depth = 0.5f + t * 0.5f;  // 50% to 100%
-
-        carveRiverSegment(map, x, y, width, depth, intensity);
+            // Narrow headwaters widen toward the main stem
+            cellRadius[cell] = std::max(cellRadius[cell], baseWidth * (0.4f + 0.6f * std::sqrt(flow)));
+            cellDepth[cell] = std::max(cellDepth[cell], 0.5f + 0.5f * flow);
+        }
     }
-}
-
-void Rivers::carveRiverSegment(
-    HeightMap& map,
-    int cx, int cy,
-    float radius,
-    float depth,
-    float intensity) {
-
-    int mapWidth = map.getWidth();
-    int mapHeight = map.getHeight();
-
-    int iRadius = static_cast<int>(std::max(2.0f, radius));
 
-    for (int dy = -iRadius; dy <= iRadius; ++dy) {
-        for (int dx = -iRadius; dx <= iRadius; ++dx) {
-            int x = cx + dx;
-            int y = cy + dy;
-
-            // Bounds check
-            if (x < 0 || x >= mapWidth || y < 0 || y >= mapHeight) continue;
-
-            float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
-            if (dist > radius) continue;
-
-            // Smooth falloff from center
-            float falloff = std::pow(1.0f - (dist / radius), 1.8f);
-
-            // Carve based on intensity and depth
-            float carvingAmount = intensity * 0.12f * falloff * depth;
+    // One power transform picks, per pixel, the channel cell whose disc
+    // covers it most deeply (largest r^2 - d^2), so a wide trunk keeps its
+    // full cross-section where a narrow tributary runs close by
+    HeightMap power(mapWidth, mapHeight);
+    std::vector<int> nearest;
+    DistanceTransform::computePower(cellRadius, power, pool, &nearest);
+
+    // Same cross-section the old disc stamps (falloff^1.8, every 2 px)
+    // summed to, applied once per pixel
+    static const SweptProfile profile([](float r) { return std::pow(1.0f - r, 1.8f); });
+
+    float* data = map.getData();
+    const float* powerData = power.getData();
+
+    auto carveRow = [&](size_t y) {
+        size_t rowOffset = y * mapWidth;
+        for (int x = 0; x < mapWidth; ++x) {
+            size_t idx = rowOffset + x;
+            if (powerData[idx] >= 0.0f) continue;  // Outside every channel disc
+
+            int cell = nearest[idx];
+            float radius = cellRadius[cell];
+            float dist = std::sqrt(std::max(0.0f, powerData[idx] + radius * radius));
+
+            float carvingAmount = intensity * 0.12f * cellDepth[cell] *
+                                  profile.swept(dist, radius, CARVE_SPACING);
+            data[idx] = std::max(0.0f, data[idx] - carvingAmount);
+        }
+    };
 
-            // Lower the terrain (create river channel)
-            map.at(x, y) = std::max(0.0f, map.at(x, y) - carvingAmount);
+    if (pool) {
+        pool->parallelFor(0, mapHeight, carveRow, 16);
+    } else {
+        for (int y = 0; y < mapHeight; ++y) {
+            carveRow(y);
         }
     }
 }
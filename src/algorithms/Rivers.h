@@ -4,7 +4,8 @@
 #include "ThreadPool.h"
 #include <vector>
 
-// Rivers flow from map edges into lowest valleys using straight-line paths
+// Rivers follow the drainage network: channels start where flow accumulation
+// crosses a threshold and run downhill to the map edge or a larger river
 class Rivers {
 public:
     static void execute(HeightMap& map,
@@ -13,31 +14,17 @@ public:
                        ThreadPool* pool);
 
 private:
-    struct Point {
-        int x, y;
-        float height;
-    };
+    static constexpr float CARVE_SPACING = 2.0f;  // Stamp spacing the carve depth is calibrated to
 
-    static std::vector<Point> findLowestValleys(
-        const HeightMap& map, int count);
-
-    static void createRiverFromEdge(
-        HeightMap& map,
-        const Point& target,
-        float intensity,
-        float width);
-
-    static void carveRiverPath(
+    // Carve all channels in one pass over a power distance field of channel
+    // cells; width and depth follow the cell whose disc covers a pixel most
+    // deeply, so a wide trunk isn't notched by a nearby narrow tributary
+    static void carveChannels(
         HeightMap& map,
-        const Point& start,
-        const Point& end,
+        const std::vector<std::vector<int>>& channels,
+        const HeightMap& accumulation,
+        float threshold,
         float intensity,
-        float width);
-
-    static void carveRiverSegment(
-        HeightMap& map,
-        int cx, int cy,
-        float radius,
-        float depth,
-        float intensity);
+        float width,
+        ThreadPool* pool);
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * SweptProfile - Cross-section of a radial stamp dragged along a path
+ *
+ * Carving used to stamp a disc with falloff f(dist / radius) every `spacing`
+ * pixels along a path, so a pixel at perpendicular distance d collected
+ *
+ *     sum_k f(sqrt(d^2 + (k * spacing)^2) / radius)
+ *       ~= (radius / spacing) * Q(d / radius)
+ *     Q(u) = integral of f(sqrt(u^2 + t^2)) dt over sqrt(u^2 + t^2) <= 1
+ *
+ * Tabulating Q lets distance-field carving apply the same total in one
+ * write per pixel, independent of how finely the path is sampled.
+ */
+class SweptProfile {
+public:
+    // falloff: f(r) for r in [0, 1], zero beyond
+    template<typename Falloff>
+    explicit SweptProfile(Falloff falloff) : table_(TABLE_SIZE + 1) {
+        const int steps = 64;  // Midpoint rule along the path per entry
+
+        for (int i = 0; i <= TABLE_SIZE; ++i) {
+            float u = static_cast<float>(i) / TABLE_SIZE;
+            float halfChord = std::sqrt(std::max(0.0f, 1.0f - u * u));
+            float dt = 2.0f * halfChord / steps;
+
+            float sum = 0.0f;
+            for (int s = 0; s < steps; ++s) {
+                float t = -halfChord + (s + 0.5f) * dt;
+                float r = std::min(1.0f, std::sqrt(u * u + t * t));
+                sum += falloff(r);
+            }
+            table_[i] = sum * dt;
+        }
+    }
+
+    // Q(u) for u = distance / radius; 0 outside the stamp
+    float operator()(float u) const {
+        if (u >= 1.0f) return 0.0f;
+        float pos = std::max(0.0f, u) * TABLE_SIZE;
+        int i = static_cast<int>(pos);
+        float t = pos - i;
+        return table_[i] + (table_[i + 1] - table_[i]) * t;
+    }
+
+    // Total carve at distance d for a stamp of `radius` every `spacing` px
+    float swept(float distance, float radius, float spacing) const {
+        return (radius / spacing) * (*this)(distance / radius);
+    }
+
+private:
+    static constexpr int TABLE_SIZE = 256;
+    std::vector<float> table_;
+};
@@ -1,6 +1,6 @@
 #include "TerrainSoftening.h"
+#include "Filters.h"
 #include <algorithm>
-#include <cmath>
 #include <vector>
 
 void TerrainSoftening::execute(HeightMap& map, float strength, float threshold,
@@ -14,6 +14,15 @@ void TerrainSoftening::execute(HeightMap& map, float strength, float threshold,
     }
 }
 
+void TerrainSoftening::executeAtElevation(HeightMap& map, float strength, float elevationThreshold,
+                                          int smoothRadius, int passes, ThreadPool* pool) {
+    if (strength < 0.01f) return;
+
+    for (int pass = 0; pass < passes; pass++) {
+        applySmoothingPass(map, elevationThreshold, strength, smoothRadius, pool);
+    }
+}
+
 float TerrainSoftening::calculateElevationThreshold(const HeightMap& map, float threshold) {
     std::vector<float> sorted(map.getData(), map.getData() + map.getSize());
     size_t thresholdIndex = static_cast<size_t>(sorted.size() * threshold);
@@ -27,43 +36,23 @@ void TerrainSoftening::applySmoothingPass(HeightMap& map, float elevationThresho
     int width = map.getWidth();
     int height = map.getHeight();
 
-    HeightMap smoothed = map;
-
-    pool->parallelFor(0, height, [&](size_t y) {
-        int yi = static_cast<int>(y);
-        for (int x = 0; x < width; x++) {
-            float sum = 0.0f;
-            float weightSum = 0.0f;
-
-            for (int dy = -smoothRadius; dy <= smoothRadius; dy++) {
-                for (int dx = -smoothRadius; dx <= smoothRadius; dx++) {
-                    int nx = std::clamp(x + dx, 0, width - 1);
-                    int ny = std::clamp(yi + dy, 0, height - 1);
+    // Gaussian with sigma = radius / 3, truncated at the radius
+    HeightMap smoothed(width, height);
+    Filters::gaussianBlur(map, smoothed, smoothRadius / 3.0f, pool, smoothRadius);
 
-                    float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
-                    if (dist > smoothRadius) continue;
+    // Blend weight: full below the threshold band, fading out across it
+    HeightMap weights(width, height);
+    const float* data = map.getData();
+    float* weightData = weights.getData();
 
-                    float sigma = smoothRadius / 3.0f;
-                    float weight = std::exp(-(dist * dist) / (2.0f * sigma * sigma));
+    const float transitionWidth = 0.15f;
+    const float lowerBound = elevationThreshold - transitionWidth;
+    const float upperBound = elevationThreshold + transitionWidth;
 
-                    sum += map.at(nx, ny) * weight;
-                    weightSum += weight;
-                }
-            }
-
-            smoothed.at(x, yi) = sum / weightSum;
-        }
-    });
-
-    pool->parallelFor(0, height, [&](size_t y) {
-        int yi = static_cast<int>(y);
+    auto processRow = [&](size_t y) {
+        size_t rowOffset = y * width;
         for (int x = 0; x < width; x++) {
-            float originalHeight = map.at(x, yi);
-            float smoothedHeight = smoothed.at(x, yi);
-
-            float transitionWidth = 0.15f;
-            float lowerBound = elevationThreshold - transitionWidth;
-            float upperBound = elevationThreshold + transitionWidth;
+            float originalHeight = data[rowOffset + x];
 
             float blendFactor = 0.0f;
             if (originalHeight < lowerBound) {
@@ -73,8 +62,17 @@ void TerrainSoftening::applySmoothingPass(HeightMap& map, float elevationThresho
                 blendFactor = 1.0f - t;
             }
 
-            blendFactor *= strength;
-            map.at(x, yi) = originalHeight * (1.0f - blendFactor) + smoothedHeight * blendFactor;
+            weightData[rowOffset + x] = blendFactor * strength;
         }
-    });
+    };
+
+    if (pool) {
+        pool->parallelFor(0, height, processRow, 16);
+    } else {
+        for (int y = 0; y < height; ++y) {
+            processRow(y);
+        }
+    }
+
+    Filters::blend(map, smoothed, weights, pool);
 }
@@ -8,6 +8,11 @@ public:
     static void execute(HeightMap& map, float strength, float threshold,
                        int smoothRadius, int passes, ThreadPool* pool);
 
+    // As execute, but with an absolute elevation instead of a percentile of
+    // this map, so separately generated chunks soften identically
+    static void executeAtElevation(HeightMap& map, float strength, float elevationThreshold,
+                                   int smoothRadius, int passes, ThreadPool* pool);
+
 private:
     static float calculateElevationThreshold(const HeightMap& map, float threshold);
     static void applySmoothingPass(HeightMap& map, float elevationThreshold,
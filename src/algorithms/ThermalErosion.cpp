@@ -2,7 +2,8 @@
 #include <algorithm>
 #include <cmath>
 
-void ThermalErosion::apply(HeightMap& heightMap, const Params& params, ThreadPool* pool) {
+void ThermalErosion::apply(HeightMap& heightMap, const Params& params, ThreadPool* pool, ErosionMaps* maps,
+                           Scratch* scratch) {
     if (params.iterations <= 0 || params.thermalRate < 0.001f) {
         return;  // Nothing to do
     }
@@ -10,16 +11,34 @@ void ThermalErosion::apply(HeightMap& heightMap, const Params& params, ThreadPoo
     int width = heightMap.getWidth();
     int height = heightMap.getHeight();
 
-    // Create work buffer for double-buffering
-    HeightMap workBuffer(width, height);
+    if (height < 3) {
+        return;  // No interior rows
+    }
+
+    // Work buffer for double-buffering, the caller's if it has one
+    Scratch local;
+    if (!scratch) {
+        scratch = &local;
+    }
+    if (!scratch->workBuffer || scratch->workBuffer->getWidth() != width ||
+        scratch->workBuffer->getHeight() != height) {
+        scratch->workBuffer = std::make_unique<HeightMap>(width, height);
+    }
+    HeightMap& workBuffer = *scratch->workBuffer;
+
+    // Two halo rows per band: deposits that cross into a neighboring band
+    // are collected here and merged after the pass instead of racing
+    int numBands = (height - 2 + BAND_ROWS - 1) / BAND_ROWS;
+    std::vector<float>& halos = scratch->halos;
+    halos.resize(static_cast<size_t>(numBands) * 2 * width);
 
     // Perform multiple erosion passes
     for (int iter = 0; iter < params.iterations; ++iter) {
         // Alternate between source and dest for double-buffering
         if (iter % 2 == 0) {
-            thermalPass(heightMap, workBuffer, params, pool);
+            thermalPass(heightMap, workBuffer, params, pool, maps, halos);
         } else {
-            thermalPass(workBuffer, heightMap, params, pool);
+            thermalPass(workBuffer, heightMap, params, pool, maps, halos);
         }
     }
 
@@ -29,7 +48,8 @@ void ThermalErosion::apply(HeightMap& heightMap, const Params& params, ThreadPoo
     }
 }
 
-void ThermalErosion::thermalPass(HeightMap& source, HeightMap& dest, const Params& params, ThreadPool* pool) {
+void ThermalErosion::thermalPass(HeightMap& source, HeightMap& dest, const Params& params, ThreadPool* pool,
+                                 ErosionMaps* maps, std::vector<float>& halos) {
     int width = source.getWidth();
     int height = source.getHeight();
 
@@ -40,67 +60,109 @@ void ThermalErosion::thermalPass(HeightMap& source, HeightMap& dest, const Param
     // For 1 unit cell distance and talus angle, threshold = tan(angle)
     float talusThreshold = std::tan(params.talusAngle);
 
-    auto processRow = [&](size_t y) {
-        int yi = static_cast<int>(y);
+    // Moore neighborhood offsets and distances (diagonals = sqrt(2))
+    static const int dx[] = {-1,  0,  1, -1, 1, -1, 0, 1};
+    static const int dy[] = {-1, -1, -1,  0, 0,  1, 1, 1};
+    static const float distances[] = {
+        1.414f, 1.0f, 1.414f,  // Top row (diagonal, straight, diagonal)
+        1.0f,         1.0f,     // Middle row (straight, straight)
+        1.414f, 1.0f, 1.414f   // Bottom row (diagonal, straight, diagonal)
+    };
 
-        for (int x = 1; x < width - 1; ++x) {
-            float current = source.at(x, yi);
+    // Per-neighbor slope thresholds and index offsets, hoisted out of the pixel loop
+    float thresholds[8];
+    int offsets[8];
+    for (int n = 0; n < 8; ++n) {
+        thresholds[n] = talusThreshold * distances[n];
+        offsets[n] = dy[n] * width + dx[n];
+    }
 
-            // Check 8 neighbors (Moore neighborhood)
-            // Cardinal neighbors (distance = 1.0)
-            const int dx[] = {-1,  0,  1, -1, 1, -1, 0, 1};
-            const int dy[] = {-1, -1, -1,  0, 0,  1, 1, 1};
-            const float distances[] = {
-                1.414f, 1.0f, 1.414f,  // Top row (diagonal, straight, diagonal)
-                1.0f,         1.0f,     // Middle row (straight, straight)
-                1.414f, 1.0f, 1.414f   // Bottom row (diagonal, straight, diagonal)
-            };
+    const float* src = source.getData();
+    float* dst = dest.getData();
+    float* erosionOut = maps ? maps->erosion.getData() : nullptr;
+    float* depositOut = maps ? maps->deposition.getData() : nullptr;
 
-            float totalEroded = 0.0f;
-            float depositAmounts[8] = {0};
+    int numBands = (height - 2 + BAND_ROWS - 1) / BAND_ROWS;
 
-            // Calculate material transfer to each neighbor
-            for (int n = 0; n < 8; ++n) {
-                int nx = x + dx[n];
-                int ny = yi + dy[n];
+    auto processBand = [&](size_t band) {
+        int rowStart = 1 + static_cast<int>(band) * BAND_ROWS;
+        int rowEnd = std::min(height - 1, rowStart + BAND_ROWS);
 
-                // Boundary check
-                if (nx < 0 || nx >= width || ny < 0 || ny >= height) {
-                    continue;
-                }
+        float* haloAbove = halos.data() + band * 2 * width;
+        float* haloBelow = haloAbove + width;
+        std::fill(haloAbove, haloAbove + 2 * width, 0.0f);
 
-                float neighbor = source.at(nx, ny);
-                float heightDiff = current - neighbor;
+        for (int y = rowStart; y < rowEnd; ++y) {
+            // Rows and columns 0 and max are skipped, so all 8 neighbors are in bounds
+            size_t rowOffset = static_cast<size_t>(y) * width;
+            const float* row = src + rowOffset;
+            float* outRow = dst + rowOffset;
 
-                // Check if slope exceeds talus angle
-                float slopeAngle = calculateSlopeAngle(heightDiff, distances[n]);
+            for (int x = 1; x < width - 1; ++x) {
+                float current = row[x];
 
-                if (slopeAngle > params.talusAngle) {
-                    // Material needs to transfer
-                    // Amount is proportional to how much slope exceeds threshold
-                    float excessHeight = heightDiff - (talusThreshold * distances[n]);
-                    float transferAmount = excessHeight * params.thermalRate;
+                float totalEroded = 0.0f;
+                float maxHeightDiff = 0.0f;
+                float depositAmounts[8] = {0};
 
-                    // Limit transfer to avoid negative heights
-                    transferAmount = std::min(transferAmount, heightDiff * 0.5f);
+                // Calculate material transfer to each neighbor
+                for (int n = 0; n < 8; ++n) {
+                    float heightDiff = current - row[x + offsets[n]];
+
+                    // Check if slope exceeds talus angle (atan is monotonic, so
+                    // compare against tan(talusAngle) instead of per-neighbor atan)
+                    if (heightDiff > thresholds[n]) {
+                        // Material needs to transfer
+                        // Amount is proportional to how much slope exceeds threshold
+                        float excessHeight = heightDiff - thresholds[n];
+                        float transferAmount = excessHeight * params.thermalRate;
+
+                        // Limit transfer to avoid negative heights
+                        transferAmount = std::min(transferAmount, heightDiff * 0.5f);
+
+                        totalEroded += transferAmount;
+                        depositAmounts[n] = transferAmount;
+                        maxHeightDiff = std::max(maxHeightDiff, heightDiff);
+                    }
+                }
 
-                    totalEroded += transferAmount;
-                    depositAmounts[n] = transferAmount;
+                if (totalEroded <= 0.0f) {
+                    continue;
                 }
-            }
 
-            // Apply erosion to current cell
-            if (totalEroded > 0.0f) {
-                dest.at(x, yi) = current - totalEroded;
+                // Never move more than half the steepest drop in total, otherwise
+                // a cell with several low neighbors overshoots and oscillates
+                float maxTransfer = maxHeightDiff * 0.5f;
+                if (totalEroded > maxTransfer) {
+                    float scale = maxTransfer / totalEroded;
+                    for (int n = 0; n < 8; ++n) {
+                        depositAmounts[n] *= scale;
+                    }
+                    totalEroded = maxTransfer;
+                }
+
+                // Subtract rather than assign so deposits already received
+                // from earlier neighbors in this pass are kept
+                outRow[x] -= totalEroded;
+                if (erosionOut) {
+                    erosionOut[rowOffset + x] += totalEroded;
+                }
 
-                // Deposit material on neighbors
+                // Deposit material on neighbors; rows owned by other bands go to the halos
                 for (int n = 0; n < 8; ++n) {
-                    if (depositAmounts[n] > 0.0f) {
-                        int nx = x + dx[n];
-                        int ny = yi + dy[n];
+                    if (depositAmounts[n] <= 0.0f) {
+                        continue;
+                    }
 
-                        if (nx >= 0 && nx < width && ny >= 0 && ny < height) {
-                            dest.at(nx, ny) += depositAmounts[n];
+                    int ny = y + dy[n];
+                    if (ny < rowStart) {
+                        haloAbove[x + dx[n]] += depositAmounts[n];
+                    } else if (ny >= rowEnd) {
+                        haloBelow[x + dx[n]] += depositAmounts[n];
+                    } else {
+                        outRow[x + offsets[n]] += depositAmounts[n];
+                        if (depositOut) {
+                            depositOut[rowOffset + x + offsets[n]] += depositAmounts[n];
                         }
                     }
                 }
@@ -108,13 +170,36 @@ void ThermalErosion::thermalPass(HeightMap& source, HeightMap& dest, const Param
         }
     };
 
-    // Process rows in parallel
+    // Process bands in parallel
     if (pool) {
-        pool->parallelFor(1, height - 1, processRow);
+        pool->parallelFor(0, numBands, processBand);
     } else {
         // Single-threaded fallback
-        for (int y = 1; y < height - 1; ++y) {
-            processRow(y);
+        for (int band = 0; band < numBands; ++band) {
+            processBand(band);
+        }
+    }
+
+    // Merge cross-band deposits in band order
+    for (int band = 0; band < numBands; ++band) {
+        int rowStart = 1 + band * BAND_ROWS;
+        int rowEnd = std::min(height - 1, rowStart + BAND_ROWS);
+        const float* haloAbove = halos.data() + static_cast<size_t>(band) * 2 * width;
+        const float* haloBelow = haloAbove + width;
+
+        size_t aboveOffset = static_cast<size_t>(rowStart - 1) * width;
+        size_t belowOffset = static_cast<size_t>(rowEnd) * width;
+
+        for (int x = 0; x < width; ++x) {
+            dst[aboveOffset + x] += haloAbove[x];
+            dst[belowOffset + x] += haloBelow[x];
+        }
+
+        if (depositOut) {
+            for (int x = 0; x < width; ++x) {
+                depositOut[aboveOffset + x] += haloAbove[x];
+                depositOut[belowOffset + x] += haloBelow[x];
+            }
         }
     }
 }
@@ -2,7 +2,10 @@
 
 #include "HeightMap.h"
 #include "ThreadPool.h"
+#include "ErosionMaps.h"
 #include <cmath>
+#include <memory>
+#include <vector>
 
 /**
  * Thermal Erosion - Talus Angle Method
@@ -23,20 +26,37 @@ public:
         int iterations = 30;           // Number of erosion passes
     };
 
+    // Buffers kept by callers that erode the same size repeatedly (brush dabs)
+    struct Scratch {
+        std::unique_ptr<HeightMap> workBuffer;
+        std::vector<float> halos;
+    };
+
     /**
      * Apply thermal erosion to heightmap
      * @param heightMap Terrain to erode (modified in-place)
      * @param params Erosion parameters
      * @param pool Thread pool for parallelization (optional)
+     * @param maps Optional wear/deposition accumulation (flow is left untouched)
+     * @param scratch Optional buffers reused across calls instead of allocated
      */
-    static void apply(HeightMap& heightMap, const Params& params, ThreadPool* pool);
+    static void apply(HeightMap& heightMap, const Params& params, ThreadPool* pool,
+                      ErosionMaps* maps = nullptr, Scratch* scratch = nullptr);
+
+    // Rows per parallel band, starting at row 1. Fixed rather than derived from
+    // the thread count so the summation order, and therefore the result,
+    // doesn't depend on pool size.
+    static constexpr int BAND_ROWS = 16;
 
 private:
     /**
      * Perform single thermal erosion pass
-     * Transfers material from steep slopes to neighbors
+     * Transfers material from steep slopes to neighbors. Rows are processed
+     * in bands; deposits crossing a band edge go to per-band halo rows that
+     * are merged after the pass, so no two workers write the same cell.
      */
-    static void thermalPass(HeightMap& source, HeightMap& dest, const Params& params, ThreadPool* pool);
+    static void thermalPass(HeightMap& source, HeightMap& dest, const Params& params, ThreadPool* pool,
+                            ErosionMaps* maps, std::vector<float>& halos);
 
     /**
      * Calculate slope angle between two heights
@@ -1,23 +1,27 @@
 #include "ValleyConnectivity.h"
+#include "PolylineRasterizer.h"
+#include "SweptProfile.h"
 #include <algorithm>
 #include <cmath>
-#include <queue>
+#include <limits>
 
 void ValleyConnectivity::execute(HeightMap& map,
                                  float connectivity,
                                  float valleyThreshold,
                                  ThreadPool* pool) {
-    (void)pool;  // Unused - reserved for future parallel implementation
-
     if (connectivity < 0.01f) return;
 
-    // Identify valley regions using flood-fill
-    auto regions = identifyValleyRegions(map, valleyThreshold);
+    // Label valley regions (every pixel, exact)
+    auto regions = identifyValleyRegions(map, valleyThreshold, pool);
+
+    // Ignore specks; only sizable valleys are worth connecting
+    regions.erase(std::remove_if(regions.begin(), regions.end(),
+        [](const Region& r) { return r.size() < MIN_REGION_PIXELS; }), regions.end());
 
     if (regions.size() <= 1) return;  // No need to connect if only one region
 
     // Limit to top 6 largest regions for performance
-    std::sort(regions.begin(), regions.end(),
+    std::stable_sort(regions.begin(), regions.end(),
         [](const Region& a, const Region& b) { return a.size() > b.size(); });
 
     if (regions.size() > 6) {
@@ -37,92 +41,176 @@ void ValleyConnectivity::execute(HeightMap& map,
     // Create corridors between disconnected regions
     for (int i = 0; i < maxConnections; ++i) {
         const auto& conn = connections[i];
-        createCorridor(map, conn.from, conn.to, baseWidth, valleyThreshold);
+        createCorridor(map, conn.from, conn.to, baseWidth, valleyThreshold, pool);
     }
 }
 
-std::vector<ValleyConnectivity::Region> ValleyConnectivity::identifyValleyRegions(
-    const HeightMap& map, float threshold) {
-
-    std::vector<Region> regions;
-    std::unordered_set<int> visited;
-
-    int width = map.getWidth();
-    int height = map.getHeight();
-
-    // Sample grid (every 4th pixel for performance)
-    const int step = 4;
-
-    for (int y = 0; y < height; y += step) {
-        for (int x = 0; x < width; x += step) {
-            int idx = y * width + x;
+namespace {
+// Rows per labeling band; fixed so labels don't depend on pool size
+constexpr int LABEL_BAND_ROWS = 64;
 
-            if (!visited.count(idx) && map.at(x, y) < threshold) {
-                // Start flood-fill for new region
-                Region region = floodFillRegion(map, x, y, threshold, visited);
-
-                // Only keep regions with reasonable size
-                if (region.size() > 50) {
-                    regions.push_back(region);
-                }
-            }
-        }
+// Root lookup with path halving (writes, so only within a thread's own band
+// or from serial code)
+int findRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
     }
+    return i;
+}
 
-    return regions;
+// Read-only root lookup, safe to run concurrently once unions are done
+int findRootConst(const std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        i = parent[i];
+    }
+    return i;
 }
 
-ValleyConnectivity::Region ValleyConnectivity::floodFillRegion(
-    const HeightMap& map,
-    int startX, int startY,
-    float threshold,
-    std::unordered_set<int>& visited) {
+// Link the larger root under the smaller so every root is the first pixel
+// of its region in raster order (deterministic labels)
+void unite(std::vector<int>& parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a == b) return;
+    if (a < b) {
+        parent[b] = a;
+    } else {
+        parent[a] = b;
+    }
+}
+}
 
-    Region region;
-    std::queue<Point> queue;
+std::vector<ValleyConnectivity::Region> ValleyConnectivity::identifyValleyRegions(
+    const HeightMap& map, float threshold, ThreadPool* pool, std::vector<int>* labelsOut) {
 
     int width = map.getWidth();
     int height = map.getHeight();
-    int startIdx = startY * width + startX;
+    size_t size = static_cast<size_t>(width) * height;
+    const float* data = map.getData();
+
+    // parent[i] = -1 for non-valley pixels, otherwise union-find link
+    std::vector<int> parent(size, -1);
+
+    int numBands = (height + LABEL_BAND_ROWS - 1) / LABEL_BAND_ROWS;
+
+    // Pass 1: label each band independently (links stay inside the band)
+    auto labelBand = [&](size_t band) {
+        int rowStart = static_cast<int>(band) * LABEL_BAND_ROWS;
+        int rowEnd = std::min(height, rowStart + LABEL_BAND_ROWS);
+
+        for (int y = rowStart; y < rowEnd; ++y) {
+            int rowOffset = y * width;
+            for (int x = 0; x < width; ++x) {
+                int idx = rowOffset + x;
+                if (data[idx] >= threshold) continue;
+
+                // Join the left neighbor's tree directly (common case),
+                // only the pixel above can need a real union
+                bool left = x > 0 && parent[idx - 1] >= 0;
+                parent[idx] = left ? parent[idx - 1] : idx;
+                if (y > rowStart && parent[idx - width] >= 0) {
+                    unite(parent, idx, idx - width);
+                }
+            }
+        }
 
-    queue.push({startX, startY, startIdx});
-    visited.insert(startIdx);
+        // Flatten so seam merging and lookups see depth-1 trees
+        for (int idx = rowStart * width; idx < rowEnd * width; ++idx) {
+            if (parent[idx] >= 0) {
+                parent[idx] = findRoot(parent, idx);
+            }
+        }
+    };
 
-    // Limit region size for performance
-    const int maxRegionSize = 500;
-    const int step = 2;  // Skip every other pixel
+    if (pool) {
+        pool->parallelFor(0, numBands, labelBand);
+    } else {
+        for (int band = 0; band < numBands; ++band) {
+            labelBand(band);
+        }
+    }
+
+    // Pass 2: merge across band seams (serial, one row per seam)
+    for (int band = 1; band < numBands; ++band) {
+        int rowOffset = band * LABEL_BAND_ROWS * width;
+        for (int x = 0; x < width; ++x) {
+            int idx = rowOffset + x;
+            if (parent[idx] >= 0 && parent[idx - width] >= 0) {
+                unite(parent, idx, idx - width);
+            }
+        }
+    }
 
-    while (!queue.empty() && region.size() < maxRegionSize) {
-        Point current = queue.front();
-        queue.pop();
+    // Dense ids for roots in raster order, written at the root pixel
+    std::vector<int> localLabels;
+    std::vector<int>& labels = labelsOut ? *labelsOut : localLabels;
+    labels.assign(size, 0);
 
-        region.points.push_back(current);
+    int numLabels = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (parent[i] == static_cast<int>(i)) {
+            labels[i] = ++numLabels;
+        }
+    }
 
-        // Check 4-connected neighbors
-        const Point neighbors[] = {
-            {current.x - step, current.y, 0},
-            {current.x + step, current.y, 0},
-            {current.x, current.y - step, 0},
-            {current.x, current.y + step, 0}
-        };
+    // Pass 3: resolve every other pixel to its root's label (roots are
+    // only read here, so bands don't race)
 
-        for (const auto& neighbor : neighbors) {
-            int nx = neighbor.x;
-            int ny = neighbor.y;
+    auto resolveBand = [&](size_t band) {
+        int rowStart = static_cast<int>(band) * LABEL_BAND_ROWS;
+        int rowEnd = std::min(height, rowStart + LABEL_BAND_ROWS);
+        for (int idx = rowStart * width; idx < rowEnd * width; ++idx) {
+            if (parent[idx] >= 0 && parent[idx] != idx) {
+                labels[idx] = labels[findRootConst(parent, idx)];
+            }
+        }
+    };
 
-            // Bounds check
-            if (nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+    if (pool) {
+        pool->parallelFor(0, numBands, resolveBand);
+    } else {
+        for (int band = 0; band < numBands; ++band) {
+            resolveBand(band);
+        }
+    }
 
-            int nIdx = ny * width + nx;
+    // One sweep for sizes, bounding boxes and boundaries
+    std::vector<Region> regions(numLabels);
+    for (int i = 0; i < numLabels; ++i) {
+        regions[i].label = i + 1;
+        regions[i].minX = width;
+        regions[i].minY = height;
+        regions[i].maxX = -1;
+        regions[i].maxY = -1;
+    }
 
-            if (!visited.count(nIdx) && map.at(nx, ny) < threshold) {
-                visited.insert(nIdx);
-                queue.push({nx, ny, nIdx});
+    for (int y = 0; y < height; ++y) {
+        int rowOffset = y * width;
+        for (int x = 0; x < width; ++x) {
+            int idx = rowOffset + x;
+            int label = labels[idx];
+            if (label == 0) continue;
+
+            Region& region = regions[label - 1];
+            region.pixelCount++;
+            region.minX = std::min(region.minX, x);
+            region.maxX = std::max(region.maxX, x);
+            region.minY = std::min(region.minY, y);
+            region.maxY = std::max(region.maxY, y);
+
+            // Map edges don't count as boundary: corridors can't leave the map
+            bool boundary = (x > 0 && labels[idx - 1] == 0) ||
+                            (x < width - 1 && labels[idx + 1] == 0) ||
+                            (y > 0 && labels[idx - width] == 0) ||
+                            (y < height - 1 && labels[idx + width] == 0);
+            if (boundary) {
+                region.boundary.push_back({x, y, idx});
             }
         }
     }
 
-    return region;
+    return regions;
 }
 
 std::vector<ValleyConnectivity::Connection> ValleyConnectivity::findValleyConnections(
@@ -131,46 +219,75 @@ std::vector<ValleyConnectivity::Connection> ValleyConnectivity::findValleyConnec
 
     std::vector<Connection> connections;
 
-    // For each pair of regions, find closest points
+    // Only connect if reasonably close (max 40% of map width)
+    float maxConnectionDist = map.getWidth() * 0.4f;
+
+    auto distance = [](const Point& a, const Point& b) {
+        float dx = static_cast<float>(a.x - b.x);
+        float dy = static_cast<float>(a.y - b.y);
+        return std::sqrt(dx * dx + dy * dy);
+    };
+
+    // Closest point of a boundary to p (exhaustive)
+    auto closestTo = [&distance](const std::vector<Point>& boundary, const Point& p) {
+        const Point* best = &boundary.front();
+        float bestDist = distance(*best, p);
+        for (const auto& q : boundary) {
+            float d = distance(q, p);
+            if (d < bestDist) {
+                bestDist = d;
+                best = &q;
+            }
+        }
+        return *best;
+    };
+
+    // For each pair of regions, find closest boundary points
     for (size_t i = 0; i < regions.size(); ++i) {
         for (size_t j = i + 1; j < regions.size(); ++j) {
-            const auto& regionA = regions[i].points;
-            const auto& regionB = regions[j].points;
+            const Region& regionA = regions[i];
+            const Region& regionB = regions[j];
+            if (regionA.boundary.empty() || regionB.boundary.empty()) continue;
+
+            // Bounding boxes give a lower bound on the gap
+            int gapX = std::max({0, regionB.minX - regionA.maxX, regionA.minX - regionB.maxX});
+            int gapY = std::max({0, regionB.minY - regionA.maxY, regionA.minY - regionB.maxY});
+            if (std::sqrt(static_cast<float>(gapX * gapX + gapY * gapY)) >= maxConnectionDist) {
+                continue;
+            }
+
+            // Coarse search over sampled boundary points...
+            const auto& boundaryA = regionA.boundary;
+            const auto& boundaryB = regionB.boundary;
+            size_t stepA = std::max<size_t>(1, boundaryA.size() / BOUNDARY_SAMPLES);
+            size_t stepB = std::max<size_t>(1, boundaryB.size() / BOUNDARY_SAMPLES);
 
             float minDist = std::numeric_limits<float>::infinity();
             Connection closestPair = {};
 
-            // Sample points to find closest pair
-            size_t sampleSize = std::min<size_t>(20, regionA.size());
-            size_t stepA = std::max<size_t>(1, regionA.size() / sampleSize);
-            size_t stepB = std::max<size_t>(1, regionB.size() / sampleSize);
-
-            for (size_t a = 0; a < regionA.size(); a += stepA) {
-                for (size_t b = 0; b < regionB.size(); b += stepB) {
-                    const auto& pointA = regionA[a];
-                    const auto& pointB = regionB[b];
-
-                    float dx = static_cast<float>(pointA.x - pointB.x);
-                    float dy = static_cast<float>(pointA.y - pointB.y);
-                    float dist = std::sqrt(dx * dx + dy * dy);
-
+            for (size_t a = 0; a < boundaryA.size(); a += stepA) {
+                for (size_t b = 0; b < boundaryB.size(); b += stepB) {
+                    float dist = distance(boundaryA[a], boundaryB[b]);
                     if (dist < minDist) {
                         minDist = dist;
-                        closestPair = {pointA, pointB, dist};
+                        closestPair = {boundaryA[a], boundaryB[b], dist};
                     }
                 }
             }
 
-            // Only connect if reasonably close (max 40% of map width)
-            float maxConnectionDist = map.getWidth() * 0.4f;
-            if (minDist < maxConnectionDist) {
+            // ...then refine against the full boundaries
+            closestPair.to = closestTo(boundaryB, closestPair.from);
+            closestPair.from = closestTo(boundaryA, closestPair.to);
+            closestPair.distance = distance(closestPair.from, closestPair.to);
+
+            if (closestPair.distance < maxConnectionDist) {
                 connections.push_back(closestPair);
             }
         }
     }
 
     // Sort by distance (connect closest regions first)
-    std::sort(connections.begin(), connections.end(),
+    std::stable_sort(connections.begin(), connections.end(),
         [](const Connection& a, const Connection& b) {
             return a.distance < b.distance;
         });
@@ -183,61 +300,54 @@ void ValleyConnectivity::createCorridor(
     const Point& from,
     const Point& to,
     float width,
-    float threshold) {
+    float threshold,
+    ThreadPool* pool) {
 
     float dx = static_cast<float>(to.x - from.x);
     float dy = static_cast<float>(to.y - from.y);
     float distance = std::sqrt(dx * dx + dy * dy);
 
-    int steps = static_cast<int>(distance / 3.0f);  // Sample every 3 pixels
+    // Corridor points used to be flattened every 3 pixels
+    int steps = static_cast<int>(distance / 3.0f);
     if (steps < 2) {
         steps = 2;
     }
-
-    for (int i = 0; i <= steps; ++i) {
-        float t = static_cast<float>(i) / steps;
-
-        int x = static_cast<int>(from.x + dx * t);
-        int y = static_cast<int>(from.y + dy * t);
-
-        flattenCorridorPoint(map, x, y, width / 2.0f, threshold);
-    }
-}
-
-void ValleyConnectivity::flattenCorridorPoint(
-    HeightMap& map,
-    int cx, int cy,
-    float radius,
-    float threshold) {
-
-    int width = map.getWidth();
-    int height = map.getHeight();
-    int iRadius = static_cast<int>(std::ceil(radius));
-
-    for (int dy = -iRadius; dy <= iRadius; ++dy) {
-        for (int dx = -iRadius; dx <= iRadius; ++dx) {
-            int x = cx + dx;
-            int y = cy + dy;
-
-            // Bounds check
-            if (x < 0 || x >= width || y < 0 || y >= height) continue;
-
-            float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
-            if (dist > radius) continue;
-
-            // Smooth flattening with falloff
-            float falloff = 1.0f - (dist / radius);
-            float smoothFalloff = falloff * falloff * (3.0f - 2.0f * falloff);  // Smoothstep
-
-            // Target height is slightly below threshold
-            float targetHeight = threshold * 0.7f;
-            float currentHeight = map.at(x, y);
-
-            // Only flatten if currently higher than target
-            if (currentHeight > targetHeight) {
-                map.at(x, y) = currentHeight * (1.0f - smoothFalloff * 0.8f) +
-                               targetHeight * smoothFalloff * 0.8f;
+    float spacing = std::max(1.0f, distance / steps);
+
+    float radius = width / 2.0f;
+    std::vector<PolylineRasterizer::Vertex> corridor = {
+        {glm::vec2(static_cast<float>(from.x), static_cast<float>(from.y)), radius, 1.0f},
+        {glm::vec2(static_cast<float>(to.x), static_cast<float>(to.y)), radius, 1.0f}
+    };
+
+    // Each flattening blended toward the target by 0.8 * smoothstep falloff,
+    // so the remaining height above target is a product of (1 - 0.8 * s).
+    // Summing its logarithm along the corridor gives that product directly.
+    static const SweptProfile retained([](float r) {
+        float falloff = 1.0f - r;
+        float smoothFalloff = falloff * falloff * (3.0f - 2.0f * falloff);  // Smoothstep
+        return std::log(1.0f - smoothFalloff * 0.8f);
+    });
+
+    // Target height is slightly below threshold
+    float targetHeight = threshold * 0.7f;
+
+    int mapWidth = map.getWidth();
+    float* data = map.getData();
+
+    PolylineRasterizer::rasterize(mapWidth, map.getHeight(), corridor, pool,
+        [&](int y, int x0, int x1, const PolylineRasterizer::Sample* samples) {
+            float* row = data + static_cast<size_t>(y) * mapWidth;
+            for (int x = x0; x < x1; ++x) {
+                const auto& sample = samples[x - x0];
+                if (!sample.inside()) continue;
+
+                // Only flatten if currently higher than target
+                float currentHeight = row[x];
+                if (currentHeight > targetHeight) {
+                    float keep = std::exp(retained.swept(sample.distance, sample.radius, spacing));
+                    row[x] = targetHeight + (currentHeight - targetHeight) * keep;
+                }
             }
-        }
-    }
+        });
 }
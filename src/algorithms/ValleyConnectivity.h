@@ -3,13 +3,13 @@
 #include "HeightMap.h"
 #include "ThreadPool.h"
 #include <vector>
-#include <unordered_set>
 
 /**
  * Valley Connectivity Algorithm
  *
  * Connects isolated flat valley areas with corridors for better gameplay.
- * Uses flood-fill to detect regions, then creates simple straight-line paths.
+ * Labels regions with parallel union-find, then creates simple straight-line
+ * paths between their closest boundary points.
  */
 class ValleyConnectivity {
 public:
@@ -27,13 +27,21 @@ public:
                        ThreadPool* pool);
 
 private:
+    static constexpr int MIN_REGION_PIXELS = 200;  // Smaller valleys aren't connected
+    static constexpr size_t BOUNDARY_SAMPLES = 64; // Coarse closest-pair sampling per region
+
     struct Point {
         int x, y, idx;
     };
 
+    // Connected valley area (4-connected pixels below threshold)
     struct Region {
-        std::vector<Point> points;
-        int size() const { return static_cast<int>(points.size()); }
+        int label = 0;            // Dense label in the label image (1-based)
+        int pixelCount = 0;
+        int minX = 0, minY = 0;   // Bounding box (inclusive)
+        int maxX = 0, maxY = 0;
+        std::vector<Point> boundary;  // Valley pixels with a non-valley 4-neighbor
+        int size() const { return pixelCount; }
     };
 
     struct Connection {
@@ -41,34 +49,32 @@ private:
         float distance;
     };
 
-    // Identify separate valley regions using flood-fill
+    /**
+     * Label every valley pixel with block-based union-find
+     *
+     * Row bands are labeled in parallel, band seams merged serially, then
+     * labels flattened to dense ids in raster order. Region sizes, bounding
+     * boxes and boundaries come from one sweep over the label image.
+     *
+     * @param labels Optional output label image (0 = not a valley)
+     */
     static std::vector<Region> identifyValleyRegions(
-        const HeightMap& map, float threshold);
-
-    // Flood-fill from a starting point
-    static Region floodFillRegion(
         const HeightMap& map,
-        int startX, int startY,
         float threshold,
-        std::unordered_set<int>& visited);
+        ThreadPool* pool,
+        std::vector<int>* labels = nullptr);
 
     // Find connections between regions
     static std::vector<Connection> findValleyConnections(
         const std::vector<Region>& regions,
         const HeightMap& map);
 
-    // Create corridor between two points
+    // Flatten a corridor between two points in one pass over its distance field
     static void createCorridor(
         HeightMap& map,
         const Point& from,
         const Point& to,
         float width,
-        float threshold);
-
-    // Flatten a single corridor point
-    static void flattenCorridorPoint(
-        HeightMap& map,
-        int cx, int cy,
-        float radius,
-        float threshold);
+        float threshold,
+        ThreadPool* pool);
 };
@@ -1,4 +1,6 @@
 #include "ValleyFlattening.h"
+#include "DistanceTransform.h"
+#include "Filters.h"
 #include <algorithm>
 #include <cmath>
 #include <limits>
@@ -6,8 +8,10 @@
 void ValleyFlattening::execute(HeightMap& map, float strength, ThreadPool* pool) {
     if (strength < 0.01f) return;
 
-    auto valleyFloors = detectValleyFloors(map, strength);
-    if (valleyFloors.empty()) return;
+    float threshold = calculateThreshold(map, strength);
+
+    auto valleyFloors = detectValleyFloors(map, threshold, pool);
+    if (valleyFloors.count == 0) return;
 
     applyFlattening(map, valleyFloors, strength, pool);
     smoothTransitions(map, valleyFloors, strength, 4, pool);
@@ -28,54 +32,58 @@ float ValleyFlattening::calculateThreshold(const HeightMap& map, float strength)
     return sorted[thresholdIndex];
 }
 
-std::unordered_map<int, float> ValleyFlattening::detectValleyFloors(
-    const HeightMap& map, float strength) {
-
-    std::unordered_map<int, float> floors;
-
-    float threshold = calculateThreshold(map, strength);
+ValleyFlattening::ValleyFloors ValleyFlattening::detectValleyFloors(
+    const HeightMap& map, float threshold, ThreadPool* pool) {
 
     // Search radius for finding valley floor
     const int searchRadius = 10;
 
     int width = map.getWidth();
     int height = map.getHeight();
+    const float* data = map.getData();
+    const float inf = std::numeric_limits<float>::infinity();
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            float currentHeight = map.at(x, y);
-
-            if (currentHeight < threshold) {
-                float minNeighbor = currentHeight;
-
-                for (int dy = -searchRadius; dy <= searchRadius; ++dy) {
-                    for (int dx = -searchRadius; dx <= searchRadius; ++dx) {
-                        int nx = std::clamp(x + dx, 0, width - 1);
-                        int ny = std::clamp(y + dy, 0, height - 1);
+    ValleyFloors floors(width, height);
+    floors.threshold = threshold;
 
-                        float neighborHeight = map.at(nx, ny);
+    // Only valley pixels take part in the min; everything else is +inf
+    HeightMap masked(width, height);
+    float* maskedData = masked.getData();
+    std::vector<size_t> rowCounts(height, 0);
 
-                        if (neighborHeight < threshold) {
-                            minNeighbor = std::min(minNeighbor, neighborHeight);
-                        }
-                    }
-                }
-
-                floors[y * width + x] = minNeighbor;
-            }
+    pool->parallelFor(0, height, [&](size_t y) {
+        size_t rowOffset = y * width;
+        size_t valleyCount = 0;
+        for (int x = 0; x < width; ++x) {
+            float value = data[rowOffset + x];
+            bool valley = value < threshold;
+            floors.valid[rowOffset + x] = valley ? 1 : 0;
+            maskedData[rowOffset + x] = valley ? value : inf;
+            valleyCount += valley ? 1 : 0;
         }
+        rowCounts[y] = valleyCount;
+    }, 16);
+
+    for (size_t rowCount : rowCounts) {
+        floors.count += rowCount;
     }
+    if (floors.count == 0) {
+        return floors;
+    }
+
+    // 21x21 window min, separable running min
+    Filters::minFilter(masked, floors.floor, searchRadius, pool);
 
     return floors;
 }
 
 void ValleyFlattening::applyFlattening(
     HeightMap& map,
-    const std::unordered_map<int, float>& valleyFloors,
+    const ValleyFloors& valleyFloors,
     float strength,
     ThreadPool* pool) {
 
-    float threshold = calculateThreshold(map, strength);
+    float threshold = valleyFloors.threshold;
     int width = map.getWidth();
     int height = map.getHeight();
 
@@ -87,8 +95,8 @@ void ValleyFlattening::applyFlattening(
             int idx = static_cast<int>(y * width + x);
             float currentHeight = map.at(x, yi);
 
-            if (currentHeight < threshold && valleyFloors.count(idx)) {
-                float valleyFloor = valleyFloors.at(idx);
+            if (currentHeight < threshold && valleyFloors.isValley(idx)) {
+                float valleyFloor = valleyFloors.floor.getData()[idx];
                 float depthBelowThreshold = (threshold - currentHeight) / threshold;
 
                 // Base 85% + up to 15% more based on depth
@@ -103,40 +111,9 @@ void ValleyFlattening::applyFlattening(
     map = std::move(tempMap);
 }
 
-float ValleyFlattening::findBoundaryDistance(
-    const HeightMap& map,
-    const std::unordered_map<int, float>& valleyFloors,
-    int x, int y,
-    int searchRadius) {
-
-    float minDist = std::numeric_limits<float>::infinity();
-    int width = map.getWidth();
-    int height = map.getHeight();
-    int idx = y * width + x;
-
-    bool isValley = valleyFloors.count(idx) > 0;
-
-    for (int dy = -searchRadius; dy <= searchRadius; ++dy) {
-        for (int dx = -searchRadius; dx <= searchRadius; ++dx) {
-            int nx = std::clamp(x + dx, 0, width - 1);
-            int ny = std::clamp(y + dy, 0, height - 1);
-            int nIdx = ny * width + nx;
-
-            bool neighborIsValley = valleyFloors.count(nIdx) > 0;
-
-            if (isValley != neighborIsValley) {
-                float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
-                minDist = std::min(minDist, dist);
-            }
-        }
-    }
-
-    return minDist;
-}
-
 void ValleyFlattening::smoothTransitions(
     HeightMap& map,
-    const std::unordered_map<int, float>& valleyFloors,
+    const ValleyFloors& valleyFloors,
     float strength,
     int rounds,
     ThreadPool* pool) {
@@ -144,51 +121,36 @@ void ValleyFlattening::smoothTransitions(
 
     const int smoothRadius = 10;
     const int transitionZone = 20;
-    const int boundaryRadius = 25;
 
     int width = map.getWidth();
     int height = map.getHeight();
 
-    for (int round = 0; round < rounds; ++round) {
-        HeightMap tempMap = map;
-
-        pool->parallelFor(0, height, [&](size_t y) {
-            int yi = static_cast<int>(y);
-            for (int x = 0; x < width; ++x) {
-                float distToEdge = findBoundaryDistance(
-                    map, valleyFloors, x, yi, boundaryRadius);
-
-                if (distToEdge < transitionZone) {
-                    float sum = 0.0f;
-                    float weightSum = 0.0f;
-
-                    for (int dy = -smoothRadius; dy <= smoothRadius; ++dy) {
-                        for (int dx = -smoothRadius; dx <= smoothRadius; ++dx) {
-                            int maxX = static_cast<int>(width) - 1;
-                            int maxY = static_cast<int>(height) - 1;
-                            int nx = std::clamp<int>(x + dx, 0, maxX);
-                            int ny = std::clamp<int>(y + dy, 0, maxY);
-
-                            float dist = std::sqrt(static_cast<float>(dx * dx + dy * dy));
-                            if (dist > smoothRadius) continue;
-
-                            float weight = std::exp(-(dist * dist) /
-                                (smoothRadius * smoothRadius * 0.5f));
-
-                            sum += map.at(nx, ny) * weight;
-                            weightSum += weight;
-                        }
-                    }
-
-                    float smoothed = sum / weightSum;
-                    float blendFactor = (1.0f - (distToEdge / transitionZone)) * 0.95f;
-
-                    tempMap.at(x, yi) = map.at(x, yi) * (1.0f - blendFactor) +
-                                       smoothed * blendFactor;
-                }
+    // Distance to the valley boundary from either side; the valley mask is
+    // fixed across rounds so one transform (and one weight map) serves them all
+    HeightMap boundaryDistance(width, height);
+    DistanceTransform::computeSigned(valleyFloors.valid, boundaryDistance, pool);
+    const float* edgeDistance = boundaryDistance.getData();
+
+    HeightMap weights(width, height);
+    float* weightData = weights.getData();
+
+    pool->parallelFor(0, height, [&](size_t y) {
+        size_t rowOffset = y * width;
+        for (int x = 0; x < width; ++x) {
+            float distToEdge = std::fabs(edgeDistance[rowOffset + x]);
+
+            float blendFactor = 0.0f;
+            if (distToEdge < transitionZone) {
+                blendFactor = (1.0f - (distToEdge / transitionZone)) * 0.95f;
             }
-        }, 4);
+            weightData[rowOffset + x] = blendFactor;
+        }
+    }, 16);
 
-        map = std::move(tempMap);
+    // exp(-d^2 / (r^2 / 2)) is a Gaussian with sigma = r / 2
+    HeightMap smoothed(width, height);
+    for (int round = 0; round < rounds; ++round) {
+        Filters::gaussianBlur(map, smoothed, smoothRadius * 0.5f, pool, smoothRadius);
+        Filters::blend(map, smoothed, weights, pool);
     }
 }
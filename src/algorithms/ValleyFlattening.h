@@ -2,7 +2,7 @@
 
 #include "HeightMap.h"
 #include "ThreadPool.h"
-#include <unordered_map>
+#include <cstdint>
 #include <vector>
 
 // Three-pass valley flattening: detect floors, extreme flattening (85-100%), smooth transitions
@@ -11,27 +11,36 @@ public:
     static void execute(HeightMap& map, float strength, ThreadPool* pool);
 
 private:
-    static std::unordered_map<int, float> detectValleyFloors(
-        const HeightMap& map, float strength);
+    // Dense valley floor buffer; floor is only meaningful where valid[idx] != 0
+    struct ValleyFloors {
+        int width;
+        int height;
+        float threshold = 0.0f;
+        HeightMap floor;              // Lowest valley height within the search window
+        std::vector<uint8_t> valid;   // 1 = pixel is below threshold (valley)
+        size_t count = 0;             // Number of valley pixels
+
+        ValleyFloors(int w, int h)
+            : width(w), height(h), floor(w, h), valid(static_cast<size_t>(w) * h, 0) {}
+
+        bool isValley(int idx) const { return valid[idx] != 0; }
+    };
+
+    static ValleyFloors detectValleyFloors(
+        const HeightMap& map, float threshold, ThreadPool* pool);
 
     static void applyFlattening(
         HeightMap& map,
-        const std::unordered_map<int, float>& valleyFloors,
+        const ValleyFloors& valleyFloors,
         float strength,
         ThreadPool* pool);
 
     static void smoothTransitions(
         HeightMap& map,
-        const std::unordered_map<int, float>& valleyFloors,
+        const ValleyFloors& valleyFloors,
         float strength,
         int rounds,
         ThreadPool* pool);
 
-    static float findBoundaryDistance(
-        const HeightMap& map,
-        const std::unordered_map<int, float>& valleyFloors,
-        int x, int y,
-        int searchRadius);
-
     static float calculateThreshold(const HeightMap& map, float strength);
 };
@@ -0,0 +1,136 @@
+#include "BatchGenerator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// Map-sized float buffers per generation: height map and work buffer plus
+// the cached edge distance map stay resident; softening, valley and export
+// scratch peak at about five more
+constexpr size_t RESIDENT_MAPS = 3;
+constexpr size_t TRANSIENT_MAPS = 5;
+// River carving peaks higher: the hydrology analysis (filled heights,
+// accumulation, flow fractions and two byte-sized direction maps) stays
+// live while carving adds per-cell radius and depth, the power transform's
+// output, nearest-cell indices and its two column-pass buffers
+constexpr size_t RIVER_MAPS = 10;
+constexpr size_t EROSION_MAPS = 3;  // Flow, deposition, wear
+}
+
+BatchGenerator::BatchGenerator(ThreadPool* pool, const Config& config)
+    : pool_(pool), config_(config) {
+    if (!pool_) {
+        throw std::invalid_argument("BatchGenerator requires a ThreadPool");
+    }
+    if (config_.resolution <= 0) {
+        throw std::invalid_argument("BatchGenerator resolution must be positive");
+    }
+}
+
+size_t BatchGenerator::estimateBytesPerGeneration(int resolution, bool captureErosionMaps) {
+    size_t mapBytes = static_cast<size_t>(resolution) * resolution * sizeof(float);
+    // Stages run one after another, so only the larger scratch set is live at once
+    size_t maps = RESIDENT_MAPS + std::max(TRANSIENT_MAPS, RIVER_MAPS) +
+                  (captureErosionMaps ? EROSION_MAPS : 0);
+    return mapBytes * maps;
+}
+
+size_t BatchGenerator::concurrency() const {
+    size_t limit = config_.maxConcurrent;
+    if (limit == 0) {
+        limit = std::max<size_t>(2, pool_->getThreadCount() / 2);
+    }
+
+    size_t perGeneration = estimateBytesPerGeneration(config_.resolution, config_.captureErosionMaps);
+    size_t affordable = config_.memoryBudget / perGeneration;
+
+    return std::max<size_t>(1, std::min(limit, affordable));
+}
+
+BatchGenerator::Stats BatchGenerator::run(const std::vector<TerrainParams>& jobs,
+                                          const ResultCallback& onResult) {
+    using Clock = std::chrono::steady_clock;
+
+    Stats stats;
+    stats.bytesPerGeneration = estimateBytesPerGeneration(config_.resolution, config_.captureErosionMaps);
+    stats.concurrency = std::min(concurrency(), std::max<size_t>(1, jobs.size()));
+
+    if (stats.bytesPerGeneration > config_.memoryBudget) {
+        std::cerr << "BatchGenerator: one " << config_.resolution << "x" << config_.resolution
+                  << " generation needs ~" << (stats.bytesPerGeneration >> 20)
+                  << " MB, over the " << (config_.memoryBudget >> 20)
+                  << " MB budget; running one at a time" << std::endl;
+    }
+
+    std::atomic<size_t> nextJob{0};
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> failed{0};
+    std::mutex latencyMutex;
+    double totalLatency = 0.0;
+
+    auto start = Clock::now();
+
+    auto drive = [&]() {
+        ThreadPool::PriorityScope priorityScope(config_.priority);
+
+        // Created on first use so a short batch doesn't allocate idle slots
+        std::unique_ptr<TerrainGenerator> generator;
+
+        for (size_t index = nextJob++; index < jobs.size(); index = nextJob++) {
+            auto jobStart = Clock::now();
+            try {
+                if (!generator) {
+                    generator = std::make_unique<TerrainGenerator>(
+                        config_.resolution, config_.resolution, pool_);
+                    generator->setCaptureErosionMaps(config_.captureErosionMaps);
+                }
+
+                generator->generate(jobs[index]);
+                if (onResult) {
+                    onResult(index, *generator);
+                }
+                ++completed;
+            } catch (const std::exception& e) {
+                std::cerr << "BatchGenerator: job " << index << " (seed " << jobs[index].seed
+                          << ") failed: " << e.what() << std::endl;
+                ++failed;
+                continue;
+            }
+
+            double latency = std::chrono::duration<double>(Clock::now() - jobStart).count();
+            std::lock_guard<std::mutex> lock(latencyMutex);
+            totalLatency += latency;
+        }
+    };
+
+    if (stats.concurrency <= 1) {
+        drive();
+    } else {
+        std::vector<std::thread> drivers;
+        drivers.reserve(stats.concurrency);
+        for (size_t i = 0; i < stats.concurrency; ++i) {
+            drivers.emplace_back(drive);
+        }
+        for (std::thread& driver : drivers) {
+            driver.join();
+        }
+    }
+
+    stats.completed = completed.load();
+    stats.failed = failed.load();
+    stats.elapsedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (stats.completed > 0) {
+        stats.meanLatencySeconds = totalLatency / stats.completed;
+    }
+    if (stats.elapsedSeconds > 0.0) {
+        stats.mapsPerMinute = stats.completed * 60.0 / stats.elapsedSeconds;
+    }
+
+    return stats;
+}
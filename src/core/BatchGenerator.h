@@ -0,0 +1,68 @@
+#pragma once
+
+#include "TerrainGenerator.h"
+#include "TerrainParams.h"
+#include "ThreadPool.h"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * BatchGenerator - Throughput mode for many terrains at one resolution
+ *
+ * A single generate() call leaves cores idle during its serial phases
+ * (hydraulic droplets, river tracing, valley connectivity, normalization).
+ * BatchGenerator keeps several generations in flight on one shared
+ * ThreadPool: each runs on its own driver thread, and parallelFor lets
+ * every waiting driver work on the others' row chunks, so one generation's
+ * serial phase overlaps another's parallel phase.
+ *
+ * The number in flight is bounded by maxConcurrent and by memoryBudget
+ * divided by estimateBytesPerGeneration(). More in flight raises
+ * maps/minute at the cost of per-map latency.
+ */
+class BatchGenerator {
+public:
+    struct Config {
+        int resolution = 1024;
+        size_t maxConcurrent = 0;                  // 0 = half the pool's threads, at least 2
+        size_t memoryBudget = size_t(2) << 30;     // Bytes for all in-flight generations
+        bool captureErosionMaps = false;
+        TaskPriority priority = TaskPriority::NORMAL;  // Pool lane for generation and onResult
+    };
+
+    struct Stats {
+        size_t completed = 0;
+        size_t failed = 0;
+        size_t concurrency = 0;           // Generations admitted at once
+        size_t bytesPerGeneration = 0;
+        double elapsedSeconds = 0.0;
+        double meanLatencySeconds = 0.0;  // Generate + onResult, per map
+        double mapsPerMinute = 0.0;
+    };
+
+    // Called on a driver thread once job `index` has generated; must be
+    // thread-safe. Exports done here overlap other jobs' generation.
+    using ResultCallback = std::function<void(size_t index, const TerrainGenerator& generator)>;
+
+    BatchGenerator(ThreadPool* pool, const Config& config);
+
+    /**
+     * Generate every job, at most concurrency() at a time
+     *
+     * Jobs start in order. Each driver reuses one TerrainGenerator, so its
+     * buffers stay warm across the jobs it runs. A job that throws is
+     * counted as failed and skipped.
+     */
+    Stats run(const std::vector<TerrainParams>& jobs, const ResultCallback& onResult);
+
+    // Generations admitted at once under the configured limits (at least 1)
+    size_t concurrency() const;
+
+    // Conservative peak working set of one generation, in bytes
+    static size_t estimateBytesPerGeneration(int resolution, bool captureErosionMaps);
+
+private:
+    ThreadPool* pool_;
+    Config config_;
+};
@@ -1,10 +1,13 @@
 #include "HeightMapEditCommand.h"
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
-HeightMapEditCommand::HeightMapEditCommand(HeightMap* heightMap, const std::string& description)
+HeightMapEditCommand::HeightMapEditCommand(HeightMap* heightMap, const std::string& description,
+                                           std::function<void()> onChange)
     : heightMap_(heightMap)
-    , description_(description) {
+    , description_(description)
+    , onChange_(std::move(onChange)) {
 }
 
 void HeightMapEditCommand::recordChange(int x, int y, float oldValue, float newValue) {
@@ -62,6 +65,10 @@ void HeightMapEditCommand::execute() {
     for (const auto& delta : deltas_) {
         heightMap_->at(delta.x, delta.y) = delta.newValue;
     }
+
+    if (onChange_) {
+        onChange_();
+    }
 }
 
 void HeightMapEditCommand::undo() {
@@ -69,6 +76,10 @@ void HeightMapEditCommand::undo() {
     for (const auto& delta : deltas_) {
         heightMap_->at(delta.x, delta.y) = delta.oldValue;
     }
+
+    if (onChange_) {
+        onChange_();
+    }
 }
 
 const char* HeightMapEditCommand::getDescription() const {
@@ -2,6 +2,7 @@
 
 #include "UndoCommand.h"
 #include "HeightMap.h"
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -34,8 +35,11 @@ public:
      *
      * @param heightMap Target heightmap to modify
      * @param description User-friendly description (e.g., "Raise Brush")
+     * @param onChange Optional, called after execute() and undo() write the
+     *                 map, so its owner can drop anything derived from it
      */
-    HeightMapEditCommand(HeightMap* heightMap, const std::string& description);
+    HeightMapEditCommand(HeightMap* heightMap, const std::string& description,
+                         std::function<void()> onChange = nullptr);
 
     /**
      * Record a pixel change
@@ -80,6 +84,7 @@ private:
     HeightMap* heightMap_;
     std::vector<PixelDelta> deltas_;
     std::string description_;
+    std::function<void()> onChange_;
 
     // Temporary storage for captureRegion/finalizeRegion workflow
     struct CapturedPixel {
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <algorithm>
 #include <random>
+#include <vector>
 
 PerlinNoise::PerlinNoise(uint32_t seed) : seed_(seed) {
     generatePermutation(seed);
@@ -96,3 +97,68 @@ float PerlinNoise::octaveNoise(float x, float y, int octaves,
 
     return total / maxValue;
 }
+
+void PerlinNoise::octaveNoiseRow(int xStart, float scale, float y, int count,
+                                 int octaves, float persistence, float lacunarity,
+                                 float* out) const {
+    std::fill(out, out + count, 0.0f);
+    addOctavesRow(xStart, scale, y, count, 0, octaves, persistence, lacunarity, out);
+
+    float maxValue = amplitudeSum(octaves, persistence);
+    for (int s = 0; s < count; ++s) {
+        out[s] /= maxValue;
+    }
+}
+
+void PerlinNoise::addOctavesRow(int xStart, float scale, float y, int count,
+                                int firstOctave, int lastOctave, float persistence, float lacunarity,
+                                float* out) const {
+    // Divided (not multiplied by 1 / scale) to match octaveNoise(x / scale, ...)
+    thread_local std::vector<float> xs;
+    xs.resize(count);
+    for (int s = 0; s < count; ++s) {
+        xs[s] = static_cast<float>(xStart + s) / scale;
+    }
+
+    float frequency = 1.0f;
+    float amplitude = 1.0f;
+
+    for (int i = 0; i < lastOctave; ++i) {
+        if (i >= firstOctave) {
+            // Row terms are shared by every sample in this octave
+            float fy = y * frequency;
+            int Y = static_cast<int>(std::floor(fy)) & 255;
+            float yf = fy - std::floor(fy);
+            float v = fade(yf);
+
+            for (int s = 0; s < count; ++s) {
+                float fx = xs[s] * frequency;
+                int X = static_cast<int>(std::floor(fx)) & 255;
+                float xf = fx - std::floor(fx);
+                float u = fade(xf);
+
+                int A = p_[X] + Y;
+                int B = p_[X + 1] + Y;
+
+                float value = lerp(v,
+                    lerp(u, grad(p_[p_[A]], xf, yf), grad(p_[p_[B]], xf - 1.0f, yf)),
+                    lerp(u, grad(p_[p_[A + 1]], xf, yf - 1.0f), grad(p_[p_[B + 1]], xf - 1.0f, yf - 1.0f))
+                );
+                out[s] += value * amplitude;
+            }
+        }
+
+        amplitude *= persistence;
+        frequency *= lacunarity;
+    }
+}
+
+float PerlinNoise::amplitudeSum(int octaves, float persistence) {
+    float amplitude = 1.0f;
+    float maxValue = 0.0f;
+    for (int i = 0; i < octaves; ++i) {
+        maxValue += amplitude;
+        amplitude *= persistence;
+    }
+    return maxValue;
+}
@@ -11,6 +11,21 @@ public:
     float octaveNoise(float x, float y, int octaves,
                      float persistence, float lacunarity) const;
 
+    // octaveNoise at ((xStart + i) / scale, y) for i in [0, count), written to out,
+    // bit for bit. Per-row work (y lattice cell and fade) is done once per octave.
+    // A sample only depends on its integer x, so rows starting anywhere agree exactly.
+    void octaveNoiseRow(int xStart, float scale, float y, int count,
+                        int octaves, float persistence, float lacunarity,
+                        float* out) const;
+
+    // Adds octaves [firstOctave, lastOctave) of octaveNoiseRow to out, before
+    // the division by amplitudeSum(octaves). Summing [0, k) then [k, octaves)
+    // and dividing gives exactly octaveNoiseRow, so a sum can be built in parts.
+    void addOctavesRow(int xStart, float scale, float y, int count,
+                       int firstOctave, int lastOctave, float persistence, float lacunarity,
+                       float* out) const;
+    static float amplitudeSum(int octaves, float persistence);
+
     void setSeed(uint32_t seed);
 
 private:
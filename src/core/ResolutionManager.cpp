@@ -1,16 +1,24 @@
 #include "ResolutionManager.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 ResolutionManager::ResolutionManager(ThreadPool* threadPool)
     : threadPool_(threadPool)
-    , currentRes_(Resolution::STANDARD)
+    , currentSize_(getResolutionValue(Resolution::STANDARD))
+    , previewResult_(false)
     , targetRes_(Resolution::STANDARD)
     , isGenerating_(false)
-    , paramsChanged_(false) {
+    , newResult_(false)
+    , pendingSize_(0)
+    , pendingPreview_(false)
+    , pendingKey_{0, 0}
+    , paramsChanged_(false)
+    , displayFromParams_(false)
+    , captureErosionMaps_(false) {
 
     // Create initial generator at standard resolution
-    int size = getResolutionValue(currentRes_);
-    generator_ = std::make_unique<TerrainGenerator>(size, size, threadPool_);
+    generator_ = takeGenerator(currentSize_);
 
     // Initialize timer
     lastInteraction_ = std::chrono::steady_clock::now();
@@ -18,6 +26,12 @@ ResolutionManager::ResolutionManager(ThreadPool* threadPool)
 
 ResolutionManager::~ResolutionManager() {
     cancelGeneration();
+
+    // Its task still inserts into cache_
+    cancelSpeculation();
+    if (speculativeFuture_.valid()) {
+        speculativeFuture_.wait();
+    }
 }
 
 void ResolutionManager::generateAt(Resolution res, const TerrainParams& params) {
@@ -27,28 +41,152 @@ void ResolutionManager::generateAt(Resolution res, const TerrainParams& params)
     // Store parameters
     currentParams_ = params;
     paramsChanged_ = false;
+    upgradeHeld_ = false;
 
     // Start generation
-    startGeneration(res, params);
+    startGeneration(getResolutionValue(res), params, false);
 
-    // Reset interaction timer
-    onUserInteraction();
+    // Reset interaction timer (params are current, so no paramsChanged_)
+    lastInteraction_ = std::chrono::steady_clock::now();
 }
 
-void ResolutionManager::startGeneration(Resolution res, const TerrainParams& params) {
-    int size = getResolutionValue(res);
+void ResolutionManager::generatePreview(const TerrainParams& params) {
+    cancelGeneration();
 
-    // Recreate generator if resolution changed
-    if (res != currentRes_ || !generator_) {
-        std::cout << "Creating generator at " << size << "x" << size << std::endl;
-        generator_ = std::make_unique<TerrainGenerator>(size, size, threadPool_);
+    currentParams_ = params;
+    paramsChanged_ = false;
+    upgradeHeld_ = false;
+
+    int size = getPreviewSize();
+    startGeneration(size, previewParams(params, size), true);
+
+    lastInteraction_ = std::chrono::steady_clock::now();
+}
+
+int ResolutionManager::getPreviewSize() const {
+    int maxSize = std::min(MAX_PREVIEW_SIZE, getResolutionValue(targetRes_));
+    maxSize = std::max(MIN_PREVIEW_SIZE, maxSize);
+
+    if (msPerPixel_ <= 0.0) {
+        return std::min(getResolutionValue(Resolution::PREVIEW), maxSize);
     }
 
+    double pixels = previewBudgetMs_ / msPerPixel_;
+    int size = static_cast<int>(std::sqrt(pixels)) / PREVIEW_SIZE_STEP * PREVIEW_SIZE_STEP;
+    return std::clamp(size, MIN_PREVIEW_SIZE, maxSize);
+}
+
+TerrainParams ResolutionManager::levelParams(const TerrainParams& params, int size) const {
+    TerrainParams level = params;
+
+    // Erosion settings are tuned for the target size: keep droplets per
+    // pixel and thermal reach (in pixels) proportional so the level looks
+    // like the result
+    double linear = std::min(1.0, static_cast<double>(size) / getResolutionValue(targetRes_));
+
+    level.hydraulicDroplets = std::max(1, static_cast<int>(params.hydraulicDroplets * linear * linear));
+    level.thermalIterations = std::max(1, static_cast<int>(params.thermalIterations * linear));
+
+    // Noise is sampled per pixel; shrinking its scale with the size keeps
+    // the target's world area, which generateRefined() builds on
+    if (progressive_ && linear < 1.0) {
+        level.scale = static_cast<float>(params.scale * linear);
+    }
+
+    return level;
+}
+
+TerrainParams ResolutionManager::previewParams(const TerrainParams& params, int size) const {
+    TerrainParams preview = levelParams(params, size);
+
+    // Cut erosion work further per quality level
+    double reduction = 1.0 / (1 << previewQuality_);
+
+    preview.hydraulicDroplets = std::max(1, static_cast<int>(preview.hydraulicDroplets * reduction));
+    preview.thermalIterations = std::max(1, static_cast<int>(preview.thermalIterations * reduction));
+
+    if (previewQuality_ >= 2) {
+        preview.hydraulicIterations = 1;
+        preview.enableRiverEnhancements = false;  // Tributaries and wetlands trace the whole map
+    }
+
+    return preview;
+}
+
+int ResolutionManager::nextLevelSize() const {
+    int target = getResolutionValue(targetRes_);
+    for (Resolution res : {Resolution::STANDARD, Resolution::HIGH, Resolution::EXPORT, Resolution::ULTRA}) {
+        int size = getResolutionValue(res);
+        if (size >= target) break;
+        if (size >= 2 * currentSize_) return size;
+    }
+    return target;
+}
+
+void ResolutionManager::startGeneration(int size, const TerrainParams& params, bool preview, bool refine) {
+    parkGenerator(std::move(coarseGenerator_));
+    tileQueue_.clear();
+    abortFlag_.store(false);
+
+    // Switch generators if resolution changed
+    if (!generator_ || generator_->getWidth() != size || generator_->getHeight() != size) {
+        if (refine && generator_ && generator_->hasProgressiveLevel()) {
+            coarseGenerator_ = std::move(generator_);
+        } else {
+            parkGenerator(std::move(generator_));
+        }
+        generator_ = takeGenerator(size);
+    }
+
+    // A direct result beats a refined one; either ends the chain early
+    TerrainCache::Key key = TerrainCache::makeKey(params, size);
+    TerrainCache::Key refinedKey = TerrainCache::refinedKey(key);
+    bool cached = restoreFromCache(key);
+    if (!cached && coarseGenerator_ && restoreFromCache(refinedKey)) {
+        cached = true;
+        key = refinedKey;
+    }
+    if (cached) {
+        parkGenerator(std::move(coarseGenerator_));
+        displayedKey_ = key;
+        currentSize_ = size;
+        previewResult_ = preview;
+        displayFromParams_ = true;
+        snapshotErosionMaps();
+        newResult_ = true;
+        std::cout << "Terrain at " << size << "x" << size << " served from cache" << std::endl;
+        return;
+    }
+
+    // Real work comes first
+    cancelSpeculation();
+
     // Start async generation
+    pendingKey_ = key;
+    pendingSize_ = size;
+    pendingPreview_ = preview;
     std::cout << "Generating terrain at " << size << "x" << size << "..." << std::endl;
     isGenerating_ = true;
 
-    generationFuture_ = generator_->generateAsync(params);
+    bool streamTiles = tileStreaming_ && !preview && size >= TILE_STREAM_MIN_SIZE;
+    generator_->setTileQueue(streamTiles ? &tileQueue_ : nullptr);
+
+    // Slider previews are what the user is waiting on; refinement levels
+    // and upgrades can yield to them
+    TaskPriority priority = preview && !refine ? TaskPriority::INTERACTIVE : TaskPriority::NORMAL;
+
+    TerrainGenerator* generator = generator_.get();
+    const TerrainGenerator* coarse = coarseGenerator_.get();
+    generationFuture_ = threadPool_->enqueue(priority, [generator, coarse, params]() {
+        auto start = std::chrono::steady_clock::now();
+        if (coarse) {
+            generator->generateRefined(params, *coarse);
+        } else {
+            generator->generate(params);
+        }
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    });
 }
 
 void ResolutionManager::update() {
@@ -59,8 +197,20 @@ void ResolutionManager::update() {
 
     // Check if we should auto-upgrade
     if (!isGenerating_ && shouldAutoUpgrade()) {
-        std::cout << "Auto-upgrading to " << getResolutionName(targetRes_) << std::endl;
-        startGeneration(targetRes_, currentParams_);
+        if (progressive_) {
+            int size = nextLevelSize();
+            std::cout << "Refining to " << size << "x" << size << std::endl;
+            startGeneration(size, levelParams(currentParams_, size),
+                            size < getResolutionValue(targetRes_), true);
+        } else {
+            std::cout << "Auto-upgrading to " << getResolutionName(targetRes_) << std::endl;
+            startGeneration(getResolutionValue(targetRes_), currentParams_, false);
+        }
+    }
+
+    // Idle: pre-generate what the user may pick next
+    if (!isGenerating_ && speculative_) {
+        startSpeculation();
     }
 }
 
@@ -75,23 +225,214 @@ void ResolutionManager::checkGenerationComplete() {
 
     if (status == std::future_status::ready) {
         // Generation complete
-        generationFuture_.get(); // Collect result
-
+        double elapsedMs = generationFuture_.get(); // Collect result
+        parkGenerator(std::move(coarseGenerator_));
+        tileQueue_.clear();  // Superseded by the finished terrain (or abandoned)
         isGenerating_ = false;
-        currentRes_ = targetRes_;
 
-        int size = getResolutionValue(currentRes_);
-        std::cout << "Generation complete at " << size << "x" << size << std::endl;
+        if (generator_->wasAborted()) {
+            std::cout << "Generation at " << pendingSize_ << "x" << pendingSize_ << " aborted" << std::endl;
+            if (displayedKey_.resolution == 0 || !restoreFromCache(displayedKey_)) {
+                // Previous terrain is gone: the partial one stays, as a preview
+                currentSize_ = pendingSize_;
+                previewResult_ = true;
+                displayedKey_ = {0, 0};
+            }
+            snapshotErosionMaps();
+            abortedResult_ = true;
+            return;
+        }
+
+        recordGenerationTime(pendingSize_, pendingPreview_, generator_->wasRefined(), elapsedMs);
+
+        displayedKey_ = generator_->wasRefined() ? TerrainCache::refinedKey(pendingKey_) : pendingKey_;
+        cache_.insert(displayedKey_, generator_->getHeightMap(), generator_->getErosionMaps(),
+                      captureErosionMaps_);
+
+        snapshotErosionMaps();
+        newResult_ = true;
+        currentSize_ = pendingSize_;
+        previewResult_ = pendingPreview_;
+        displayFromParams_ = true;
+
+        std::cout << "Generation complete at " << currentSize_ << "x" << currentSize_
+                  << " in " << elapsedMs << "ms" << std::endl;
+    }
+}
+
+void ResolutionManager::startSpeculation() {
+    if (speculativeFuture_.valid()) {
+        if (speculativeFuture_.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+            return;
+        }
+        speculativeFuture_.get();
+        if (speculativeJob_) {
+            parkGenerator(std::move(speculativeJob_->generator));
+            speculativeJob_.reset();
+        }
+    }
+
+    int size = getPreviewSize();
+    while (!speculativeQueue_.empty()) {
+        TerrainParams candidate = speculativeQueue_.front();
+        speculativeQueue_.pop_front();
+
+        // Same params and key as generatePreview(candidate) would use now
+        TerrainParams params = previewParams(candidate, size);
+        TerrainCache::Key key = TerrainCache::makeKey(params, size);
+        if (cache_.contains(key)) continue;
+
+        auto job = std::make_shared<SpeculativeJob>();
+        job->candidate = candidate;
+        job->generator = takeGenerator(size);
+        job->generator->setKeepProgressiveLevel(false);
+        job->generator->setAbortFlag(&job->abort);
+
+        TerrainCache* cache = &cache_;
+        bool captured = captureErosionMaps_;
+        speculativeFuture_ = threadPool_->enqueue(TaskPriority::BACKGROUND, [job, cache, key, params, captured]() {
+            job->generator->generate(params);
+            if (!job->generator->wasAborted()) {
+                cache->insert(key, job->generator->getHeightMap(),
+                              job->generator->getErosionMaps(), captured);
+            }
+        });
+        speculativeJob_ = job;
+        return;
     }
 }
 
+void ResolutionManager::cancelSpeculation() {
+    if (!speculativeJob_ || speculativeJob_->abort.load()) return;
+
+    // The job stays until startSpeculation() collects it, so the next one
+    // waits for this one to stop
+    speculativeJob_->abort.store(true);
+    speculativeQueue_.push_front(speculativeJob_->candidate);
+}
+
+void ResolutionManager::speculate(const std::vector<TerrainParams>& candidates) {
+    speculativeQueue_.assign(candidates.begin(), candidates.end());
+}
+
+void ResolutionManager::setSpeculative(bool enabled) {
+    speculative_ = enabled;
+    if (!enabled) {
+        cancelSpeculation();
+        speculativeQueue_.clear();
+    }
+}
+
+void ResolutionManager::recordGenerationTime(int size, bool preview, bool refined, double milliseconds) {
+    lastGenerationMs_ = milliseconds;
+
+    // The estimate sizes previews, so only plain previews feed it: full
+    // quality upgrades erode more per pixel, and refinements only add the
+    // octaves they didn't inherit, so either would skew it
+    if (!preview || refined) return;
+
+    // Smoothed, so one hiccup doesn't swing the next preview size
+    double msPerPixel = milliseconds / (static_cast<double>(size) * size);
+    msPerPixel_ = msPerPixel_ > 0.0 ? 0.5 * (msPerPixel_ + msPerPixel) : msPerPixel;
+
+    // Size can't shrink further: do less erosion work. Size maxed with
+    // room to spare: restore some.
+    if (size <= MIN_PREVIEW_SIZE && milliseconds > previewBudgetMs_) {
+        previewQuality_ = std::min(previewQuality_ + 1, MAX_PREVIEW_QUALITY);
+    } else if (previewQuality_ > 0 && milliseconds < 0.5 * previewBudgetMs_ &&
+               size >= std::min(MAX_PREVIEW_SIZE, getResolutionValue(targetRes_))) {
+        previewQuality_--;
+    }
+}
+
+bool ResolutionManager::restoreFromCache(const TerrainCache::Key& key) {
+    std::shared_ptr<const TerrainCache::Entry> entry = cache_.lookup(key);
+    if (!entry) return false;
+
+    // Generated without capture: its erosion masks are unknown
+    if (captureErosionMaps_ && !entry->erosionCaptured) return false;
+
+    generator_->setHeightMap(entry->heightMap);
+    generator_->setErosionMaps(entry->erosionMaps.get());
+    return true;
+}
+
+void ResolutionManager::snapshotErosionMaps() {
+    const ErosionMaps* maps = generator_->getErosionMaps();
+    if (!maps) {
+        erosionMaps_.reset();
+    } else if (erosionMaps_ && erosionMaps_->getWidth() == maps->getWidth() &&
+               erosionMaps_->getHeight() == maps->getHeight()) {
+        *erosionMaps_ = *maps;
+    } else {
+        erosionMaps_ = std::make_unique<ErosionMaps>(*maps);
+    }
+}
+
+std::unique_ptr<TerrainGenerator> ResolutionManager::takeGenerator(int size) {
+    std::unique_ptr<TerrainGenerator> generator;
+    for (auto it = parkedGenerators_.begin(); it != parkedGenerators_.end(); ++it) {
+        if ((*it)->getWidth() == size && (*it)->getHeight() == size) {
+            generator = std::move(*it);
+            parkedGenerators_.erase(it);
+            break;
+        }
+    }
+
+    if (!generator) {
+        std::cout << "Creating generator at " << size << "x" << size << std::endl;
+        generator = std::make_unique<TerrainGenerator>(size, size, threadPool_);
+    }
+    generator->setCaptureErosionMaps(captureErosionMaps_);
+    generator->setKeepProgressiveLevel(progressive_);
+    generator->setAbortFlag(&abortFlag_);
+    generator->setTileQueue(nullptr);
+    return generator;
+}
+
+void ResolutionManager::parkGenerator(std::unique_ptr<TerrainGenerator> generator) {
+    if (!generator) return;
+
+    int width = generator->getWidth();
+    int height = generator->getHeight();
+    parkedGenerators_.erase(
+        std::remove_if(parkedGenerators_.begin(), parkedGenerators_.end(),
+                       [&](const std::unique_ptr<TerrainGenerator>& parked) {
+                           return parked->getWidth() == width && parked->getHeight() == height;
+                       }),
+        parkedGenerators_.end());
+    parkedGenerators_.push_back(std::move(generator));
+
+    setGeneratorPoolBudget(generatorPoolBudget_);
+}
+
+void ResolutionManager::setGeneratorPoolBudget(size_t bytes) {
+    generatorPoolBudget_ = bytes;
+
+    size_t total = 0;
+    for (const auto& parked : parkedGenerators_) {
+        total += parked->getMemoryUsage();
+    }
+    auto oldest = parkedGenerators_.begin();
+    while (oldest != parkedGenerators_.end() && total > generatorPoolBudget_) {
+        total -= (*oldest)->getMemoryUsage();
+        ++oldest;
+    }
+    parkedGenerators_.erase(parkedGenerators_.begin(), oldest);
+}
+
 bool ResolutionManager::shouldAutoUpgrade() const {
     // Don't upgrade if:
-    // - Already at target resolution
+    // - Displayed terrain wasn't generated from currentParams_ (imported)
+    // - The last upgrade was aborted
+    // - Already a full-quality result at (or above) target resolution
     // - Params changed (need to regenerate)
     // - Not enough time passed since last interaction
 
-    if (currentRes_ >= targetRes_)
+    if (!displayFromParams_ || upgradeHeld_)
+        return false;
+
+    if (!previewResult_ && currentSize_ >= getResolutionValue(targetRes_))
         return false;
 
     if (paramsChanged_)
@@ -109,10 +450,22 @@ void ResolutionManager::onUserInteraction() {
     paramsChanged_ = true;
 }
 
+void ResolutionManager::abortGeneration() {
+    if (!isGenerating_ || !generationFuture_.valid()) return;
+
+    // Stages only check the flag at band or stage boundaries, so waiting
+    // here could stall the UI for seconds; update() collects it instead
+    // (it may still finish first)
+    abortFlag_.store(true);
+    tileQueue_.clear();
+    upgradeHeld_ = true;
+}
+
 void ResolutionManager::cancelGeneration() {
     if (isGenerating_ && generationFuture_.valid()) {
-        // Wait for current generation to finish
-        // (We can't actually cancel mid-generation safely)
+        // Stop it at the next band or stage boundary; its partial result is
+        // about to be replaced
+        abortFlag_.store(true);
         generationFuture_.wait();
         isGenerating_ = false;
     }
@@ -132,20 +485,36 @@ void ResolutionManager::setHeightMap(const HeightMap& newMap) {
 
     // Replace the heightmap
     generator_->setHeightMap(newMap);
+    snapshotErosionMaps();
 
-    // Update current resolution based on imported size
-    int size = newMap.getWidth();
-    if (size <= 128) {
-        currentRes_ = Resolution::PREVIEW;
-    } else if (size <= 512) {
-        currentRes_ = Resolution::STANDARD;
-    } else if (size <= 1024) {
-        currentRes_ = Resolution::HIGH;
-    } else if (size <= 2048) {
-        currentRes_ = Resolution::EXPORT;
-    } else {
-        currentRes_ = Resolution::ULTRA;
+    // Imported terrain isn't regenerated by auto-upgrade
+    displayedKey_ = {0, 0};
+    currentSize_ = newMap.getWidth();
+    previewResult_ = false;
+    displayFromParams_ = false;
+}
+
+Resolution ResolutionManager::getCurrentResolution() const {
+    if (currentSize_ >= getResolutionValue(Resolution::ULTRA)) return Resolution::ULTRA;
+    if (currentSize_ >= getResolutionValue(Resolution::EXPORT)) return Resolution::EXPORT;
+    if (currentSize_ >= getResolutionValue(Resolution::HIGH)) return Resolution::HIGH;
+    if (currentSize_ >= getResolutionValue(Resolution::STANDARD)) return Resolution::STANDARD;
+    return Resolution::PREVIEW;
+}
+
+void ResolutionManager::setProgressive(bool enabled) {
+    // Let a running generation finish; it reads the keep-level setting
+    if (isGenerating_ && generationFuture_.valid()) {
+        generationFuture_.wait();
+        checkGenerationComplete();
     }
+    progressive_ = enabled;
+    generator_->setKeepProgressiveLevel(enabled);
+}
+
+void ResolutionManager::setCaptureErosionMaps(bool enabled) {
+    captureErosionMaps_ = enabled;
+    generator_->setCaptureErosionMaps(enabled);
 }
 
 const char* ResolutionManager::getResolutionName(Resolution res) {
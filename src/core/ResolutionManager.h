@@ -2,16 +2,22 @@
 
 #include "HeightMap.h"
 #include "TerrainGenerator.h"
+#include "TerrainCache.h"
 #include "TerrainParams.h"
 #include "ThreadPool.h"
+#include "TileQueue.h"
+#include <atomic>
+#include <deque>
 #include <memory>
 #include <future>
 #include <chrono>
+#include <vector>
 
 /**
  * Resolution levels for terrain generation
  *
- * PREVIEW (128x128)   - Real-time slider updates (<16ms target)
+ * PREVIEW (128x128)   - Real-time slider updates; generatePreview() adapts
+ *                       the actual size (and quality) to a frame budget
  * STANDARD (512x512)  - Default quality (~2s)
  * HIGH (1024x1024)    - High quality (~8s)
  * EXPORT (2048x2048)  - Export quality (~30s)
@@ -32,10 +38,32 @@ enum class Resolution {
  * upgrading after user stops interacting.
  *
  * Workflow:
- * 1. User drags slider -> Generate at PREVIEW (instant feedback)
+ * 1. User drags slider -> generatePreview() (instant feedback)
  * 2. User stops -> Wait 500ms -> Auto-upgrade to STANDARD
  * 3. User clicks "Generate" -> Generate at HIGH
  * 4. User exports -> Generate at EXPORT or ULTRA
+ *
+ * Finished terrains go into a TerrainCache; a request (or auto-upgrade)
+ * for a params/resolution pair seen before is served from it without
+ * generating.
+ *
+ * In progressive mode the auto-upgrade climbs one resolution level at a
+ * time (preview -> STANDARD -> HIGH, skipping levels less than twice the
+ * current size), each refining the previous one with
+ * TerrainGenerator::generateRefined() and published as it completes.
+ * Levels below the target cover the target's world area, previews
+ * included, so each is a downscaled version of the final terrain.
+ *
+ * With tile streaming on, generations of HIGH and above publish finished
+ * bands of rows while they run (popTile()), and abortGeneration() stops
+ * one early.
+ *
+ * With speculation on, idle cores pre-generate previews of params the user
+ * is likely to pick next (speculate()), so reaching one is a cache hit.
+ *
+ * Generators left unused by a size change are parked, one per size, and
+ * picked up again when that size comes back, so flipping between preview
+ * and full sizes reuses their buffers instead of reallocating them.
  */
 class ResolutionManager {
 public:
@@ -50,6 +78,94 @@ public:
      */
     void generateAt(Resolution res, const TerrainParams& params);
 
+    /**
+     * Generate a fast preview during interaction
+     *
+     * Picks the largest size (any multiple of 32 from 64 up to the target
+     * resolution, at most 512) whose predicted generation time fits the
+     * preview budget, using wall times measured on earlier generations.
+     * Erosion work is scaled to the preview size so it looks like the final
+     * result, and is cut further when even the smallest size misses the
+     * budget. The full-quality terrain follows via auto-upgrade.
+     */
+    void generatePreview(const TerrainParams& params);
+
+    /**
+     * Wall-time budget for generatePreview() (default 16ms, one 60Hz frame)
+     */
+    void setPreviewBudget(double milliseconds) { previewBudgetMs_ = milliseconds; }
+    double getPreviewBudget() const { return previewBudgetMs_; }
+
+    /**
+     * Size and quality level (0 = full) generatePreview() would use now
+     */
+    int getPreviewSize() const;
+    int getPreviewQuality() const { return previewQuality_; }
+
+    /**
+     * Wall time of the last completed generation in milliseconds (0 if none)
+     */
+    double getLastGenerationMs() const { return lastGenerationMs_; }
+
+    /**
+     * Progressive coarse-to-fine upgrades (off by default). Results are an
+     * approximation of a direct generation at the same size.
+     */
+    void setProgressive(bool enabled);
+    bool isProgressive() const { return progressive_; }
+
+    /**
+     * Stream tiles from non-preview generations of HIGH or above (off by
+     * default)
+     */
+    void setTileStreaming(bool enabled) { tileStreaming_ = enabled; }
+    bool isTileStreaming() const { return tileStreaming_; }
+
+    /**
+     * Speculative pre-generation (off by default). While no generation runs,
+     * previews of the speculate() candidates are generated one at a time
+     * into the cache, at the size and quality generatePreview() would use,
+     * in the pool's BACKGROUND lane. Real work aborts the running one
+     * without waiting for it.
+     */
+    void setSpeculative(bool enabled);
+    bool isSpeculative() const { return speculative_; }
+
+    /**
+     * Replace the speculative candidates: full-quality params, most likely
+     * first. Candidates already cached are skipped.
+     */
+    void speculate(const std::vector<TerrainParams>& candidates);
+
+    /**
+     * Next finished tile of the running generation, oldest first. Call from
+     * the thread that calls update(). Tiles still queued when a generation
+     * completes or is aborted are dropped.
+     *
+     * Tile heights are not normalized: the range normalization maps to is
+     * only known once every stage has run, so they come out at about
+     * 0-1.35 and the mesh settles to 0-1 when the finished terrain
+     * replaces them.
+     */
+    bool popTile(TerrainTile& tile) {
+        if (abortFlag_.load()) {
+            tileQueue_.clear();  // Still arriving from an aborted generation
+            return false;
+        }
+        return tileQueue_.pop(tile);
+    }
+
+    /**
+     * Stop the running generation at its next band or stage boundary and
+     * go back to the terrain displayed before it (from the cache; if it has
+     * been evicted the partial terrain stays, as a preview result). Auto-
+     * upgrade holds off until the next generateAt()/generatePreview().
+     *
+     * Doesn't wait: isGenerating() stays true until update() collects the
+     * stopped generation, which then raises hasAbortedResult().
+     */
+    void abortGeneration();
+
     /**
      * Update state - call every frame
      * Handles auto-upgrade timer
@@ -61,6 +177,34 @@ public:
      */
     bool isGenerating() const { return isGenerating_; }
 
+    /**
+     * A new terrain (generated or from the cache) is ready to display.
+     * Cache hits complete inside generateAt()/update(), so callers can't
+     * rely on seeing isGenerating() go from true to false.
+     */
+    bool hasNewResult() const { return newResult_; }
+    void clearNewResult() { newResult_ = false; }
+
+    /**
+     * An aborted generation was collected and getHeightMap() is back to the
+     * terrain displayed before it (or the partial one, see abortGeneration()).
+     * Redraw anything its tiles were patched into.
+     */
+    bool hasAbortedResult() const { return abortedResult_; }
+    void clearAbortedResult() { abortedResult_ = false; }
+
+    /**
+     * Cache of finished terrains (budget, disk spill, statistics)
+     */
+    TerrainCache& getCache() { return cache_; }
+
+    /**
+     * Memory parked generators may hold (default 768 MB); the least
+     * recently used go first. 0 disables parking.
+     */
+    void setGeneratorPoolBudget(size_t bytes);
+    size_t getGeneratorPoolBudget() const { return generatorPoolBudget_; }
+
     /**
      * Get current heightmap (thread-safe)
      */
@@ -82,9 +226,32 @@ public:
     void setHeightMap(const HeightMap& newMap);
 
     /**
-     * Get current resolution
+     * Capture erosion by-product maps (flow, deposition, wear) during generation
+     */
+    void setCaptureErosionMaps(bool enabled);
+
+    /**
+     * Get erosion maps of the displayed terrain (null if not captured)
+     *
+     * A copy taken when the result is handed over, so it stays valid while
+     * the next generation rewrites the generator's own maps.
+     */
+    const ErosionMaps* getErosionMaps() const { return erosionMaps_.get(); }
+
+    /**
+     * Get current resolution (largest level not above the current size)
+     */
+    Resolution getCurrentResolution() const;
+
+    /**
+     * Size of the displayed terrain; previews can be any size
      */
-    Resolution getCurrentResolution() const { return currentRes_; }
+    int getCurrentSize() const { return currentSize_; }
+
+    /**
+     * Displayed terrain is a reduced preview (auto-upgrade will replace it)
+     */
+    bool isPreviewResult() const { return previewResult_; }
 
     /**
      * Get target resolution (may be higher if upgrading)
@@ -104,7 +271,9 @@ public:
     void onUserInteraction();
 
     /**
-     * Cancel any pending generation
+     * Cancel any pending generation. It stops early, leaving a partial
+     * height map for the caller's next generation (or import) to replace;
+     * use abortGeneration() to go back to the displayed terrain instead.
      */
     void cancelGeneration();
 
@@ -124,26 +293,111 @@ private:
     // Check if auto-upgrade should happen
     bool shouldAutoUpgrade() const;
 
-    // Start generation task
-    void startGeneration(Resolution res, const TerrainParams& params);
+    // Start generation task (or serve it from the cache). With refine, the
+    // previous generator's result seeds it (progressive mode)
+    void startGeneration(int size, const TerrainParams& params, bool preview, bool refine = false);
+
+    // Params for a level below the target: erosion scaled to size and, in
+    // progressive mode, scale shrunk so the level covers the target's area
+    TerrainParams levelParams(const TerrainParams& params, int size) const;
+
+    // Preview params: levelParams, then erosion cut by previewQuality_
+    TerrainParams previewParams(const TerrainParams& params, int size) const;
+
+    // Next size on the progressive chain towards the target
+    int nextLevelSize() const;
+
+    // Fold a measured generation time into the cost model
+    void recordGenerationTime(int size, bool preview, bool refined, double milliseconds);
+
+    // Install a cached terrain if it has everything this manager needs
+    bool restoreFromCache(const TerrainCache::Key& key);
+
+    // Copy the generator's erosion maps for getErosionMaps(); UI thread,
+    // with no generation running
+    void snapshotErosionMaps();
+
+    // Generator for size: the parked one if there is one, else a new one.
+    // Either way set up with this manager's options
+    std::unique_ptr<TerrainGenerator> takeGenerator(int size);
+
+    // Park an unused generator (replaces one parked at its size), then
+    // trim the pool to its budget
+    void parkGenerator(std::unique_ptr<TerrainGenerator> generator);
 
     // Check if async generation completed
     void checkGenerationComplete();
 
+    // Start the next uncached speculative candidate, if none is running
+    void startSpeculation();
+
+    // Abort the running speculative candidate without waiting; it goes back
+    // to the front of the queue
+    void cancelSpeculation();
+
     ThreadPool* threadPool_;
 
-    Resolution currentRes_;       // Currently displayed resolution
+    int currentSize_;             // Size of the displayed terrain
+    bool previewResult_;          // Displayed terrain came from generatePreview()
     Resolution targetRes_;        // Target for auto-upgrade
-    TerrainParams currentParams_; // Last parameters used
+    TerrainParams currentParams_; // Last parameters used (full quality)
 
     std::unique_ptr<TerrainGenerator> generator_;
-    std::future<void> generationFuture_;
+    std::unique_ptr<TerrainGenerator> coarseGenerator_;  // Level being refined (progressive mode)
+    std::vector<std::unique_ptr<TerrainGenerator>> parkedGenerators_;  // Least recently used first
+    size_t generatorPoolBudget_ = size_t(768) << 20;
+    std::future<double> generationFuture_;  // Yields wall time in ms
     bool isGenerating_;
+    bool newResult_;
+    bool abortedResult_ = false;
+    int pendingSize_;
+    bool pendingPreview_;
+
+    // Preview sizing
+    static constexpr int MIN_PREVIEW_SIZE = 64;
+    static constexpr int MAX_PREVIEW_SIZE = 512;
+    static constexpr int PREVIEW_SIZE_STEP = 32;
+    static constexpr int MAX_PREVIEW_QUALITY = 3;
+    double previewBudgetMs_ = 16.0;
+    double msPerPixel_ = 0.0;     // Smoothed preview cost per pixel, 0 until measured
+    int previewQuality_ = 0;      // 0 = full erosion work, each level halves it
+    double lastGenerationMs_ = 0.0;
+
+    TerrainCache cache_;
+    TerrainCache::Key pendingKey_;  // Cache key of the running generation
 
     // Auto-upgrade timer
     std::chrono::steady_clock::time_point lastInteraction_;
     static constexpr std::chrono::milliseconds upgradeDelay_{500};
 
-    // Flag to prevent duplicate generations
+    // Set by onUserInteraction(): the caller has params newer than
+    // currentParams_, so upgrading them would be wasted work
     bool paramsChanged_;
+
+    // Displayed terrain was generated from currentParams_ (not imported)
+    bool displayFromParams_;
+
+    bool captureErosionMaps_;
+    std::unique_ptr<ErosionMaps> erosionMaps_;  // Displayed terrain's, see getErosionMaps()
+    bool progressive_ = false;
+
+    // Tile streaming and cancellation
+    static constexpr int TILE_STREAM_MIN_SIZE = static_cast<int>(Resolution::HIGH);
+    bool tileStreaming_ = false;
+    TileQueue tileQueue_;
+    std::atomic<bool> abortFlag_{false};
+    bool upgradeHeld_ = false;                     // Set by abortGeneration()
+    TerrainCache::Key displayedKey_{0, 0};         // Cache key of the displayed terrain; {0, 0} if none
+
+    // Speculative pre-generation. A job is shared with its task, so real
+    // work can go ahead while it is still stopping
+    struct SpeculativeJob {
+        TerrainParams candidate;                      // Full-quality params
+        std::unique_ptr<TerrainGenerator> generator;
+        std::atomic<bool> abort{false};
+    };
+    bool speculative_ = false;
+    std::deque<TerrainParams> speculativeQueue_;    // Candidates, next first
+    std::shared_ptr<SpeculativeJob> speculativeJob_;
+    std::future<void> speculativeFuture_;
 };
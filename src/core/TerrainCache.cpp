@@ -0,0 +1,379 @@
+#include "TerrainCache.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr char SPILL_MAGIC[4] = {'Y', 'M', 'T', 'C'};
+constexpr uint32_t SPILL_VERSION = 1;
+constexpr uint8_t SPILL_HAS_EROSION = 1u << 0;
+constexpr uint8_t SPILL_EROSION_CAPTURED = 1u << 1;
+
+void writeMap(std::ofstream& file, const HeightMap& map) {
+    file.write(reinterpret_cast<const char*>(map.getData()), map.getSize() * sizeof(float));
+}
+
+void readMap(std::ifstream& file, HeightMap& map) {
+    file.read(reinterpret_cast<char*>(map.getData()), map.getSize() * sizeof(float));
+}
+
+void removeFiles(const std::vector<std::string>& paths) {
+    for (const std::string& path : paths) {
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+}
+
+TerrainCache::Entry::Entry(const HeightMap& map, const ErosionMaps* maps, bool captured)
+    : heightMap(map)
+    , erosionMaps(maps ? std::make_unique<ErosionMaps>(*maps) : nullptr)
+    , erosionCaptured(captured) {}
+
+TerrainCache::Entry::Entry(HeightMap&& map, std::unique_ptr<ErosionMaps> maps, bool captured)
+    : heightMap(std::move(map))
+    , erosionMaps(std::move(maps))
+    , erosionCaptured(captured) {}
+
+size_t TerrainCache::Entry::byteSize() const {
+    size_t floats = heightMap.getSize();
+    if (erosionMaps) {
+        floats += erosionMaps->flow.getSize() + erosionMaps->deposition.getSize() +
+                  erosionMaps->erosion.getSize();
+    }
+    return floats * sizeof(float);
+}
+
+TerrainCache::TerrainCache(size_t memoryBudget) : memoryBudget_(memoryBudget) {}
+
+TerrainCache::~TerrainCache() {
+    setDiskSpill("", 0);
+}
+
+std::shared_ptr<const TerrainCache::Entry> TerrainCache::lookup(const Key& key) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = memoryIndex_.find(key);
+        if (it != memoryIndex_.end()) {
+            memoryLru_.splice(memoryLru_.begin(), memoryLru_, it->second);
+            ++hits_;
+            return it->second->entry;
+        }
+
+        auto diskIt = diskIndex_.find(key);
+        if (diskIt == diskIndex_.end() && !spilling_.count(key)) {
+            ++misses_;
+            return nullptr;
+        }
+
+        // Unindex the file so nothing else touches it while it's read
+        if (diskIt != diskIndex_.end()) {
+            path = diskIt->second->path;
+            diskUsage_ -= diskIt->second->bytes;
+            diskLru_.erase(diskIt->second);
+            diskIndex_.erase(diskIt);
+        }
+    }
+
+    std::shared_ptr<const Entry> entry;
+    if (!path.empty()) {
+        entry = readSpill(path, key.resolution);
+        removeFiles({path});
+    }
+
+    std::vector<PendingSpill> spills;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Taking back an entry still being written makes the writer drop its file
+        auto spilling = spilling_.find(key);
+        if (spilling != spilling_.end()) {
+            entry = std::move(spilling->second);
+            spilling_.erase(spilling);
+        }
+
+        auto it = memoryIndex_.find(key);
+        if (it != memoryIndex_.end()) {
+            // Inserted again while the file was read
+            memoryLru_.splice(memoryLru_.begin(), memoryLru_, it->second);
+            entry = it->second->entry;
+        } else if (entry) {
+            // Back into memory as most recent; may spill something older
+            memoryLru_.push_front({key, entry});
+            memoryIndex_[key] = memoryLru_.begin();
+            memoryUsage_ += entry->byteSize();
+            trimMemory(spills);
+        }
+
+        if (entry) {
+            ++hits_;
+        } else {
+            ++misses_;
+        }
+    }
+
+    writeSpills(std::move(spills));
+    return entry;
+}
+
+bool TerrainCache::contains(const Key& key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryIndex_.count(key) || spilling_.count(key) || diskIndex_.count(key);
+}
+
+void TerrainCache::insert(const Key& key, const HeightMap& map,
+                          const ErosionMaps* erosionMaps, bool erosionCaptured) {
+    // Copy outside the lock; 4096^2 maps take a while
+    auto entry = std::make_shared<const Entry>(map, erosionMaps, erosionCaptured || erosionMaps);
+    size_t bytes = entry->byteSize();
+
+    std::vector<PendingSpill> spills;
+    std::vector<std::string> doomed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = memoryIndex_.find(key);
+        if (it != memoryIndex_.end()) {
+            memoryUsage_ -= it->second->entry->byteSize();
+            memoryLru_.erase(it->second);
+            memoryIndex_.erase(it);
+        }
+        spilling_.erase(key);
+        removeFromDisk(key, doomed);
+
+        // Unless it would evict everything and still not fit
+        if (bytes <= memoryBudget_) {
+            memoryLru_.push_front({key, std::move(entry)});
+            memoryIndex_[key] = memoryLru_.begin();
+            memoryUsage_ += bytes;
+            trimMemory(spills);
+        }
+    }
+
+    removeFiles(doomed);
+    writeSpills(std::move(spills));
+}
+
+void TerrainCache::trimMemory(std::vector<PendingSpill>& spills) {
+    while (memoryUsage_ > memoryBudget_ && !memoryLru_.empty()) {
+        MemorySlot& victim = memoryLru_.back();
+        size_t bytes = victim.entry->byteSize();
+
+        if (!spillDirectory_.empty() && bytes <= diskBudget_) {
+            spilling_[victim.key] = victim.entry;
+            spills.push_back({victim.key, victim.entry, spillPath(victim.key), spillEpoch_});
+        }
+
+        memoryUsage_ -= bytes;
+        memoryIndex_.erase(victim.key);
+        memoryLru_.pop_back();
+    }
+}
+
+void TerrainCache::trimDisk(std::vector<std::string>& doomed) {
+    while (diskUsage_ > diskBudget_ && !diskLru_.empty()) {
+        removeFromDisk(diskLru_.back().key, doomed);
+    }
+}
+
+void TerrainCache::removeFromDisk(const Key& key, std::vector<std::string>& doomed) {
+    auto it = diskIndex_.find(key);
+    if (it == diskIndex_.end()) return;
+
+    doomed.push_back(it->second->path);
+    diskUsage_ -= it->second->bytes;
+    diskLru_.erase(it->second);
+    diskIndex_.erase(it);
+}
+
+std::string TerrainCache::spillPath(const Key& key) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016llx_%d_%llu.ymc",
+                  static_cast<unsigned long long>(key.paramsHash), key.resolution,
+                  static_cast<unsigned long long>(nextSpillId_++));
+    return (fs::path(spillDirectory_) / name).string();
+}
+
+void TerrainCache::writeSpills(std::vector<PendingSpill> spills) {
+    for (PendingSpill& spill : spills) {
+        size_t written = 0;
+        bool saved = writeSpill(spill.path, *spill.entry, written);
+
+        std::vector<std::string> doomed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // Not wanted any more if it was looked up, replaced or cleared
+            // meanwhile, or the spill directory changed
+            auto it = spilling_.find(spill.key);
+            bool wanted = it != spilling_.end() && it->second == spill.entry;
+            if (wanted) {
+                spilling_.erase(it);
+            }
+
+            if (saved && wanted && spill.epoch == spillEpoch_) {
+                removeFromDisk(spill.key, doomed);
+                diskLru_.push_front({spill.key, written, spill.path});
+                diskIndex_[spill.key] = diskLru_.begin();
+                diskUsage_ += written;
+                trimDisk(doomed);
+            } else if (saved) {
+                doomed.push_back(spill.path);
+            }
+        }
+
+        removeFiles(doomed);
+    }
+}
+
+bool TerrainCache::writeSpill(const std::string& path, const Entry& entry, size_t& bytesWritten) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "TerrainCache: failed to spill to " << path << std::endl;
+        return false;
+    }
+
+    int32_t width = entry.heightMap.getWidth();
+    int32_t height = entry.heightMap.getHeight();
+    uint8_t flags = (entry.erosionMaps ? SPILL_HAS_EROSION : 0) |
+                    (entry.erosionCaptured ? SPILL_EROSION_CAPTURED : 0);
+
+    file.write(SPILL_MAGIC, sizeof(SPILL_MAGIC));
+    file.write(reinterpret_cast<const char*>(&SPILL_VERSION), sizeof(SPILL_VERSION));
+    file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+    file.write(reinterpret_cast<const char*>(&height), sizeof(height));
+    file.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+
+    writeMap(file, entry.heightMap);
+    if (entry.erosionMaps) {
+        writeMap(file, entry.erosionMaps->flow);
+        writeMap(file, entry.erosionMaps->deposition);
+        writeMap(file, entry.erosionMaps->erosion);
+    }
+
+    if (!file.good()) {
+        file.close();
+        removeFiles({path});
+        return false;
+    }
+
+    bytesWritten = static_cast<size_t>(file.tellp());
+    return true;
+}
+
+std::shared_ptr<const TerrainCache::Entry> TerrainCache::readSpill(const std::string& path, int resolution) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return nullptr;
+
+    char magic[sizeof(SPILL_MAGIC)];
+    uint32_t version = 0;
+    int32_t width = 0, height = 0;
+    uint8_t flags = 0;
+
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&width), sizeof(width));
+    file.read(reinterpret_cast<char*>(&height), sizeof(height));
+    file.read(reinterpret_cast<char*>(&flags), sizeof(flags));
+
+    if (!file.good() || !std::equal(magic, magic + sizeof(magic), SPILL_MAGIC) ||
+        version != SPILL_VERSION || width != resolution || height != resolution) {
+        return nullptr;
+    }
+
+    HeightMap map(width, height);
+    readMap(file, map);
+
+    std::unique_ptr<ErosionMaps> erosion;
+    if (flags & SPILL_HAS_EROSION) {
+        erosion = std::make_unique<ErosionMaps>(width, height);
+        readMap(file, erosion->flow);
+        readMap(file, erosion->deposition);
+        readMap(file, erosion->erosion);
+    }
+
+    if (!file.good()) return nullptr;
+
+    return std::make_shared<const Entry>(std::move(map), std::move(erosion),
+                                         (flags & SPILL_EROSION_CAPTURED) != 0);
+}
+
+void TerrainCache::setDiskSpill(const std::string& directory, size_t diskBudget) {
+    std::string spillDirectory = directory;
+    if (!spillDirectory.empty()) {
+        std::error_code ec;
+        fs::create_directories(spillDirectory, ec);
+        if (ec) {
+            std::cerr << "TerrainCache: can't create spill directory " << spillDirectory
+                      << ": " << ec.message() << std::endl;
+            spillDirectory.clear();
+        }
+    }
+
+    std::vector<std::string> doomed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Spilled files are only indexed by this instance; drop them on any change
+        while (!diskLru_.empty()) {
+            removeFromDisk(diskLru_.back().key, doomed);
+        }
+
+        spillDirectory_ = spillDirectory;
+        diskBudget_ = spillDirectory.empty() ? 0 : diskBudget;
+        ++spillEpoch_;
+    }
+
+    removeFiles(doomed);
+}
+
+void TerrainCache::setMemoryBudget(size_t bytes) {
+    std::vector<PendingSpill> spills;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memoryBudget_ = bytes;
+        trimMemory(spills);
+    }
+    writeSpills(std::move(spills));
+}
+
+void TerrainCache::clear() {
+    std::vector<std::string> doomed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memoryLru_.clear();
+        memoryIndex_.clear();
+        memoryUsage_ = 0;
+        spilling_.clear();
+        while (!diskLru_.empty()) {
+            removeFromDisk(diskLru_.back().key, doomed);
+        }
+    }
+    removeFiles(doomed);
+}
+
+size_t TerrainCache::getMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryUsage_;
+}
+
+size_t TerrainCache::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryLru_.size() + spilling_.size() + diskLru_.size();
+}
+
+size_t TerrainCache::getHitCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+size_t TerrainCache::getMissCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
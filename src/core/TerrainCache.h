@@ -0,0 +1,158 @@
+#pragma once
+
+#include "HeightMap.h"
+#include "TerrainParams.h"
+#include "../algorithms/ErosionMaps.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * TerrainCache - LRU cache of finished terrains
+ *
+ * Keyed by the generation params plus resolution, so returning to a preset
+ * or undoing a slider move finds the terrain generated earlier. The params'
+ * hash picks the bucket and the params themselves decide a hit. Entries are
+ * immutable and handed out as shared pointers, so a lookup never copies
+ * under the lock.
+ *
+ * The in-memory size is bounded by a byte budget. With a spill directory
+ * set, evicted entries are written there (bounded by a second budget) and
+ * loaded back on a later hit; otherwise they are dropped.
+ *
+ * Thread-safe. Spill files are written and read outside the lock, so a
+ * lookup that hits memory never waits on another thread's disk I/O.
+ */
+class TerrainCache {
+public:
+    struct Key {
+        uint64_t paramsHash;
+        int resolution;
+        TerrainParams params{};  // Generation fields; render-only ones left at defaults
+
+        bool operator==(const Key& other) const {
+            return paramsHash == other.paramsHash && resolution == other.resolution &&
+                   params == other.params;
+        }
+    };
+
+    struct Entry {
+        HeightMap heightMap;
+        std::unique_ptr<ErosionMaps> erosionMaps;  // Null if not captured or no erosion ran
+        bool erosionCaptured;                      // Generated with erosion map capture on
+
+        Entry(const HeightMap& map, const ErosionMaps* maps, bool captured);
+        Entry(HeightMap&& map, std::unique_ptr<ErosionMaps> maps, bool captured);
+        size_t byteSize() const;
+    };
+
+    explicit TerrainCache(size_t memoryBudget = size_t(512) << 20);
+    ~TerrainCache();
+
+    static Key makeKey(const TerrainParams& params, int resolution) {
+        TerrainParams generation;
+        TerrainParams::forEachGenerationField([&](const char*, auto member) {
+            generation.*member = params.*member;
+        });
+        return {params.generationHash(), resolution, generation};
+    }
+
+    // Progressive (coarse-to-fine) results only approximate a direct
+    // generation, so they're stored under a key of their own
+    static Key refinedKey(const Key& key) {
+        return {key.paramsHash ^ 0xA5F0C3E1D2B49687ull, key.resolution, key.params};
+    }
+
+    // Entry for key (promoted to most recent), or null on a miss
+    std::shared_ptr<const Entry> lookup(const Key& key);
+
+    // Key is cached (in memory or spilled); doesn't count as a hit or miss
+    bool contains(const Key& key) const;
+
+    // Store a copy of a finished terrain; replaces any entry under key
+    void insert(const Key& key, const HeightMap& map,
+                const ErosionMaps* erosionMaps = nullptr, bool erosionCaptured = false);
+
+    /**
+     * Spill evicted entries to directory (created if missing), keeping at
+     * most diskBudget bytes there. An empty directory disables spilling and
+     * deletes spilled files.
+     */
+    void setDiskSpill(const std::string& directory, size_t diskBudget);
+
+    void setMemoryBudget(size_t bytes);
+    void clear();
+
+    size_t getMemoryUsage() const;
+    size_t getEntryCount() const;
+    size_t getHitCount() const;
+    size_t getMissCount() const;
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return static_cast<size_t>(key.paramsHash ^ (static_cast<uint64_t>(key.resolution) * 0x9E3779B97F4A7C15ull));
+        }
+    };
+
+    struct MemorySlot {
+        Key key;
+        std::shared_ptr<const Entry> entry;
+    };
+
+    struct DiskSlot {
+        Key key;
+        size_t bytes;
+        std::string path;
+    };
+
+    // Evicted entry waiting to be written out
+    struct PendingSpill {
+        Key key;
+        std::shared_ptr<const Entry> entry;
+        std::string path;
+        uint64_t epoch;  // spillEpoch_ when evicted
+    };
+
+    // The helpers below run with mutex_ held and only collect disk work;
+    // callers do it with writeSpills() and removeFiles() after unlocking
+
+    // Evict least recently used entries until memory fits
+    void trimMemory(std::vector<PendingSpill>& spills);
+    void trimDisk(std::vector<std::string>& doomed);
+    void removeFromDisk(const Key& key, std::vector<std::string>& doomed);
+    std::string spillPath(const Key& key);
+
+    // Write evicted entries and index the ones still wanted; takes mutex_
+    void writeSpills(std::vector<PendingSpill> spills);
+
+    static bool writeSpill(const std::string& path, const Entry& entry, size_t& bytesWritten);
+    static std::shared_ptr<const Entry> readSpill(const std::string& path, int resolution);
+
+    mutable std::mutex mutex_;
+
+    // Most recent at the front
+    std::list<MemorySlot> memoryLru_;
+    std::unordered_map<Key, std::list<MemorySlot>::iterator, KeyHash> memoryIndex_;
+    size_t memoryUsage_ = 0;
+    size_t memoryBudget_;
+
+    std::list<DiskSlot> diskLru_;
+    std::unordered_map<Key, std::list<DiskSlot>::iterator, KeyHash> diskIndex_;
+    size_t diskUsage_ = 0;
+    size_t diskBudget_ = 0;
+    std::string spillDirectory_;
+    uint64_t spillEpoch_ = 0;   // Bumped when the spill directory changes
+    uint64_t nextSpillId_ = 0;  // Spill files are never reused, so writes can't collide
+
+    // Evicted but not yet on disk; lookups still hit these
+    std::unordered_map<Key, std::shared_ptr<const Entry>, KeyHash> spilling_;
+
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
@@ -8,7 +8,118 @@
 #include "../algorithms/ThermalErosion.h"
 #include "../algorithms/HydraulicErosion.h"
 #include "../algorithms/RiverEnhancements.h"
+#include <algorithm>
 #include <cmath>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+// Catmull-Rom taps for one output coordinate; indices clamped to the source
+struct CubicTaps {
+    int index[4];
+    float weight[4];
+};
+
+CubicTaps cubicTaps(float coord, int size) {
+    int i = static_cast<int>(std::floor(coord));
+    float t = coord - i;
+    float t2 = t * t;
+    float t3 = t2 * t;
+
+    CubicTaps taps;
+    taps.weight[0] = 0.5f * (-t3 + 2.0f * t2 - t);
+    taps.weight[1] = 0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f);
+    taps.weight[2] = 0.5f * (-3.0f * t3 + 4.0f * t2 + t);
+    taps.weight[3] = 0.5f * (t3 - t2);
+    for (int k = 0; k < 4; ++k) {
+        taps.index[k] = std::clamp(i - 1 + k, 0, size - 1);
+    }
+    return taps;
+}
+
+/**
+ * Upsampling for progressive refinement: output pixel d lies at source
+ * coordinate d * ratio + origin. Rows are filtered vertically into column
+ * (source width) first, so each output pixel costs 4 taps instead of 16.
+ */
+class Upsampler {
+public:
+    Upsampler(const HeightMap& src, float ratio, float origin, int outX0, int outWidth)
+        : src_(src), ratio_(ratio), origin_(origin) {
+        xTaps_.reserve(outWidth);
+        for (int x = 0; x < outWidth; ++x) {
+            xTaps_.push_back(cubicTaps((outX0 + x) * ratio + origin, src.getWidth()));
+        }
+    }
+
+    // Adds output row y to out, using column as scratch
+    void addRow(int y, float* out, std::vector<float>& column) const {
+        int srcWidth = src_.getWidth();
+        column.assign(srcWidth, 0.0f);
+
+        CubicTaps yTaps = cubicTaps(y * ratio_ + origin_, src_.getHeight());
+        for (int k = 0; k < 4; ++k) {
+            const float* srcRow = src_.getData() + static_cast<size_t>(yTaps.index[k]) * srcWidth;
+            float w = yTaps.weight[k];
+            for (int x = 0; x < srcWidth; ++x) {
+                column[x] += srcRow[x] * w;
+            }
+        }
+
+        for (size_t x = 0; x < xTaps_.size(); ++x) {
+            const CubicTaps& taps = xTaps_[x];
+            out[x] += column[taps.index[0]] * taps.weight[0] + column[taps.index[1]] * taps.weight[1] +
+                      column[taps.index[2]] * taps.weight[2] + column[taps.index[3]] * taps.weight[3];
+        }
+    }
+
+private:
+    const HeightMap& src_;
+    float ratio_;
+    float origin_;
+    std::vector<CubicTaps> xTaps_;
+};
+
+// Adds src upsampled to dst's size (same world area, pixel 0 aligned)
+void addUpsampled(const HeightMap& src, HeightMap& dst, ThreadPool* pool, bool clampNegative) {
+    int width = dst.getWidth();
+    float ratio = static_cast<float>(src.getWidth()) / width;
+    Upsampler upsampler(src, ratio, 0.0f, 0, width);
+    float* data = dst.getData();
+
+    pool->parallelFor(0, dst.getHeight(), [&](size_t y) {
+        thread_local std::vector<float> column;
+        float* row = data + y * width;
+        upsampler.addRow(static_cast<int>(y), row, column);
+        if (clampNegative) {
+            for (int x = 0; x < width; ++x) {
+                row[x] = std::max(0.0f, row[x]);
+            }
+        }
+    }, 8);
+}
+
+// Coarse and fine params sample the same noise (up to the size ratio)
+bool sameNoise(const TerrainParams& coarse, const TerrainParams& fine, float ratio) {
+    return coarse.seed == fine.seed && coarse.octaves == fine.octaves &&
+           coarse.persistence == fine.persistence && coarse.lacunarity == fine.lacunarity &&
+           std::abs(coarse.scale - fine.scale * ratio) <= 1e-4f * fine.scale;
+}
+
+// Same erosion apart from the work counts, which are scaled per level
+bool sameErosion(const TerrainParams& coarse, const TerrainParams& fine) {
+    return coarse.erosion == fine.erosion &&
+           coarse.thermalErosionEnabled == fine.thermalErosionEnabled &&
+           coarse.thermalTalusAngle == fine.thermalTalusAngle &&
+           coarse.thermalRate == fine.thermalRate &&
+           coarse.hydraulicErosionEnabled == fine.hydraulicErosionEnabled &&
+           coarse.hydraulicLifetime == fine.hydraulicLifetime &&
+           coarse.hydraulicInertia == fine.hydraulicInertia &&
+           coarse.hydraulicCapacity == fine.hydraulicCapacity &&
+           coarse.hydraulicErosion == fine.hydraulicErosion &&
+           coarse.hydraulicDeposition == fine.hydraulicDeposition;
+}
+}
 
 TerrainGenerator::TerrainGenerator(int width, int height, ThreadPool* threadPool)
     : width_(width)
@@ -36,56 +147,117 @@ std::future<void> TerrainGenerator::generateAsync(const TerrainParams& params) {
     });
 }
 
+void TerrainGenerator::setErosionMaps(const ErosionMaps* maps) {
+    if (!maps) {
+        erosionMaps_.reset();
+    } else if (erosionMaps_ && erosionMaps_->getWidth() == maps->getWidth() &&
+               erosionMaps_->getHeight() == maps->getHeight()) {
+        *erosionMaps_ = *maps;
+    } else {
+        erosionMaps_ = std::make_unique<ErosionMaps>(*maps);
+    }
+}
+
+size_t TerrainGenerator::getMemoryUsage() const {
+    size_t floats = heightMap_.getSize() + workBuffer_.getSize() +
+                    edgeDistanceCache_.distanceMap.size();
+    if (erosionMaps_) {
+        floats += erosionMaps_->flow.getSize() + erosionMaps_->deposition.getSize() +
+                  erosionMaps_->erosion.getSize();
+    }
+    if (progressiveLevel_) {
+        floats += progressiveLevel_->lowOctaves.getSize();
+        if (progressiveLevel_->erosionDelta) {
+            floats += progressiveLevel_->erosionDelta->getSize();
+        }
+    }
+    return floats * sizeof(float);
+}
+
 void TerrainGenerator::generate(const TerrainParams& params) {
+    generateLevel(params, nullptr);
+}
+
+void TerrainGenerator::generateRefined(const TerrainParams& params, const TerrainGenerator& coarse) {
+    const ProgressiveLevel* level = coarse.progressiveLevel_.get();
+    bool usable = level && &coarse != this &&
+                  coarse.width_ <= width_ && coarse.height_ <= height_ &&
+                  static_cast<long long>(coarse.width_) * height_ ==
+                      static_cast<long long>(coarse.height_) * width_ &&
+                  sameNoise(level->params, params, static_cast<float>(coarse.width_) / width_);
+
+    generateLevel(params, usable ? &coarse : nullptr);
+}
+
+void TerrainGenerator::generateLevel(const TerrainParams& params, const TerrainGenerator* coarse) {
     generating_.store(true);
+    aborted_ = false;
 
     // Initialize noise generator with seed
     perlin_ = std::make_unique<PerlinNoise>(params.seed);
 
-    // Clear heightmap
-    {
-        std::lock_guard<std::mutex> lock(heightMapMutex_);
-        heightMap_.clear();
+    // Point-wise stages run fused, one row at a time; erosion reads
+    // neighbors, so when enabled it splits them into two passes
+    unsigned lateStages = 0;
+    if (params.peaks > 0.01f) lateStages |= STAGE_PEAKS;
+    if (params.island > 0.01f) lateStages |= STAGE_ISLAND;
+    if (params.terracing > 0) lateStages |= STAGE_TERRACE;
+
+    // Drop by-product maps from the previous run; applyErosion refills them
+    erosionMaps_.reset();
+    progressiveLevel_.reset();
+    refined_ = coarse != nullptr;
+
+    // Checked between stages; what's left of the map is partial
+    auto stopped = [this]() {
+        if (!abortRequested()) return false;
+        aborted_ = true;
+        refined_ = false;
+        erosionMaps_.reset();
+        progressiveLevel_.reset();
+        generating_.store(false);
+        return true;
+    };
+
+    if (coarse || keepProgressiveLevel_) {
+        // Unfused: the base noise pass also builds the level's octave sum
+        progressiveBaseNoise(params, coarse);
+        if (stopped()) return;
+        if (params.erosion > 0.01f) {
+            progressiveErosion(params, coarse);
+            if (stopped()) return;
+        }
+        applyPointStages(params, lateStages);
+    } else if (params.erosion > 0.01f) {
+        // Base noise overwrites every pixel, so no clear is needed
+        applyPointStages(params, STAGE_BASE_NOISE);
+        if (stopped()) return;
+        applyErosion(params);
+        if (stopped()) return;
+        applyPointStages(params, lateStages);
+    } else {
+        applyPointStages(params, STAGE_BASE_NOISE | lateStages);
     }
-
-    // Generate base noise
-    generateBaseNoise(params);
+    if (stopped()) return;
 
     // Apply valley effect
     if (params.valleyStrength > 0.01f) {
         applyValleys(params);
     }
 
-    // Apply erosion
-    if (params.erosion > 0.01f) {
-        applyErosion(params);
-    }
-
-    // Apply mountain peaks
-    if (params.peaks > 0.01f) {
-        applyPeaks(params);
-    }
-
-    // Apply island mode
-    if (params.island > 0.01f) {
-        applyIslandMask(params);
-    }
-
-    // Apply terracing
-    if (params.terracing > 0) {
-        applyTerracing(params);
-    }
-
     if (params.edgePadding > 0.01f) {
         applyEdgePadding(params);
+        if (stopped()) return;
     }
 
     if (params.terrainSmoothness > 0.01f) {
         softenTerrain(params);
+        if (stopped()) return;
     }
 
     if (params.riverIntensity > 0.01f) {
         applyRivers(params);
+        if (stopped()) return;
     }
 
     // Normalize to 0-1 range
@@ -97,30 +269,6 @@ void TerrainGenerator::generate(const TerrainParams& params) {
     generating_.store(false);
 }
 
-void TerrainGenerator::generateBaseNoise(const TerrainParams& params) {
-    std::lock_guard<std::mutex> lock(heightMapMutex_);
-
-    threadPool_->parallelFor(0, height_, [this, &params](size_t y) {
-        for (int x = 0; x < width_; ++x) {
-            float nx = x / params.scale;
-            float ny = y / params.scale;
-
-            float height = perlin_->octaveNoise(nx, ny,
-                                               params.octaves,
-                                               params.persistence,
-                                               params.lacunarity);
-
-            // Normalize from [-1, 1] to [0, 1]
-            height = (height + 1.0f) * 0.5f;
-
-            // Apply curve for gradual transitions
-            height = std::pow(height, 1.2f);
-
-            heightMap_.at(x, static_cast<int>(y)) = height;
-        }
-    }, 16);  // Process 16 rows per task
-}
-
 void TerrainGenerator::applyValleys(const TerrainParams& params) {
     // Valley generation is handled by valley flattening later in pipeline
     // This placeholder is kept for potential future multi-pass valley effects
@@ -132,6 +280,117 @@ void TerrainGenerator::smoothValleyFloors(const TerrainParams& params) {
     (void)params;
 }
 
+HeightMap TerrainGenerator::generateChunk(int chunkX, int chunkY, int size,
+                                          const TerrainParams& params,
+                                          ThreadPool* pool) {
+    if (size <= 0) {
+        throw std::invalid_argument("TerrainGenerator::generateChunk: size must be positive");
+    }
+
+    bool erosion = params.erosion > 0.01f;
+    bool thermal = erosion && params.thermalErosionEnabled && params.thermalIterations > 0;
+    bool simple = erosion && !params.thermalErosionEnabled;
+    bool soften = params.terrainSmoothness > 0.01f;
+
+    // Pixels each neighborhood stage needs beyond what it must get right.
+    // A thermal pass reaches 2 px (what a cell receives depends on the
+    // neighbors of the cell sending it), plus one for the border cells it
+    // leaves alone. Legacy erosion is a single pass that reads 4-neighbors
+    // and only writes the cell itself, so just its untouched border is wrong.
+    int apron = 0;
+    if (thermal) apron += 2 * params.thermalIterations + 1;
+    if (simple) apron += 1;
+    if (soften) apron += SOFTEN_RADIUS * SOFTEN_PASSES;
+
+    int chunkWorldX = chunkX * size;
+    int chunkWorldY = chunkY * size;
+    int worldX0 = chunkWorldX - apron;
+    int worldY0 = chunkWorldY - apron;
+
+    // Thermal bands start at the buffer's second row. Starting the buffer one
+    // row before a band multiple puts bands on the same world rows in every
+    // chunk, so cross-band deposits are summed in the same order.
+    if (thermal) {
+        const int band = ThermalErosion::BAND_ROWS;
+        int start = worldY0 + 1;
+        int aligned = (start >= 0) ? (start / band) * band : -((-start + band - 1) / band) * band;
+        worldY0 = aligned - 1;
+    }
+
+    int bufferWidth = chunkWorldX + size + apron - worldX0;
+    int bufferHeight = chunkWorldY + size + apron - worldY0;
+    HeightMap buffer(bufferWidth, bufferHeight);
+    float* data = buffer.getData();
+
+    PerlinNoise baseNoise(params.seed);
+    PerlinNoise peakNoise(params.seed);
+    bool peaks = params.peaks > 0.01f;
+    bool terrace = params.terracing > 0;
+
+    auto forEachRow = [&](const std::function<void(size_t)>& func) {
+        if (pool) {
+            pool->parallelFor(0, bufferHeight, func, 8);
+        } else {
+            for (int y = 0; y < bufferHeight; ++y) {
+                func(y);
+            }
+        }
+    };
+
+    auto lateStages = [&](float* row, int worldY) {
+        if (peaks) {
+            Peaks::applyRow(row, worldX0, worldY, bufferWidth, params.peaks, peakNoise);
+        }
+        if (terrace) {
+            terraceRow(row, bufferWidth, params.terracing);
+        }
+    };
+
+    // Same stage order as generate(), fused per row around the erosion barrier
+    forEachRow([&](size_t y) {
+        float* row = data + y * bufferWidth;
+        int worldY = worldY0 + static_cast<int>(y);
+        baseNoiseRow(baseNoise, params, worldX0, worldY, bufferWidth, row);
+        if (!erosion) {
+            lateStages(row, worldY);
+        }
+    });
+
+    if (erosion) {
+        if (thermal) {
+            ThermalErosion::apply(buffer, thermalParamsFor(params), pool);
+        }
+        if (simple) {
+            HeightMap scratch(bufferWidth, bufferHeight);
+            simpleErosion(buffer, scratch, params.erosion, pool, nullptr);
+            data = buffer.getData();
+        }
+
+        forEachRow([&](size_t y) {
+            lateStages(data + y * bufferWidth, worldY0 + static_cast<int>(y));
+        });
+    }
+
+    if (soften) {
+        TerrainSoftening::executeAtElevation(buffer, params.terrainSmoothness,
+                                             params.softeningThreshold,
+                                             SOFTEN_RADIUS, SOFTEN_PASSES, pool);
+    }
+
+    // Crop the apron
+    HeightMap chunk(size, size);
+    const float* src = buffer.getData() + static_cast<size_t>(chunkWorldY - worldY0) * bufferWidth
+                       + (chunkWorldX - worldX0);
+    float* dst = chunk.getData();
+    for (int y = 0; y < size; ++y) {
+        std::copy(src + static_cast<size_t>(y) * bufferWidth,
+                  src + static_cast<size_t>(y) * bufferWidth + size,
+                  dst + static_cast<size_t>(y) * size);
+    }
+
+    return chunk;
+}
+
 void TerrainGenerator::applyErosion(const TerrainParams& params) {
     if (params.erosion < 0.01f && !params.thermalErosionEnabled && !params.hydraulicErosionEnabled) {
         return;  // No erosion to apply
@@ -139,14 +398,14 @@ void TerrainGenerator::applyErosion(const TerrainParams& params) {
 
     std::lock_guard<std::mutex> lock(heightMapMutex_);
 
+    if (captureErosionMaps_) {
+        erosionMaps_ = std::make_unique<ErosionMaps>(width_, height_);
+    }
+    ErosionMaps* maps = erosionMaps_.get();
+
     // Apply thermal erosion (cliff collapse, talus slopes)
     if (params.thermalErosionEnabled && params.thermalIterations > 0) {
-        ThermalErosion::Params thermalParams;
-        thermalParams.talusAngle = params.thermalTalusAngle;
-        thermalParams.thermalRate = params.thermalRate * params.erosion;  // Scale by master erosion
-        thermalParams.iterations = params.thermalIterations;
-
-        ThermalErosion::apply(heightMap_, thermalParams, threadPool_);
+        ThermalErosion::apply(heightMap_, thermalParamsFor(params), threadPool_, maps);
     }
 
     // Apply hydraulic erosion (water droplet simulation)
@@ -159,50 +418,106 @@ void TerrainGenerator::applyErosion(const TerrainParams& params) {
         hydraulicParams.erosion_rate = params.hydraulicErosion * params.erosion;  // Scale by master erosion
         hydraulicParams.deposition_rate = params.hydraulicDeposition;
 
-        HydraulicErosion::apply(heightMap_, hydraulicParams, threadPool_, params.hydraulicIterations);
+        HydraulicErosion::apply(heightMap_, hydraulicParams, threadPool_, params.hydraulicIterations, maps);
     }
 
     // Apply legacy simple erosion if thermal is disabled
     if (!params.thermalErosionEnabled && params.erosion > 0.01f) {
-        workBuffer_ = heightMap_;
-
-        threadPool_->parallelFor(1, height_ - 1, [this, &params](size_t y) {
-            int yi = static_cast<int>(y);
-            for (int x = 1; x < width_ - 1; ++x) {
-                float current = heightMap_.at(x, yi);
-
-                // Sample 4-neighbors
-                float top = heightMap_.at(x, yi - 1);
-                float bottom = heightMap_.at(x, yi + 1);
-                float left = heightMap_.at(x - 1, yi);
-                float right = heightMap_.at(x + 1, yi);
+        simpleErosion(heightMap_, workBuffer_, params.erosion, threadPool_, maps);
+    }
+}
 
-                float avgNeighbor = (top + bottom + left + right) * 0.25f;
+ThermalErosion::Params TerrainGenerator::thermalParamsFor(const TerrainParams& params) {
+    ThermalErosion::Params thermalParams;
+    thermalParams.talusAngle = params.thermalTalusAngle;
+    thermalParams.thermalRate = params.thermalRate * params.erosion;  // Scale by master erosion
+    thermalParams.iterations = params.thermalIterations;
+    return thermalParams;
+}
 
-                // Erode high peaks
-                if (current > avgNeighbor) {
-                    float diff = (current - avgNeighbor) * params.erosion * 0.3f;
-                    workBuffer_.at(x, yi) = current - diff;
+void TerrainGenerator::simpleErosion(HeightMap& map, HeightMap& scratch, float erosion,
+                                     ThreadPool* pool, ErosionMaps* maps) {
+    int width = map.getWidth();
+    int height = map.getHeight();
+    scratch = map;
+
+    const float* src = map.getData();
+    float* dst = scratch.getData();
+    float* erosionOut = maps ? maps->erosion.getData() : nullptr;
+
+    auto processRow = [&](size_t y) {
+        size_t rowOffset = y * width;
+        for (int x = 1; x < width - 1; ++x) {
+            size_t idx = rowOffset + x;
+            float current = src[idx];
+
+            // Sample 4-neighbors
+            float top = src[idx - width];
+            float bottom = src[idx + width];
+            float left = src[idx - 1];
+            float right = src[idx + 1];
+
+            float avgNeighbor = (top + bottom + left + right) * 0.25f;
+
+            // Erode high peaks
+            if (current > avgNeighbor) {
+                float diff = (current - avgNeighbor) * erosion * 0.3f;
+                dst[idx] = current - diff;
+
+                // Only the cell itself changes, so rows never overlap
+                if (erosionOut) {
+                    erosionOut[idx] += diff;
                 }
             }
-        }, 8);
+        }
+    };
 
-        heightMap_ = workBuffer_;
+    if (pool) {
+        pool->parallelFor(1, height - 1, processRow, 8);
+    } else {
+        for (int y = 1; y < height - 1; ++y) {
+            processRow(y);
+        }
     }
+
+    map = scratch;
 }
 
-void TerrainGenerator::applyPeaks(const TerrainParams& params) {
-    std::lock_guard<std::mutex> lock(heightMapMutex_);
-    Peaks::execute(heightMap_, params.peaks, params.seed, threadPool_);
+void TerrainGenerator::baseNoiseRow(const PerlinNoise& noise, const TerrainParams& params,
+                                    int xStart, int y, int width, float* row) {
+    noise.octaveNoiseRow(xStart, params.scale, y / params.scale, width,
+                         params.octaves, params.persistence, params.lacunarity, row);
+    baseCurveRow(row, width);
+}
+
+void TerrainGenerator::baseCurveRow(float* row, int width) {
+    for (int x = 0; x < width; ++x) {
+        // Normalize from [-1, 1] to [0, 1]
+        float height = (row[x] + 1.0f) * 0.5f;
+
+        // Apply curve for gradual transitions
+        row[x] = std::pow(height, 1.2f);
+    }
+}
+
+void TerrainGenerator::terraceRow(float* row, int width, int steps) {
+    for (int x = 0; x < width; ++x) {
+        row[x] = std::floor(row[x] * steps) / steps;
+    }
 }
 
-void TerrainGenerator::applyIslandMask(const TerrainParams& params) {
+void TerrainGenerator::applyPointStages(const TerrainParams& params, unsigned stages) {
+    if (stages == 0) return;
+
     std::lock_guard<std::mutex> lock(heightMapMutex_);
 
-    if (params.archipelagoMode) {
-        // Generate multiple islands
-        applyArchipelagoMask(params);
-        return;
+    // Per-pass setup shared by every row
+    PerlinNoise peakNoise(params.seed);
+    std::unique_ptr<ArchipelagoMask> archipelago;
+    if ((stages & STAGE_ISLAND) && params.archipelagoMode) {
+        archipelago = std::make_unique<ArchipelagoMask>(
+            placeIslands(params), params.seed + 1000, params.archipelagoVariation,
+            params.islandShape, width_, height_);
     }
 
     // Single island mode (original behavior)
@@ -210,25 +525,202 @@ void TerrainGenerator::applyIslandMask(const TerrainParams& params) {
     float centerY = height_ * 0.5f;
     float maxDist = std::sqrt(centerX * centerX + centerY * centerY);
 
-    threadPool_->parallelFor(0, height_, [this, &params, centerX, centerY, maxDist](size_t y) {
+    float* data = heightMap_.getData();
+
+    // Each row goes through every enabled stage while it is still in cache,
+    // instead of one full-map read/write per stage
+    forEachRowBand(height_, 0, [&](size_t y) {
         int yi = static_cast<int>(y);
-        for (int x = 0; x < width_; ++x) {
-            float dx = x - centerX;
+        float* row = data + y * width_;
+
+        if (stages & STAGE_BASE_NOISE) {
+            baseNoiseRow(*perlin_, params, 0, yi, width_, row);
+        }
+
+        if (stages & STAGE_PEAKS) {
+            Peaks::applyRow(row, 0, yi, width_, params.peaks, peakNoise);
+        }
+
+        if ((stages & STAGE_ISLAND) && archipelago) {
+            thread_local std::vector<float> islandEffect;
+            islandEffect.resize(width_);
+            archipelago->evaluateRow(yi, islandEffect.data());
+
+            for (int x = 0; x < width_; ++x) {
+                float totalIslandEffect = islandEffect[x];
+
+                // Apply island mask
+                float masked = row[x] * ((1.0f - params.island) + (totalIslandEffect * params.island));
+
+                // Push underwater areas deeper
+                if (totalIslandEffect < 0.1f) {
+                    masked *= 0.3f;  // Ocean floor
+                }
+
+                row[x] = masked;
+            }
+        } else if (stages & STAGE_ISLAND) {
             float dy = y - centerY;
-            float dist = std::sqrt(dx * dx + dy * dy);
-            float normalizedDist = dist / maxDist;
+            for (int x = 0; x < width_; ++x) {
+                float dx = x - centerX;
+                float dist = std::sqrt(dx * dx + dy * dy);
+                float normalizedDist = dist / maxDist;
 
-            // Create gradient falloff
-            float falloff = 1.0f - std::pow(normalizedDist, 1.5f);
-            float islandEffect = std::max(0.0f, falloff);
+                // Create gradient falloff
+                float falloff = 1.0f - std::pow(normalizedDist, 1.5f);
+                float islandEffect = std::max(0.0f, falloff);
 
-            // Blend with island strength
-            heightMap_.at(x, yi) *= (1.0f - params.island) + (islandEffect * params.island);
+                // Blend with island strength
+                row[x] *= (1.0f - params.island) + (islandEffect * params.island);
+            }
         }
-    }, 8);
+
+        if (stages & STAGE_TERRACE) {
+            terraceRow(row, width_, params.terracing);
+        }
+    });
+}
+
+void TerrainGenerator::forEachRowBand(int count, int rowOffset, const std::function<void(size_t)>& rowFn) {
+    if (!tileQueue_) {
+        threadPool_->parallelFor(0, count, [&](size_t row) {
+            if (abortRequested()) return;
+            rowFn(row);
+        }, 8);
+        return;
+    }
+
+    int bands = (count + TILE_ROWS - 1) / TILE_ROWS;
+    threadPool_->parallelFor(0, bands, [&](size_t band) {
+        if (abortRequested()) return;
+
+        int first = static_cast<int>(band) * TILE_ROWS;
+        int last = std::min(count, first + TILE_ROWS);
+        for (int row = first; row < last; ++row) {
+            rowFn(row);
+        }
+
+        // Publish the map rows this band finished
+        int y0 = std::max(0, first - rowOffset);
+        int y1 = std::min(height_, last - rowOffset);
+        if (y1 <= y0) return;
+
+        TerrainTile tile;
+        tile.x = 0;
+        tile.y = y0;
+        tile.width = width_;
+        tile.height = y1 - y0;
+        tile.mapWidth = width_;
+        tile.mapHeight = height_;
+        const float* src = heightMap_.getData() + static_cast<size_t>(y0) * width_;
+        tile.heights.assign(src, src + static_cast<size_t>(tile.height) * width_);
+        tileQueue_->push(std::move(tile));
+    }, 1);
 }
 
-void TerrainGenerator::applyArchipelagoMask(const TerrainParams& params) {
+void TerrainGenerator::progressiveBaseNoise(const TerrainParams& params, const TerrainGenerator* coarse) {
+    std::lock_guard<std::mutex> lock(heightMapMutex_);
+
+    const ProgressiveLevel* coarseLevel = coarse ? coarse->progressiveLevel_.get() : nullptr;
+
+    // Octaves this level resolves; the coarse level's are taken from it
+    int resolved = 0;
+    float wavelength = params.scale;
+    while (resolved < params.octaves && wavelength >= PROGRESSIVE_MIN_WAVELENGTH) {
+        ++resolved;
+        wavelength /= params.lacunarity;
+    }
+    int inherited = coarseLevel ? coarseLevel->octaves : 0;
+    resolved = std::max(resolved, inherited);
+
+    // Octave sum over the map plus apron, so the next level's bicubic taps
+    // never clamp inside the map
+    auto level = std::make_unique<ProgressiveLevel>(params, width_, height_);
+    int apronWidth = width_ + 3;
+    float maxValue = PerlinNoise::amplitudeSum(params.octaves, params.persistence);
+
+    std::unique_ptr<Upsampler> upsampler;
+    if (coarseLevel) {
+        float ratio = static_cast<float>(coarse->width_) / width_;
+        upsampler = std::make_unique<Upsampler>(coarseLevel->lowOctaves, ratio, 1.0f, -1, apronWidth);
+    }
+
+    float* data = heightMap_.getData();
+    float* lowData = level->lowOctaves.getData();
+
+    forEachRowBand(height_ + 3, 1, [&](size_t apronY) {
+        int y = static_cast<int>(apronY) - 1;
+        float* low = lowData + apronY * apronWidth;
+
+        if (upsampler) {
+            thread_local std::vector<float> column;
+            upsampler->addRow(y, low, column);
+        }
+        perlin_->addOctavesRow(-1, params.scale, y / params.scale, apronWidth, inherited, resolved,
+                               params.persistence, params.lacunarity, low);
+
+        if (y < 0 || y >= height_) return;
+
+        float* row = data + static_cast<size_t>(y) * width_;
+        std::copy(low + 1, low + 1 + width_, row);
+        perlin_->addOctavesRow(0, params.scale, y / params.scale, width_, resolved, params.octaves,
+                               params.persistence, params.lacunarity, row);
+        for (int x = 0; x < width_; ++x) {
+            row[x] /= maxValue;
+        }
+        baseCurveRow(row, width_);
+    });
+
+    if (keepProgressiveLevel_) {
+        level->octaves = resolved;
+        progressiveLevel_ = std::move(level);
+    }
+}
+
+void TerrainGenerator::progressiveErosion(const TerrainParams& params, const TerrainGenerator* coarse) {
+    const ProgressiveLevel* coarseLevel = coarse ? coarse->progressiveLevel_.get() : nullptr;
+    bool reuse = coarseLevel && coarseLevel->erosionDelta && sameErosion(coarseLevel->params, params);
+
+    std::unique_ptr<HeightMap> before;
+    if (progressiveLevel_) {
+        before = std::make_unique<HeightMap>(heightMap_);
+    }
+
+    TerrainParams erosionParams = params;
+    if (reuse) {
+        float ratio = static_cast<float>(coarse->width_) / width_;
+        {
+            std::lock_guard<std::mutex> lock(heightMapMutex_);
+            addUpsampled(*coarseLevel->erosionDelta, heightMap_, threadPool_, false);
+        }
+
+        // Large-scale slumping and drainage are already in place
+        erosionParams.thermalIterations = std::max(1, static_cast<int>(std::lround(params.thermalIterations * ratio)));
+        erosionParams.hydraulicDroplets = std::max(1, static_cast<int>(params.hydraulicDroplets * (1.0f - ratio * ratio)));
+    }
+
+    applyErosion(erosionParams);
+
+    std::lock_guard<std::mutex> lock(heightMapMutex_);
+
+    // Masks cover the whole simulation: coarse pass plus refinement
+    if (reuse && erosionMaps_ && coarse->erosionMaps_) {
+        addUpsampled(coarse->erosionMaps_->flow, erosionMaps_->flow, threadPool_, true);
+        addUpsampled(coarse->erosionMaps_->deposition, erosionMaps_->deposition, threadPool_, true);
+        addUpsampled(coarse->erosionMaps_->erosion, erosionMaps_->erosion, threadPool_, true);
+    }
+
+    if (before) {
+        const float* after = heightMap_.getData();
+        float* delta = before->getData();
+        for (size_t i = 0; i < before->getSize(); ++i) {
+            delta[i] = after[i] - delta[i];
+        }
+        progressiveLevel_->erosionDelta = std::move(before);
+    }
+}
+
+std::vector<ArchipelagoMask::Island> TerrainGenerator::placeIslands(const TerrainParams& params) const {
     // Generate island centers using seeded random with minimum spacing
     std::vector<std::pair<float, float>> islandCenters;
     std::vector<float> islandRadii;
@@ -266,79 +758,17 @@ void TerrainGenerator::applyArchipelagoMask(const TerrainParams& params) {
         }
     }
 
-    // Create noise for irregular island shapes
-    PerlinNoise shapeNoise(params.seed + 1000);
-
-    // Apply multi-island mask
-    threadPool_->parallelFor(0, height_, [this, &params, &islandCenters, &islandRadii, &shapeNoise](size_t y) {
-        int yi = static_cast<int>(y);
-        float ny = static_cast<float>(y) / height_;
-
-        for (int x = 0; x < width_; ++x) {
-            float nx = static_cast<float>(x) / width_;
-
-            // Find contribution from all islands
-            float totalIslandEffect = 0.0f;
-
-            for (size_t i = 0; i < islandCenters.size(); ++i) {
-                float cx = islandCenters[i].first;
-                float cy = islandCenters[i].second;
-                float radius = islandRadii[i];
-
-                float dx = nx - cx;
-                float dy = ny - cy;
-                float dist = std::sqrt(dx * dx + dy * dy);
-
-                // Add noise to radius for irregular shapes
-                float angle = std::atan2(dy, dx);
-                float noiseVal = shapeNoise.octaveNoise(
-                    cx * 10.0f + std::cos(angle) * 3.0f,
-                    cy * 10.0f + std::sin(angle) * 3.0f,
-                    3, 0.5f, 2.0f);
-                float noisyRadius = radius * (1.0f + noiseVal * params.archipelagoVariation * 0.4f);
-
-                if (dist < noisyRadius) {
-                    // Smooth falloff from center to edge
-                    float normalizedDist = dist / noisyRadius;
-                    float falloff = 1.0f - std::pow(normalizedDist, params.islandShape);
-                    falloff = std::max(0.0f, falloff);
-
-                    // Use max to combine overlapping islands
-                    totalIslandEffect = std::max(totalIslandEffect, falloff);
-                }
-            }
-
-            // Apply island mask
-            float current = heightMap_.at(x, yi);
-            float masked = current * ((1.0f - params.island) + (totalIslandEffect * params.island));
-
-            // Push underwater areas deeper
-            if (totalIslandEffect < 0.1f) {
-                masked *= 0.3f;  // Ocean floor
-            }
-
-            heightMap_.at(x, yi) = masked;
-        }
-    }, 8);
-}
-
-void TerrainGenerator::applyTerracing(const TerrainParams& params) {
-    std::lock_guard<std::mutex> lock(heightMapMutex_);
-
-    int steps = params.terracing;
-    if (steps <= 0) return;
-
-    for (int i = 0; i < width_ * height_; ++i) {
-        float h = heightMap_.getData()[i];
-        float stepped = std::floor(h * steps) / steps;
-        heightMap_.getData()[i] = stepped;
+    std::vector<ArchipelagoMask::Island> islands;
+    for (size_t i = 0; i < islandCenters.size(); ++i) {
+        islands.push_back({islandCenters[i].first, islandCenters[i].second, islandRadii[i]});
     }
+    return islands;
 }
 
 void TerrainGenerator::applyEdgePadding(const TerrainParams& params) {
     std::lock_guard<std::mutex> lock(heightMapMutex_);
     EdgeSmoothing::execute(heightMap_, params.edgePadding, params.islandShape,
-                          params.seed + 1, threadPool_);
+                          params.seed + 1, threadPool_, &edgeDistanceCache_);
 }
 
 void TerrainGenerator::flattenLowAreas(const TerrainParams& params) {
@@ -349,7 +779,7 @@ void TerrainGenerator::flattenLowAreas(const TerrainParams& params) {
 void TerrainGenerator::softenTerrain(const TerrainParams& params) {
     std::lock_guard<std::mutex> lock(heightMapMutex_);
     TerrainSoftening::execute(heightMap_, params.terrainSmoothness,
-                              params.softeningThreshold, 8, 3, threadPool_);
+                              params.softeningThreshold, SOFTEN_RADIUS, SOFTEN_PASSES, threadPool_);
 }
 
 void TerrainGenerator::connectValleys(const TerrainParams& params) {
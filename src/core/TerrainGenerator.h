@@ -4,8 +4,14 @@
 #include "TerrainParams.h"
 #include "PerlinNoise.h"
 #include "ThreadPool.h"
+#include "TileQueue.h"
+#include "../algorithms/ErosionMaps.h"
+#include "../algorithms/EdgeSmoothing.h"
+#include "../algorithms/ArchipelagoMask.h"
+#include "../algorithms/ThermalErosion.h"
 #include <memory>
 #include <future>
+#include <functional>
 #include <atomic>
 #include <mutex>
 #include <random>
@@ -17,6 +23,71 @@ public:
     void generate(const TerrainParams& params);
     std::future<void> generateAsync(const TerrainParams& params);
 
+    /**
+     * Generate one tile of an unbounded world
+     *
+     * Chunk (chunkX, chunkY) covers world pixels [chunkX * size, (chunkX + 1) * size)
+     * and likewise in y. Noise, peaks and terracing are evaluated in world
+     * coordinates; erosion and softening run over an apron wide enough that
+     * every returned pixel is bit-identical to the same pixel in any
+     * neighbouring (or larger) chunk, so tiles meet without seams.
+     *
+     * Stages that assume a finite map (island/archipelago masks, edge padding,
+     * rivers, hydraulic droplets, final normalization) are skipped, heights
+     * keep their raw range (about 0-1.35), and softeningThreshold is used as
+     * an absolute elevation rather than a percentile of the map.
+     *
+     * Reentrant, so chunks can be generated concurrently. Only pass a pool
+     * that isn't the one running the chunk tasks.
+     */
+    static HeightMap generateChunk(int chunkX, int chunkY, int size,
+                                   const TerrainParams& params,
+                                   ThreadPool* pool = nullptr);
+
+    /**
+     * Progressive coarse-to-fine generation
+     *
+     * Generates params at this generator's size starting from the result of
+     * a coarser generator that covered the same world area (same params with
+     * scale shrunk by the size ratio) while keeping its progressive level.
+     * Noise octaves the coarse level resolved are upsampled (bicubic) instead
+     * of evaluated again; only the higher octaves are computed. Erosion starts
+     * from the coarse erosion upsampled onto the new base, so it only has to
+     * settle the new detail: thermal iterations shrink by the size ratio and
+     * hydraulic erosion runs just the droplets the coarse pass didn't cover.
+     * Later stages run as in generate().
+     *
+     * The result approximates generate(params). Parts the coarse level can't
+     * supply (different seed or noise settings, different erosion settings,
+     * not kept) are generated from scratch.
+     */
+    void generateRefined(const TerrainParams& params, const TerrainGenerator& coarse);
+
+    // Keep the data generateRefined() needs from this generator's results
+    // (one extra map, two with erosion)
+    void setKeepProgressiveLevel(bool enabled) { keepProgressiveLevel_ = enabled; }
+    bool hasProgressiveLevel() const { return progressiveLevel_ != nullptr; }
+
+    // Last generation reused a coarse level (its result is an approximation)
+    bool wasRefined() const { return refined_; }
+
+    /**
+     * Tile streaming: point-wise passes run in bands of TILE_ROWS rows and
+     * push a copy of each finished band to queue as it completes, so a long
+     * generation can be shown filling in. Null turns it off.
+     */
+    void setTileQueue(TileQueue* queue) { tileQueue_ = queue; }
+
+    /**
+     * Cancellation token, polled between bands and between stages. When it
+     * reads true the running generation stops, leaving a partial height map,
+     * and wasAborted() reports it. The owner resets it between generations.
+     */
+    void setAbortFlag(const std::atomic<bool>* flag) { abortFlag_ = flag; }
+    bool wasAborted() const { return aborted_; }
+
+    static constexpr int TILE_ROWS = 64;
+
     bool isGenerating() const { return generating_.load(); }
 
     const HeightMap& getHeightMap() const;
@@ -28,23 +99,80 @@ public:
     void setHeightMap(const HeightMap& newMap) {
         std::lock_guard<std::mutex> lock(heightMapMutex_);
         heightMap_ = newMap;
-        width_ = newMap.getWidth();
-        height_ = newMap.getHeight();
-        workBuffer_ = HeightMap(width_, height_);
+        progressiveLevel_.reset();  // Describes the replaced terrain
+        if (newMap.getWidth() != width_ || newMap.getHeight() != height_) {
+            width_ = newMap.getWidth();
+            height_ = newMap.getHeight();
+            workBuffer_ = HeightMap(width_, height_);
+        }
     }
 
     int getWidth() const { return width_; }
     int getHeight() const { return height_; }
 
+    // Erosion by-product capture (flow, deposition, wear) for splatmap masks.
+    // Maps are null until a generation with erosion runs while enabled.
+    void setCaptureErosionMaps(bool enabled) { captureErosionMaps_ = enabled; }
+    const ErosionMaps* getErosionMaps() const { return erosionMaps_.get(); }
+
+    // Restore maps saved alongside a height map (e.g. from TerrainCache); null clears them
+    void setErosionMaps(const ErosionMaps* maps);
+
+    // Bytes held between generations: maps, scratch and the kept level
+    size_t getMemoryUsage() const;
+
 private:
-    void generateBaseNoise(const TerrainParams& params);
+    // Point-wise stages that applyPointStages runs fused, row by row
+    enum PointStage : unsigned {
+        STAGE_BASE_NOISE = 1u << 0,
+        STAGE_PEAKS      = 1u << 1,
+        STAGE_ISLAND     = 1u << 2,  // Single island or archipelago mask
+        STAGE_TERRACE    = 1u << 3
+    };
+
+    // Coarse-level data reused by generateRefined()
+    struct ProgressiveLevel {
+        TerrainParams params;                    // What the level was generated from
+        HeightMap lowOctaves;                    // Raw sum of octaves [0, octaves), 1 px apron (2 at the far edges)
+        int octaves = 0;
+        std::unique_ptr<HeightMap> erosionDelta; // Height change from erosion; null if none ran
+
+        ProgressiveLevel(const TerrainParams& levelParams, int width, int height)
+            : params(levelParams), lowOctaves(width + 3, height + 3) {}
+    };
+
+    // Octaves with a wavelength of at least this many pixels are resolved at
+    // a level and upsampled by the next instead of evaluated again
+    static constexpr float PROGRESSIVE_MIN_WAVELENGTH = 4.0f;
+
+    // Softening kernel used by softenTerrain (and sized into chunk aprons)
+    static constexpr int SOFTEN_RADIUS = 8;
+    static constexpr int SOFTEN_PASSES = 3;
+
+    void generateLevel(const TerrainParams& params, const TerrainGenerator* coarse);
+    void applyPointStages(const TerrainParams& params, unsigned stages);
+
+    // Runs rowFn over rows [0, count) on the pool, stopping early on abort.
+    // Row r fills map row r - rowOffset; with a tile queue, rows go in bands
+    // and each band's map rows are published when it finishes.
+    void forEachRowBand(int count, int rowOffset, const std::function<void(size_t)>& rowFn);
+    bool abortRequested() const { return abortFlag_ && abortFlag_->load(std::memory_order_relaxed); }
+    void progressiveBaseNoise(const TerrainParams& params, const TerrainGenerator* coarse);
+    void progressiveErosion(const TerrainParams& params, const TerrainGenerator* coarse);
+    std::vector<ArchipelagoMask::Island> placeIslands(const TerrainParams& params) const;
+
+    // Row and map kernels shared by generate() and generateChunk()
+    static void baseNoiseRow(const PerlinNoise& noise, const TerrainParams& params,
+                             int xStart, int y, int width, float* row);
+    static void baseCurveRow(float* row, int width);
+    static void terraceRow(float* row, int width, int steps);
+    static ThermalErosion::Params thermalParamsFor(const TerrainParams& params);
+    static void simpleErosion(HeightMap& map, HeightMap& scratch, float erosion,
+                              ThreadPool* pool, ErosionMaps* maps);
+
     void applyValleys(const TerrainParams& params);
     void smoothValleyFloors(const TerrainParams& params);
     void applyErosion(const TerrainParams& params);
-    void applyPeaks(const TerrainParams& params);
-    void applyIslandMask(const TerrainParams& params);
-    void applyArchipelagoMask(const TerrainParams& params);
-    void applyTerracing(const TerrainParams& params);
     void applyEdgePadding(const TerrainParams& params);
     void flattenLowAreas(const TerrainParams& params);
     void softenTerrain(const TerrainParams& params);
@@ -60,4 +188,18 @@ private:
     mutable std::mutex heightMapMutex_;
 
     std::unique_ptr<PerlinNoise> perlin_;
+
+    // Edge distance map survives regenerations that don't touch size, shape or seed
+    EdgeSmoothing::DistanceCache edgeDistanceCache_;
+
+    bool captureErosionMaps_ = false;
+    std::unique_ptr<ErosionMaps> erosionMaps_;
+
+    bool keepProgressiveLevel_ = false;
+    bool refined_ = false;
+    std::unique_ptr<ProgressiveLevel> progressiveLevel_;
+
+    TileQueue* tileQueue_ = nullptr;
+    const std::atomic<bool>* abortFlag_ = nullptr;
+    bool aborted_ = false;
 };
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 struct TerrainParams {
     // Base terrain
@@ -71,32 +73,104 @@ struct TerrainParams {
     // Rendering
     float seaLevel = 0.25f;  // Height of sea plane (0-1)
 
+    /**
+     * Visit every field that affects generation as (name, member pointer),
+     * in a fixed order. Add new generation fields here so equality, hashing
+     * and JSON I/O pick them up.
+     */
+    template <typename Visitor>
+    static void forEachGenerationField(Visitor&& visit) {
+        visit("seed", &TerrainParams::seed);
+        visit("scale", &TerrainParams::scale);
+        visit("octaves", &TerrainParams::octaves);
+        visit("persistence", &TerrainParams::persistence);
+        visit("lacunarity", &TerrainParams::lacunarity);
+
+        visit("valleyStrength", &TerrainParams::valleyStrength);
+        visit("valleySharpness", &TerrainParams::valleySharpness);
+        visit("valleyWidth", &TerrainParams::valleyWidth);
+        visit("flattenValleys", &TerrainParams::flattenValleys);
+        visit("valleyConnectivity", &TerrainParams::valleyConnectivity);
+
+        visit("riverIntensity", &TerrainParams::riverIntensity);
+        visit("riverWidth", &TerrainParams::riverWidth);
+
+        visit("enableRiverEnhancements", &TerrainParams::enableRiverEnhancements);
+        visit("useGradientFlow", &TerrainParams::useGradientFlow);
+        visit("flowSmoothing", &TerrainParams::flowSmoothing);
+        visit("enableTributaries", &TerrainParams::enableTributaries);
+        visit("tributariesPerRiver", &TerrainParams::tributariesPerRiver);
+        visit("tributaryWidth", &TerrainParams::tributaryWidth);
+        visit("enableWetlands", &TerrainParams::enableWetlands);
+        visit("wetlandRadius", &TerrainParams::wetlandRadius);
+        visit("wetlandStrength", &TerrainParams::wetlandStrength);
+
+        visit("erosion", &TerrainParams::erosion);
+        visit("terracing", &TerrainParams::terracing);
+        visit("peaks", &TerrainParams::peaks);
+        visit("island", &TerrainParams::island);
+        visit("edgePadding", &TerrainParams::edgePadding);
+        visit("islandShape", &TerrainParams::islandShape);
+
+        visit("terrainSmoothness", &TerrainParams::terrainSmoothness);
+        visit("softeningThreshold", &TerrainParams::softeningThreshold);
+
+        visit("thermalErosionEnabled", &TerrainParams::thermalErosionEnabled);
+        visit("thermalTalusAngle", &TerrainParams::thermalTalusAngle);
+        visit("thermalRate", &TerrainParams::thermalRate);
+        visit("thermalIterations", &TerrainParams::thermalIterations);
+
+        visit("hydraulicErosionEnabled", &TerrainParams::hydraulicErosionEnabled);
+        visit("hydraulicDroplets", &TerrainParams::hydraulicDroplets);
+        visit("hydraulicLifetime", &TerrainParams::hydraulicLifetime);
+        visit("hydraulicInertia", &TerrainParams::hydraulicInertia);
+        visit("hydraulicCapacity", &TerrainParams::hydraulicCapacity);
+        visit("hydraulicErosion", &TerrainParams::hydraulicErosion);
+        visit("hydraulicDeposition", &TerrainParams::hydraulicDeposition);
+        visit("hydraulicIterations", &TerrainParams::hydraulicIterations);
+
+        visit("archipelagoMode", &TerrainParams::archipelagoMode);
+        visit("archipelagoIslandCount", &TerrainParams::archipelagoIslandCount);
+        visit("archipelagoMinSize", &TerrainParams::archipelagoMinSize);
+        visit("archipelagoMaxSize", &TerrainParams::archipelagoMaxSize);
+        visit("archipelagoSpacing", &TerrainParams::archipelagoSpacing);
+        visit("archipelagoVariation", &TerrainParams::archipelagoVariation);
+    }
+
+    // Every field: generation fields plus render-only ones
+    template <typename Visitor>
+    static void forEachField(Visitor&& visit) {
+        forEachGenerationField(visit);
+        visit("seaLevel", &TerrainParams::seaLevel);
+    }
+
+    /**
+     * Stable 64-bit FNV-1a hash of the generation fields (seaLevel excluded).
+     * Equal for any two param sets that generate the same terrain at a
+     * given resolution, and identical across runs.
+     */
+    uint64_t generationHash() const {
+        uint64_t hash = 14695981039346656037ull;
+        forEachGenerationField([&](const char*, auto member) {
+            auto value = this->*member;
+            if constexpr (std::is_floating_point_v<decltype(value)>) {
+                value += 0.0f;  // -0 and +0 generate the same terrain
+            }
+            unsigned char bytes[sizeof(value)];
+            std::memcpy(bytes, &value, sizeof(value));
+            for (unsigned char byte : bytes) {
+                hash = (hash ^ byte) * 1099511628211ull;
+            }
+        });
+        return hash;
+    }
+
     bool operator==(const TerrainParams& other) const {
-        return seed == other.seed &&
-               scale == other.scale &&
-               octaves == other.octaves &&
-               persistence == other.persistence &&
-               lacunarity == other.lacunarity &&
-               valleyStrength == other.valleyStrength &&
-               valleySharpness == other.valleySharpness &&
-               valleyWidth == other.valleyWidth &&
-               flattenValleys == other.flattenValleys &&
-               valleyConnectivity == other.valleyConnectivity &&
-               riverIntensity == other.riverIntensity &&
-               riverWidth == other.riverWidth &&
-               erosion == other.erosion &&
-               terracing == other.terracing &&
-               peaks == other.peaks &&
-               island == other.island &&
-               edgePadding == other.edgePadding &&
-               islandShape == other.islandShape &&
-               archipelagoMode == other.archipelagoMode &&
-               archipelagoIslandCount == other.archipelagoIslandCount &&
-               archipelagoMinSize == other.archipelagoMinSize &&
-               archipelagoMaxSize == other.archipelagoMaxSize &&
-               seaLevel == other.seaLevel &&
-               terrainSmoothness == other.terrainSmoothness &&
-               softeningThreshold == other.softeningThreshold;
+        bool equal = true;
+        forEachField([&](const char*, auto member) {
+            equal = equal && (this->*member == other.*member);
+        });
+        return equal;
     }
 
     bool operator!=(const TerrainParams& other) const {
@@ -1,26 +1,53 @@
 #include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace {
+
+// Lane of the work running on this thread
+thread_local TaskPriority threadPriority = TaskPriority::NORMAL;
+
+} // namespace
 
 ThreadPool::ThreadPool(size_t numThreads) : stop_(false) {
     for (size_t i = 0; i < numThreads; ++i) {
         workers_.emplace_back([this] {
             while (true) {
                 std::function<void()> task;
+                size_t lane;
 
                 {
                     std::unique_lock<std::mutex> lock(this->queueMutex_);
-                    this->condition_.wait(lock, [this] {
-                        return this->stop_ || !this->tasks_.empty();
+                    this->condition_.wait(lock, [this, &lane] {
+                        lane = this->runnableLane();
+                        return lane < LANE_COUNT || (this->stop_ && this->queuesEmpty());
                     });
 
-                    if (this->stop_ && this->tasks_.empty()) {
+                    if (lane == LANE_COUNT) {
                         return;
                     }
 
-                    task = std::move(this->tasks_.front());
-                    this->tasks_.pop();
+                    task = std::move(this->lanes_[lane].front().run);
+                    this->lanes_[lane].pop_front();
+                    ++this->running_[lane];
                 }
 
+                threadPriority = static_cast<TaskPriority>(lane);
                 task();
+                threadPriority = TaskPriority::NORMAL;
+
+                bool wake;
+                {
+                    std::unique_lock<std::mutex> lock(this->queueMutex_);
+                    --this->running_[lane];
+                    // A task held back by the limit can run now
+                    wake = this->laneLimit_[lane] != 0 && !this->lanes_[lane].empty();
+                }
+                if (wake) {
+                    this->condition_.notify_one();
+                }
             }
         });
     }
@@ -41,27 +68,144 @@ ThreadPool::~ThreadPool() {
     }
 }
 
+size_t ThreadPool::runnableLane() const {
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+        if (!lanes_[lane].empty() &&
+            (laneLimit_[lane] == 0 || running_[lane] < laneLimit_[lane])) {
+            return lane;
+        }
+    }
+    return LANE_COUNT;
+}
+
+bool ThreadPool::queuesEmpty() const {
+    for (const std::deque<Task>& lane : lanes_) {
+        if (!lane.empty()) return false;
+    }
+    return true;
+}
+
+bool ThreadPool::runPendingChunk(TaskPriority lowest) {
+    std::function<void()> task;
+    size_t lane = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        for (; lane <= static_cast<size_t>(lowest); ++lane) {
+            auto it = std::find_if(lanes_[lane].begin(), lanes_[lane].end(),
+                                   [](const Task& t) { return t.loopChunk; });
+            if (it != lanes_[lane].end()) {
+                task = std::move(it->run);
+                lanes_[lane].erase(it);
+                break;
+            }
+        }
+        if (!task) {
+            return false;
+        }
+    }
+
+    TaskPriority previous = threadPriority;
+    threadPriority = static_cast<TaskPriority>(lane);
+    task();
+    threadPriority = previous;
+    return true;
+}
+
+TaskPriority ThreadPool::currentPriority() {
+    return threadPriority;
+}
+
+ThreadPool::PriorityScope::PriorityScope(TaskPriority priority)
+    : previous_(threadPriority) {
+    threadPriority = priority;
+}
+
+ThreadPool::PriorityScope::~PriorityScope() {
+    threadPriority = previous_;
+}
+
+void ThreadPool::setLaneLimit(TaskPriority priority, size_t maxThreads) {
+    {
+        std::unique_lock<std::mutex> lock(queueMutex_);
+        laneLimit_[static_cast<size_t>(priority)] = maxThreads;
+    }
+    condition_.notify_all();
+}
+
+size_t ThreadPool::getLaneLimit(TaskPriority priority) const {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    return laneLimit_[static_cast<size_t>(priority)];
+}
+
 void ThreadPool::parallelFor(size_t start, size_t end,
                              std::function<void(size_t)> func,
                              size_t grainSize) {
+    parallelFor(currentPriority(), start, end, std::move(func), grainSize);
+}
+
+void ThreadPool::parallelFor(TaskPriority priority, size_t start, size_t end,
+                             std::function<void(size_t)> func,
+                             size_t grainSize) {
     if (start >= end) return;
+    grainSize = std::max<size_t>(1, grainSize);
+
+    // Shared with the chunks: the last one may still hold the mutex when
+    // the caller sees remaining == 0 and returns
+    struct Batch {
+        std::atomic<size_t> remaining{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto batch = std::make_shared<Batch>();
+    // Chunks only touch func before counting themselves done, and the
+    // caller doesn't return before that
+    const std::function<void(size_t)>* body = &func;
 
     size_t numTasks = (end - start + grainSize - 1) / grainSize;
-    std::vector<std::future<void>> futures;
-    futures.reserve(numTasks);
+    batch->remaining = numTasks;
+
+    {
+        std::unique_lock<std::mutex> lock(queueMutex_);
 
-    for (size_t i = start; i < end; i += grainSize) {
-        size_t chunkEnd = std::min(i + grainSize, end);
+        if (stop_) {
+            throw std::runtime_error("parallelFor on stopped ThreadPool");
+        }
 
-        futures.push_back(enqueue([func, i, chunkEnd] {
-            for (size_t idx = i; idx < chunkEnd; ++idx) {
-                func(idx);
-            }
-        }));
+        for (size_t i = start; i < end; i += grainSize) {
+            size_t chunkEnd = std::min(i + grainSize, end);
+
+            lanes_[static_cast<size_t>(priority)].push_back({[batch, body, i, chunkEnd] {
+                try {
+                    for (size_t idx = i; idx < chunkEnd; ++idx) {
+                        (*body)(idx);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> errorLock(batch->mutex);
+                    if (!batch->error) batch->error = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> doneLock(batch->mutex);
+                if (--batch->remaining == 0) {
+                    batch->done.notify_all();
+                }
+            }, true});
+        }
+    }
+
+    condition_.notify_all();
+
+    // Help until the queue holds no more chunks as urgent as ours; anything
+    // of ours still unfinished is then running on another thread
+    while (batch->remaining.load() > 0) {
+        if (runPendingChunk(priority)) continue;
+
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&] { return batch->remaining.load() == 0; });
     }
 
-    // Wait for all tasks to complete
-    for (auto& future : futures) {
-        future.get();
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
     }
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <deque>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -9,31 +9,117 @@
 #include <functional>
 #include <stdexcept>
 
+/**
+ * Scheduling lanes, most urgent first. Workers always take the oldest task
+ * of the most urgent lane with room under its limit; a running task is
+ * never interrupted, so a parallelFor yields at its chunk boundaries.
+ */
+enum class TaskPriority {
+    INTERACTIVE,  // The user is waiting on it (previews, brush compositing)
+    NORMAL,       // Default (auto-upgrades, explicit generations)
+    BACKGROUND    // Nobody is waiting yet (exports, speculation, thumbnails)
+};
+
 class ThreadPool {
 public:
     explicit ThreadPool(size_t numThreads = std::thread::hardware_concurrency());
     ~ThreadPool();
 
+    template<typename F, typename... Args>
+    auto enqueue(TaskPriority priority, F&& f, Args&&... args)
+        -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+    // Priority inherited from the calling thread (see currentPriority())
     template<typename F, typename... Args>
     auto enqueue(F&& f, Args&&... args)
         -> std::future<typename std::invoke_result<F, Args...>::type>;
 
+    /**
+     * Run func(i) for every i in [start, end), grainSize indices per task
+     *
+     * While waiting, the caller runs queued loop chunks itself (its own or
+     * those of other parallelFor calls), so it is safe to call from pool
+     * tasks and from several threads at once: concurrent callers share the
+     * workers instead of blocking on each other.
+     */
     void parallelFor(size_t start, size_t end,
                      std::function<void(size_t)> func,
                      size_t grainSize = 1);
 
+    /**
+     * parallelFor with its chunks in the given lane. While waiting, the
+     * caller only runs chunks at least as urgent as that.
+     */
+    void parallelFor(TaskPriority priority, size_t start, size_t end,
+                     std::function<void(size_t)> func,
+                     size_t grainSize = 1);
+
+    /**
+     * At most maxThreads workers run tasks of a lane at once (0 = no
+     * limit, the default). Threads helping inside parallelFor don't count,
+     * so a capped lane still completes.
+     */
+    void setLaneLimit(TaskPriority priority, size_t maxThreads);
+    size_t getLaneLimit(TaskPriority priority) const;
+
     size_t getThreadCount() const { return workers_.size(); }
 
+    /**
+     * Priority of the work running on the calling thread: the lane of the
+     * pool task or chunk it is running, else NORMAL or a PriorityScope's.
+     * enqueue() and parallelFor() without a priority use it, so a task's
+     * nested loops stay in its lane.
+     */
+    static TaskPriority currentPriority();
+
+    // Sets the calling thread's priority for its lifetime (e.g. on a
+    // thread that isn't a pool worker)
+    class PriorityScope {
+    public:
+        explicit PriorityScope(TaskPriority priority);
+        ~PriorityScope();
+
+        PriorityScope(const PriorityScope&) = delete;
+        PriorityScope& operator=(const PriorityScope&) = delete;
+
+    private:
+        TaskPriority previous_;
+    };
+
 private:
+    static constexpr size_t LANE_COUNT = 3;
+
+    struct Task {
+        std::function<void()> run;
+        bool loopChunk;  // parallelFor chunk: short, safe to run while waiting
+    };
+
+    // Most urgent lane a worker may take a task from; LANE_COUNT if none.
+    // Caller holds queueMutex_
+    size_t runnableLane() const;
+    bool queuesEmpty() const;
+
+    // Pop and run one queued loop chunk from lanes up to lowest (most
+    // urgent first); false if none is queued
+    bool runPendingChunk(TaskPriority lowest);
+
     std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
-    std::mutex queueMutex_;
+    std::deque<Task> lanes_[LANE_COUNT];     // Indexed by TaskPriority
+    size_t running_[LANE_COUNT] = {};        // Tasks workers are running, per lane
+    size_t laneLimit_[LANE_COUNT] = {};      // 0 = no limit
+    mutable std::mutex queueMutex_;
     std::condition_variable condition_;
     bool stop_;
 };
 template<typename F, typename... Args>
 auto ThreadPool::enqueue(F&& f, Args&&... args)
     -> std::future<typename std::invoke_result<F, Args...>::type> {
+    return enqueue(currentPriority(), std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+template<typename F, typename... Args>
+auto ThreadPool::enqueue(TaskPriority priority, F&& f, Args&&... args)
+    -> std::future<typename std::invoke_result<F, Args...>::type> {
 
     using return_type = typename std::invoke_result<F, Args...>::type;
 
@@ -50,7 +136,7 @@ auto ThreadPool::enqueue(F&& f, Args&&... args)
             throw std::runtime_error("enqueue on stopped ThreadPool");
         }
 
-        tasks_.emplace([task]() { (*task)(); });
+        lanes_[static_cast<size_t>(priority)].push_back({[task]() { (*task)(); }, false});
     }
 
     condition_.notify_one();
@@ -0,0 +1,39 @@
+#include "TileQueue.h"
+#include <utility>
+
+TileQueue::TileQueue() {
+    Node* stub = new Node();
+    head_.store(stub, std::memory_order_relaxed);
+    tail_ = stub;
+}
+
+TileQueue::~TileQueue() {
+    clear();
+    delete tail_;
+}
+
+void TileQueue::push(TerrainTile tile) {
+    Node* node = new Node();
+    node->tile = std::move(tile);
+
+    // Claim the head, then link the previous one to us; until the link is
+    // stored the consumer just sees the queue end before this node
+    Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+bool TileQueue::pop(TerrainTile& tile) {
+    Node* next = tail_->next.load(std::memory_order_acquire);
+    if (!next) return false;
+
+    tile = std::move(next->tile);
+    delete tail_;
+    tail_ = next;  // Emptied node becomes the new stub
+    return true;
+}
+
+void TileQueue::clear() {
+    TerrainTile discarded;
+    while (pop(discarded)) {
+    }
+}
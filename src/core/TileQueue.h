@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+/**
+ * TerrainTile - A finished region of a terrain still being generated
+ *
+ * Heights are copied out, so the tile stays valid while later stages keep
+ * rewriting the map. Values are pre-normalization (about 0-1.35), unlike
+ * the finished map's 0-1: the normalization range isn't known until every
+ * stage has run.
+ */
+struct TerrainTile {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    int mapWidth = 0;            // Size of the map the tile belongs to
+    int mapHeight = 0;
+    std::vector<float> heights;  // width * height, row-major
+};
+
+/**
+ * TileQueue - Lock-free multi-producer, single-consumer queue of tiles
+ *
+ * Generation threads push finished tiles without blocking; the UI thread
+ * pops them once per frame. Unbounded linked list (Vyukov's MPSC design):
+ * push is one atomic exchange, pop touches only consumer-owned state.
+ */
+class TileQueue {
+public:
+    TileQueue();
+    ~TileQueue();
+
+    TileQueue(const TileQueue&) = delete;
+    TileQueue& operator=(const TileQueue&) = delete;
+
+    // Any thread
+    void push(TerrainTile tile);
+
+    // Consumer thread only. False if empty (a push still in progress may
+    // not be visible yet)
+    bool pop(TerrainTile& tile);
+
+    // Consumer thread only: drop everything queued
+    void clear();
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        TerrainTile tile;
+    };
+
+    std::atomic<Node*> head_;  // Most recently pushed; producers swap it
+    Node* tail_;               // Consumed stub; tail_->next is the oldest tile
+};
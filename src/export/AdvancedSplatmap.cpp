@@ -1,4 +1,5 @@
 #include "AdvancedSplatmap.h"
+#include "Filters.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
@@ -22,17 +23,51 @@ bool AdvancedSplatmap::exportMultiMaterial(
     // Calculate number of texture sets needed (4 materials per RGBA texture)
     size_t numTextures = (numMaterials + 3) / 4;
 
+    // Erosion masks are only usable when they match the heightmap
+    const ErosionMaps* maps = params.erosionMaps;
+    if (maps && (maps->getWidth() != width || maps->getHeight() != height)) {
+        std::cerr << "Warning: Erosion maps size mismatch, ignoring material masks" << std::endl;
+        maps = nullptr;
+    }
+
+    const HeightMap* wetness = params.wetness;
+    if (wetness && (wetness->getWidth() != width || wetness->getHeight() != height)) {
+        std::cerr << "Warning: Wetness map size mismatch, ignoring wetness masks" << std::endl;
+        wetness = nullptr;
+    }
+
+    // Per-map normalization (flow is log-scaled, see sampleMask)
+    float maskScales[3] = {0.0f, 0.0f, 0.0f};
+    if (maps) {
+        float flowMax = maps->flow.getMax();
+        float depositionMax = maps->deposition.getMax();
+        float erosionMax = maps->erosion.getMax();
+        maskScales[0] = flowMax > 0.0f ? 1.0f / std::log1p(flowMax) : 0.0f;
+        maskScales[1] = depositionMax > 0.0f ? 1.0f / depositionMax : 0.0f;
+        maskScales[2] = erosionMax > 0.0f ? 1.0f / erosionMax : 0.0f;
+    }
+
+    // Pool work below (slope included) runs in the export's lane
+    ThreadPool::PriorityScope priorityScope(params.priority);
+
+    // Slope is shared by every texture set, so compute it once up front
+    HeightMap slopeMap(width, height);
+    Filters::slope(heightMap, slopeMap, params.pool);
+    const float* heights = heightMap.getData();
+    const float* slopes = slopeMap.getData();
+
     // Generate each texture set
     for (size_t texIdx = 0; texIdx < numTextures; ++texIdx) {
         std::vector<unsigned char> pixels(width * height * 4, 0);
 
-        // Process each pixel
-        for (int y = 0; y < height; ++y) {
+        // Process each row (rows are independent)
+        auto processRow = [&](size_t row) {
+            int y = static_cast<int>(row);
             for (int x = 0; x < width; ++x) {
                 int pixelIdx = (y * width + x) * 4;
 
-                float h = heightMap.at(x, y);
-                float slope = calculateSlope(heightMap, x, y);
+                float h = heights[static_cast<size_t>(y) * width + x];
+                float slope = slopes[static_cast<size_t>(y) * width + x];
 
                 // Calculate weights for the 4 materials in this texture
                 float weights[4] = {0.0f, 0.0f, 0.0f, 0.0f};
@@ -45,6 +80,16 @@ bool AdvancedSplatmap::exportMultiMaterial(
                     const Material& mat = params.materials[matIdx];
                     float weight = calculateMaterialWeight(h, slope, mat);
 
+                    if (mat.mask == MaskSource::WETNESS) {
+                        if (wetness) {
+                            float mask = std::clamp(wetness->getData()[static_cast<size_t>(y) * width + x], 0.0f, 1.0f);
+                            weight *= (1.0f - mat.maskStrength) + mat.maskStrength * mask;
+                        }
+                    } else if (maps && mat.mask != MaskSource::NONE) {
+                        float mask = sampleMask(*maps, mat.mask, static_cast<size_t>(y) * width + x, maskScales);
+                        weight *= (1.0f - mat.maskStrength) + mat.maskStrength * mask;
+                    }
+
                     weights[localIdx] = weight;
                     totalWeight += weight;
                 }
@@ -62,6 +107,14 @@ bool AdvancedSplatmap::exportMultiMaterial(
                 pixels[pixelIdx + 2] = static_cast<unsigned char>(weights[2] * 255.0f);
                 pixels[pixelIdx + 3] = static_cast<unsigned char>(weights[3] * 255.0f);
             }
+        };
+
+        if (params.pool) {
+            params.pool->parallelFor(0, height, processRow, 16);
+        } else {
+            for (int y = 0; y < height; ++y) {
+                processRow(y);
+            }
         }
 
         // Generate filename for this texture
@@ -187,6 +240,46 @@ std::vector<AdvancedSplatmap::Material> AdvancedSplatmap::createAlpineMaterials(
     return materials;
 }
 
+std::vector<AdvancedSplatmap::Material> AdvancedSplatmap::createErosionMaterials() {
+    std::vector<Material> materials = createDefaultMaterials();
+
+    // 8: Riverbed (water flow paths, gentle slopes)
+    materials.emplace_back("Riverbed", 0.0f, 0.8f, 0.0f, 0.6f, 0.06f, 8);
+    materials.back().mask = MaskSource::FLOW;
+
+    // 9: Sediment (deposition fans at the foot of slopes)
+    materials.emplace_back("Sediment", 0.0f, 0.9f, 0.0f, 0.5f, 0.08f, 8);
+    materials.back().mask = MaskSource::DEPOSITION;
+
+    // 10: Scree (worn, eroded surfaces)
+    materials.emplace_back("Scree", 0.0f, 1.0f, 0.2f, 3.0f, 0.06f, 8);
+    materials.back().mask = MaskSource::WEAR;
+
+    // 11: Marsh (wet, flat valley floors)
+    materials.emplace_back("Marsh", 0.0f, 0.6f, 0.0f, 0.3f, 0.06f, 8);
+    materials.back().mask = MaskSource::WETNESS;
+
+    return materials;
+}
+
+float AdvancedSplatmap::sampleMask(
+    const ErosionMaps& maps,
+    MaskSource source,
+    size_t index,
+    const float scales[3]) {
+
+    switch (source) {
+        case MaskSource::FLOW:
+            return std::min(1.0f, std::log1p(std::max(0.0f, maps.flow.getData()[index])) * scales[0]);
+        case MaskSource::DEPOSITION:
+            return std::min(1.0f, maps.deposition.getData()[index] * scales[1]);
+        case MaskSource::WEAR:
+            return std::min(1.0f, maps.erosion.getData()[index] * scales[2]);
+        default:
+            return 1.0f;
+    }
+}
+
 float AdvancedSplatmap::calculateMaterialWeight(
     float height,
     float slope,
@@ -221,30 +314,6 @@ float AdvancedSplatmap::calculateMaterialWeight(
     return std::max(0.0f, weight);
 }
 
-float AdvancedSplatmap::calculateSlope(
-    const HeightMap& heightMap,
-    int x, int y) {
-
-    int width = heightMap.getWidth();
-    int height = heightMap.getHeight();
-
-    float center = heightMap.at(x, y);
-
-    float left = (x > 0) ? heightMap.at(x - 1, y) : center;
-    float right = (x < width - 1) ? heightMap.at(x + 1, y) : center;
-    float up = (y > 0) ? heightMap.at(x, y - 1) : center;
-    float down = (y < height - 1) ? heightMap.at(x, y + 1) : center;
-
-    // Calculate gradients
-    float dx = (right - left) * 0.5f;
-    float dy = (down - up) * 0.5f;
-
-    // Slope magnitude (radians)
-    float slope = std::sqrt(dx * dx + dy * dy);
-
-    return slope;
-}
-
 float AdvancedSplatmap::smoothstep(float edge0, float edge1, float x) {
     float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
     return t * t * (3.0f - 2.0f * t);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "HeightMap.h"
+#include "ErosionMaps.h"
+#include "ThreadPool.h"
 #include <string>
 #include <vector>
 
@@ -13,9 +15,20 @@
  * - Slope-based material selection
  * - Height-based biome zones
  * - Configurable material parameters
+ * - Erosion masks (flow, deposition, wear) from the generation run
+ * - Wetness mask from hydrology (Hydrology::wetnessIndex)
  */
 class AdvancedSplatmap {
 public:
+    // Erosion or hydrology by-product a material can be modulated by
+    enum class MaskSource {
+        NONE,
+        FLOW,         // Water flow paths (riverbeds, gullies)
+        DEPOSITION,   // Sediment fans and talus
+        WEAR,         // Eroded surfaces
+        WETNESS       // Topographic wetness (marshes, valley floors)
+    };
+
     // Material definition
     struct Material {
         std::string name;
@@ -25,6 +38,8 @@ public:
         float slopeMax;       // Maximum slope
         float blendRange;     // Transition smoothness
         int priority;         // Higher priority wins conflicts
+        MaskSource mask = MaskSource::NONE;  // Erosion/wetness mask to multiply in
+        float maskStrength = 1.0f;           // 0 = ignore mask, 1 = fully masked
 
         Material(const std::string& n, float hMin, float hMax,
                 float sMin, float sMax, float blend = 0.05f, int prio = 0)
@@ -38,6 +53,10 @@ public:
         bool enableSmoothing = true;    // Smooth transitions between materials
         float transitionWidth = 0.05f;   // Width of transition zones
         int outputChannels = 4;          // 4 or 8 channel output
+        const ErosionMaps* erosionMaps = nullptr;  // Source for material masks (optional)
+        const HeightMap* wetness = nullptr;        // 0-1 wetness index for WETNESS masks (optional)
+        ThreadPool* pool = nullptr;                // Parallel slope and rows (optional)
+        TaskPriority priority = TaskPriority::BACKGROUND;  // Pool lane for that work
     };
 
     /**
@@ -81,6 +100,13 @@ public:
      */
     static std::vector<Material> createAlpineMaterials();
 
+    /**
+     * Create default materials plus erosion-driven layers
+     * (riverbed, sediment, scree, marsh); needs ExportParams::erosionMaps
+     * and ExportParams::wetness
+     */
+    static std::vector<Material> createErosionMaterials();
+
 private:
     // Calculate material weight at given height/slope
     static float calculateMaterialWeight(
@@ -88,10 +114,12 @@ private:
         float slope,
         const Material& material);
 
-    // Calculate slope at given position (radians)
-    static float calculateSlope(
-        const HeightMap& heightMap,
-        int x, int y);
+    // Normalized erosion mask value (0-1) for a material at a pixel
+    static float sampleMask(
+        const ErosionMaps& maps,
+        MaskSource source,
+        size_t index,
+        const float scales[3]);
 
     // Smooth step interpolation
     static float smoothstep(float edge0, float edge1, float x);
@@ -1,19 +1,25 @@
 #include "ImageExporter.h"
+#include "Filters.h"
 #include <cmath>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
 
 // stb_image_write
-#ifdef YMIRGE_SDL_UI_ENABLED
-    // For SDL2 build: Define implementation here
+// The SDL2 build and the ymirge_core library (CLI) bundle their own copy
+#if defined(YMIRGE_SDL_UI_ENABLED) || defined(YMIRGE_CORE_LIBRARY)
+    #define YMIRGE_BUNDLED_STB_WRITE
+#endif
+
+#ifdef YMIRGE_BUNDLED_STB_WRITE
+    // Define implementation here
     #define STB_IMAGE_WRITE_IMPLEMENTATION
 #endif
 // For raylib build: Use raylib's implementation (don't define STB_IMAGE_WRITE_IMPLEMENTATION)
 #include "stb_image_write.h"
 
-// tinyexr for EXR export - only for raylib build (SDL2 build uses PNG only for now)
-#ifndef YMIRGE_SDL_UI_ENABLED
+// tinyexr for EXR export - only for raylib build (bundled builds use PNG only for now)
+#ifndef YMIRGE_BUNDLED_STB_WRITE
     #define TINYEXR_USE_MINIZ 0
     #define TINYEXR_USE_STB_ZLIB 1
     #define TINYEXR_IMPLEMENTATION
@@ -94,12 +100,18 @@ bool ImageExporter::exportSplatmap(const HeightMap& heightMap, const std::string
     // RGBA splatmap
     std::vector<unsigned char> pixels(width * height * 4);
 
+    HeightMap slopeMap(width, height);
+    Filters::slope(heightMap, slopeMap, nullptr);
+    const float* heights = heightMap.getData();
+    const float* slopes = slopeMap.getData();
+
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
-            int idx = (y * width + x) * 4;
+            size_t cell = static_cast<size_t>(y) * width + x;
+            size_t idx = cell * 4;
 
-            float h = heightMap.at(x, y);
-            float slope = calculateSlope(heightMap, x, y);
+            float h = heights[cell];
+            float slope = slopes[cell];
 
             unsigned char r, g, b, a;
             generateSplatmapPixel(h, slope, r, g, b, a);
@@ -123,26 +135,48 @@ bool ImageExporter::exportSplatmap(const HeightMap& heightMap, const std::string
     }
 }
 
-float ImageExporter::calculateSlope(const HeightMap& heightMap, int x, int y) {
-    int width = heightMap.getWidth();
-    int height = heightMap.getHeight();
+bool ImageExporter::exportErosionMaps(const ErosionMaps& maps, const std::string& filename) {
+    int width = maps.getWidth();
+    int height = maps.getHeight();
 
-    // Get neighboring heights
-    float center = heightMap.at(x, y);
+    // Flow counts are heavy-tailed (channels collect thousands of visits), so
+    // log-scale them; deposition and wear are linear
+    float flowMax = maps.flow.getMax();
+    float flowScale = flowMax > 0.0f ? 1.0f / std::log1p(flowMax) : 0.0f;
+    float depositionScale = normalizationScale(maps.deposition);
+    float erosionScale = normalizationScale(maps.erosion);
 
-    float left = (x > 0) ? heightMap.at(x - 1, y) : center;
-    float right = (x < width - 1) ? heightMap.at(x + 1, y) : center;
-    float up = (y > 0) ? heightMap.at(x, y - 1) : center;
-    float down = (y < height - 1) ? heightMap.at(x, y + 1) : center;
+    const float* flow = maps.flow.getData();
+    const float* deposition = maps.deposition.getData();
+    const float* erosion = maps.erosion.getData();
 
-    // Calculate gradients
-    float dx = (right - left) * 0.5f;
-    float dy = (down - up) * 0.5f;
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
 
-    // Slope magnitude
-    float slope = std::sqrt(dx * dx + dy * dy);
+    for (size_t i = 0; i < maps.flow.getSize(); ++i) {
+        float r = std::log1p(std::max(0.0f, flow[i])) * flowScale;
+        float g = deposition[i] * depositionScale;
+        float b = erosion[i] * erosionScale;
 
-    return slope;
+        pixels[i * 3 + 0] = static_cast<unsigned char>(std::clamp(r, 0.0f, 1.0f) * 255.0f);
+        pixels[i * 3 + 1] = static_cast<unsigned char>(std::clamp(g, 0.0f, 1.0f) * 255.0f);
+        pixels[i * 3 + 2] = static_cast<unsigned char>(std::clamp(b, 0.0f, 1.0f) * 255.0f);
+    }
+
+    int result = stbi_write_png(filename.c_str(), width, height, 3,
+                                 pixels.data(), width * 3);
+
+    if (result) {
+        std::cout << "Erosion maps exported to: " << filename << std::endl;
+        return true;
+    } else {
+        std::cerr << "Failed to export erosion maps to: " << filename << std::endl;
+        return false;
+    }
+}
+
+float ImageExporter::normalizationScale(const HeightMap& map) {
+    float maxValue = map.getMax();
+    return maxValue > 0.0f ? 1.0f / maxValue : 0.0f;
 }
 
 void ImageExporter::generateSplatmapPixel(float height, float slope,
@@ -252,7 +286,7 @@ bool ImageExporter::exportHeightmapRAW16(const HeightMap& heightMap, const std::
     }
 }
 
-#ifndef YMIRGE_SDL_UI_ENABLED
+#ifndef YMIRGE_BUNDLED_STB_WRITE
 // EXR export only available for raylib build (requires TinyEXR)
 bool ImageExporter::exportHeightmapEXR(const HeightMap& heightMap, const std::string& filename) {
     int width = heightMap.getWidth();
@@ -320,7 +354,12 @@ bool ImageExporter::exportHeightmapEXR(const HeightMap& heightMap, const std::st
     std::cout << "  Format: 32-bit float, " << width << "x" << height << std::endl;
     return true;
 }
-#endif // YMIRGE_SDL_UI_ENABLED
+#else
+bool ImageExporter::exportHeightmapEXR(const HeightMap&, const std::string& filename) {
+    std::cerr << "EXR export not available in this build (requires TinyEXR): " << filename << std::endl;
+    return false;
+}
+#endif // YMIRGE_BUNDLED_STB_WRITE
 
 bool ImageExporter::exportMeshOBJ(const HeightMap& heightMap, const std::string& filename,
                                   int maxSize, float scaleXZ, float scaleY) {
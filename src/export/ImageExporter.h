@@ -1,6 +1,7 @@
 #pragma once
 
 #include "HeightMap.h"
+#include "ErosionMaps.h"
 #include <string>
 #include <vector>
 
@@ -19,6 +20,9 @@ public:
     // RGBA splatmap: R=sand/beach, G=grass, B=rock, A=snow
     static bool exportSplatmap(const HeightMap& heightMap, const std::string& filename);
 
+    // RGB erosion masks: R=flow (log-scaled), G=deposition, B=wear, each normalized to its max
+    static bool exportErosionMaps(const ErosionMaps& maps, const std::string& filename);
+
     // 16-bit RAW, big-endian (Unity/Unreal compatible)
     static bool exportHeightmapRAW16(const HeightMap& heightMap, const std::string& filename);
 
@@ -29,7 +33,8 @@ public:
                               int maxSize = 512, float scaleXZ = 1.0f, float scaleY = 100.0f);
 
 private:
-    static float calculateSlope(const HeightMap& heightMap, int x, int y);
+    // Scale applied to an accumulation map so its maximum maps to 1.0
+    static float normalizationScale(const HeightMap& map);
 
     static void generateSplatmapPixel(float height, float slope,
                                       unsigned char& outR,
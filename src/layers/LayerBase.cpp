@@ -1,6 +1,22 @@
 #include "LayerBase.h"
 #include <algorithm>
 
+HeightMap& CompositeScratch::acquire(size_t depth, int width, int height) {
+    if (levels_.size() <= depth) {
+        levels_.resize(depth + 1);
+    }
+
+    std::unique_ptr<HeightMap>& level = levels_[depth];
+    if (!level || level->getWidth() != width || level->getHeight() != height) {
+        level = std::make_unique<HeightMap>(width, height);
+    }
+    return *level;
+}
+
+void LayerBase::compositeInPlace(HeightMap& target, CompositeScratch& scratch) {
+    compositeRegion(target, {0, 0, target.getWidth(), target.getHeight()}, scratch);
+}
+
 void LayerBase::setOpacity(float opacity) {
     opacity_ = std::clamp(opacity, 0.0f, 1.0f);
 }
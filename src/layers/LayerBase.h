@@ -3,6 +3,9 @@
 #include "HeightMap.h"
 #include <string>
 #include <memory>
+#include <vector>
+
+class ThreadPool;
 
 enum class LayerType {
     PROCEDURAL,
@@ -23,6 +26,29 @@ enum class BlendMode {
     OVERLAY
 };
 
+// Pixel rectangle of a map being composited
+struct CompositeRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+/**
+ * Buffers groups composite their children into, one per nesting depth
+ *
+ * Owned by whoever drives compositing (LayerStack) and reused across
+ * calls, so compositing allocates only when the size changes.
+ */
+class CompositeScratch {
+public:
+    // Buffer for the given depth at this size
+    HeightMap& acquire(size_t depth, int width, int height);
+
+private:
+    std::vector<std::unique_ptr<HeightMap>> levels_;
+};
+
 class LayerBase {
 public:
     virtual ~LayerBase() = default;
@@ -48,8 +74,30 @@ public:
     virtual int getWidth() const = 0;
     virtual int getHeight() const = 0;
 
+    // Blend onto below at output's size, whatever the layer's own size
     virtual void composite(HeightMap& output, const HeightMap& below) = 0;
 
+    // Blend onto target in place
+    void compositeInPlace(HeightMap& target, CompositeScratch& scratch);
+
+    // Blend onto target in place, inside rect only (groups borrow scratch
+    // buffers at depth and deeper)
+    virtual void compositeRegion(HeightMap& target, const CompositeRect& rect,
+                                 CompositeScratch& scratch, size_t depth = 0) = 0;
+
+    // Whether blending onto v reduces to scale * v + offset per pixel
+    virtual bool isAffine() const = 0;
+
+    // Fold this layer into scale and offset (the affine blend of the layers
+    // under it so far); only when isAffine()
+    virtual void composeAffine(HeightMap& scale, HeightMap& offset) = 0;
+
+    // Get ready to composite at this size (resample ahead, pool may be null)
+    virtual void prepare(int width, int height, ThreadPool* pool) = 0;
+
+    // Resample contents to a new native size (pool may be null)
+    virtual void resize(int width, int height, ThreadPool* pool) = 0;
+
 protected:
     std::string name_;
     BlendMode blendMode_ = BlendMode::NORMAL;
@@ -12,41 +12,99 @@ LayerGroup::LayerGroup(const std::string& name, int width, int height)
 }
 
 void LayerGroup::composite(HeightMap& output, const HeightMap& below) {
+    output = below;
+
+    CompositeScratch scratch;
+    compositeInPlace(output, scratch);
+}
+
+void LayerGroup::compositeRegion(HeightMap& target, const CompositeRect& rect,
+                                 CompositeScratch& scratch, size_t depth) {
     if (!visible_ || opacity_ < 0.01f) {
-        // Group not visible, just copy below
-        output = below;
+        // Group not visible, leave below as it is
+        return;
+    }
+
+    // Fully opaque: children blend straight onto the target
+    if (opacity_ >= 0.99f) {
+        for (auto& child : children_) {
+            if (child->isVisible()) {
+                child->compositeRegion(target, rect, scratch, depth);
+            }
+        }
         return;
     }
 
-    // Composite all children recursively
-    // Start with the "below" heightmap
-    HeightMap groupResult = below;
+    // Otherwise composite the children over a copy of below (this depth's
+    // buffer; nested groups take the next one), then fade it in
+    int width = target.getWidth();
+    HeightMap& groupResult = scratch.acquire(depth, width, target.getHeight());
+    for (int y = rect.y; y < rect.y + rect.height; ++y) {
+        const float* row = target.getData() + static_cast<size_t>(y) * width + rect.x;
+        std::copy(row, row + rect.width, groupResult.getData() + static_cast<size_t>(y) * width + rect.x);
+    }
 
     for (auto& child : children_) {
-        if (!child->isVisible()) continue;
+        if (child->isVisible()) {
+            child->compositeRegion(groupResult, rect, scratch, depth + 1);
+        }
+    }
+
+    // Blend group result with below using group opacity
+    for (int y = rect.y; y < rect.y + rect.height; ++y) {
+        for (int x = rect.x; x < rect.x + rect.width; ++x) {
+            float belowValue = target.at(x, y);
+            float groupValue = groupResult.at(x, y);
+            target.at(x, y) = belowValue + (groupValue - belowValue) * opacity_;
+        }
+    }
+}
 
-        HeightMap childOutput(width_, height_);
-        child->composite(childOutput, groupResult);
+bool LayerGroup::isAffine() const {
+    if (!visible_ || opacity_ < 0.01f) {
+        return true;  // Identity
+    }
 
-        // Child result becomes the new "below" for next child
-        groupResult = childOutput;
+    // A faded group would need its own scale and offset; not worth it
+    if (opacity_ < 0.99f) {
+        return false;
     }
 
-    // Apply group opacity and blend mode
-    if (opacity_ >= 0.99f) {
-        output = groupResult;
-    } else {
-        // Blend group result with below using group opacity
-        for (int y = 0; y < height_; ++y) {
-            for (int x = 0; x < width_; ++x) {
-                float belowValue = below.at(x, y);
-                float groupValue = groupResult.at(x, y);
-                output.at(x, y) = belowValue + (groupValue - belowValue) * opacity_;
-            }
+    return std::all_of(children_.begin(), children_.end(), [](const auto& child) {
+        return !child->isVisible() || child->isAffine();
+    });
+}
+
+void LayerGroup::composeAffine(HeightMap& scale, HeightMap& offset) {
+    if (!visible_ || opacity_ < 0.01f) {
+        return;
+    }
+
+    for (auto& child : children_) {
+        if (child->isVisible()) {
+            child->composeAffine(scale, offset);
         }
     }
 }
 
+void LayerGroup::prepare(int width, int height, ThreadPool* pool) {
+    if (!visible_) return;
+
+    for (auto& child : children_) {
+        if (child->isVisible()) {
+            child->prepare(width, height, pool);
+        }
+    }
+}
+
+void LayerGroup::resize(int width, int height, ThreadPool* pool) {
+    for (auto& child : children_) {
+        child->resize(width, height, pool);
+    }
+    width_ = width;
+    height_ = height;
+}
+
 LayerBase* LayerGroup::getChild(size_t index) {
     if (index >= children_.size()) {
         throw std::out_of_range("Layer group child index out of range");
@@ -66,11 +124,6 @@ void LayerGroup::addChild(std::unique_ptr<LayerBase> child) {
         throw std::invalid_argument("Cannot add null child to layer group");
     }
 
-    // Verify dimensions match
-    if (child->getWidth() != width_ || child->getHeight() != height_) {
-        throw std::invalid_argument("Child layer dimensions must match group dimensions");
-    }
-
     children_.push_back(std::move(child));
 }
 
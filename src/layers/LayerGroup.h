@@ -21,8 +21,8 @@ public:
      * Create a new layer group
      *
      * @param name Group name
-     * @param width Heightmap width (must match child layers)
-     * @param height Heightmap height (must match child layers)
+     * @param width Heightmap width (size new children are created at)
+     * @param height Heightmap height (size new children are created at)
      */
     LayerGroup(const std::string& name, int width, int height);
 
@@ -33,6 +33,12 @@ public:
     int getHeight() const override { return height_; }
 
     void composite(HeightMap& output, const HeightMap& below) override;
+    void compositeRegion(HeightMap& target, const CompositeRect& rect,
+                         CompositeScratch& scratch, size_t depth = 0) override;
+    bool isAffine() const override;
+    void composeAffine(HeightMap& scale, HeightMap& offset) override;
+    void prepare(int width, int height, ThreadPool* pool) override;
+    void resize(int width, int height, ThreadPool* pool) override;
 
     // Child management
     size_t getChildCount() const { return children_.size(); }
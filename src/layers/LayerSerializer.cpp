@@ -227,6 +227,8 @@ static void serializeLayer(const LayerBase* layer, json& layerJson, const std::s
         const TerrainLayer* terrainLayer = dynamic_cast<const TerrainLayer*>(layer);
         if (terrainLayer) {
             layerJson["type"] = LayerSerializer::layerTypeToString(terrainLayer->getType());
+            layerJson["width"] = terrainLayer->getWidth();   // Native size, may differ from the stack's
+            layerJson["height"] = terrainLayer->getHeight();
             
             std::ostringstream heightmapFilename;
             heightmapFilename << "layer_" << fileCounter++ << "_heightmap.raw";
@@ -243,6 +245,8 @@ static void serializeLayer(const LayerBase* layer, json& layerJson, const std::s
                 
                 if (LayerSerializer::saveHeightMapRaw(terrainLayer->getMask(), maskPath)) {
                     layerJson["mask"] = maskFilename.str();
+                    layerJson["maskWidth"] = terrainLayer->getMask().getWidth();
+                    layerJson["maskHeight"] = terrainLayer->getMask().getHeight();
                 }
             }
         }
@@ -271,7 +275,9 @@ static std::unique_ptr<LayerBase> deserializeLayer(const json& layerJson, const
         layer = std::move(group);
     } else {
         LayerType layerType = LayerSerializer::stringToLayerType(type);
-        auto terrainLayer = std::make_unique<TerrainLayer>(name, layerType, width, height);
+        int layerWidth = layerJson.value("width", width);    // Older files: stack size
+        int layerHeight = layerJson.value("height", height);
+        auto terrainLayer = std::make_unique<TerrainLayer>(name, layerType, layerWidth, layerHeight);
         
         if (layerJson.contains("heightmap")) {
             std::string heightmapFilename = layerJson["heightmap"];
@@ -284,14 +290,18 @@ static std::unique_ptr<LayerBase> deserializeLayer(const json& layerJson, const
         }
         
         if (layerJson.contains("mask")) {
-            terrainLayer->createMask();
             std::string maskFilename = layerJson["mask"];
             std::string maskPath = dir.empty() ? maskFilename : (dir + "/" + maskFilename);
-            
-            if (!LayerSerializer::loadHeightMapRaw(terrainLayer->getMask(), maskPath)) {
+
+            // Read at the size it was saved at, then fit it to the heights
+            int maskWidth = layerJson.value("maskWidth", layerWidth);    // Older files: layer size
+            int maskHeight = layerJson.value("maskHeight", layerHeight);
+            HeightMap mask(maskWidth, maskHeight);
+            if (!LayerSerializer::loadHeightMapRaw(mask, maskPath)) {
                 errorMsg = "Failed to load mask: " + maskPath;
                 return nullptr;
             }
+            terrainLayer->setMask(mask);
         }
         
         layer = std::move(terrainLayer);
@@ -14,25 +14,19 @@ LayerStack::LayerStack(int width, int height)
 }
 
 void LayerStack::addLayer(std::unique_ptr<LayerBase> layer) {
-    if (layer->getWidth() != width_ || layer->getHeight() != height_) {
-        throw std::runtime_error("Layer dimensions must match stack dimensions");
-    }
-
     layers_.push_back(std::move(layer));
     activeLayerIndex_ = layers_.size() - 1;  // Make new layer active
+    splitValid_ = false;
 }
 
 void LayerStack::insertLayer(size_t index, std::unique_ptr<LayerBase> layer) {
-    if (layer->getWidth() != width_ || layer->getHeight() != height_) {
-        throw std::runtime_error("Layer dimensions must match stack dimensions");
-    }
-
     if (index > layers_.size()) {
         index = layers_.size();
     }
 
     layers_.insert(layers_.begin() + index, std::move(layer));
     activeLayerIndex_ = index;  // Make inserted layer active
+    splitValid_ = false;
 }
 
 void LayerStack::removeLayer(size_t index) {
@@ -50,6 +44,7 @@ void LayerStack::removeLayer(size_t index) {
     if (activeLayerIndex_ >= layers_.size()) {
         activeLayerIndex_ = layers_.size() - 1;
     }
+    splitValid_ = false;
 }
 
 std::unique_ptr<LayerBase> LayerStack::removeAndReturnLayer(size_t index) {
@@ -63,6 +58,7 @@ std::unique_ptr<LayerBase> LayerStack::removeAndReturnLayer(size_t index) {
 
     auto layer = std::move(layers_[index]);
     layers_.erase(layers_.begin() + index);
+    splitValid_ = false;
 
     // Adjust active layer index
     if (activeLayerIndex_ >= layers_.size()) {
@@ -86,6 +82,7 @@ void LayerStack::moveLayer(size_t fromIndex, size_t toIndex) {
     layers_.insert(layers_.begin() + toIndex, std::move(layer));
 
     activeLayerIndex_ = toIndex;
+    splitValid_ = false;
 }
 
 std::unique_ptr<LayerBase> LayerStack::duplicateLayer(size_t index) {
@@ -108,8 +105,8 @@ std::unique_ptr<LayerBase> LayerStack::duplicateLayer(size_t index) {
     auto duplicate = std::make_unique<TerrainLayer>(
         terrainLayer->getName() + " Copy",
         terrainLayer->getType(),
-        width_,
-        height_
+        terrainLayer->getWidth(),
+        terrainLayer->getHeight()
     );
 
     // Copy heightmap data
@@ -164,9 +161,10 @@ void LayerStack::mergeDown(size_t index) {
         throw std::runtime_error("Invalid layer type");
     }
 
-    // Composite upper onto lower
-    HeightMap tempBelow = lowerLayer->getHeightMap();
-    HeightMap tempOutput(width_, height_);
+    // Composite upper onto lower, at the lower layer's size
+    const TerrainLayer* constLower = lowerLayer;
+    const HeightMap& tempBelow = constLower->getHeightMap();
+    HeightMap tempOutput(tempBelow.getWidth(), tempBelow.getHeight());
 
     upperLayer->composite(tempOutput, tempBelow);
 
@@ -180,6 +178,7 @@ void LayerStack::mergeDown(size_t index) {
 void LayerStack::clear() {
     layers_.clear();
     activeLayerIndex_ = 0;
+    splitValid_ = false;
 }
 
 LayerBase* LayerStack::getLayer(size_t index) {
@@ -235,24 +234,38 @@ const TerrainLayer* LayerStack::getActiveTerrainLayer() const {
     return getLayerAsTerrainLayer(activeLayerIndex_);
 }
 
-void LayerStack::composite(HeightMap& output) {
-    // Ensure output is correct size
-    if (output.getWidth() != width_ || output.getHeight() != height_) {
-        throw std::runtime_error("Output heightmap dimensions must match stack dimensions");
+void LayerStack::setResolution(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("Layer stack dimensions must be positive");
     }
 
+    width_ = width;
+    height_ = height;
+}
+
+void LayerStack::composite(HeightMap& output, ThreadPool* pool) {
     // Start with empty heightmap
     if (layers_.empty()) {
         output.clear();
         return;
     }
 
-    // Use the new composite() method from LayerBase
-    // Start with base layer (clear output first)
-    output.clear();
+    int width = output.getWidth();
+    int height = output.getHeight();
 
-    HeightMap below(width_, height_);
-    below.clear();
+    // Resample layers of another size up front, where rows can go parallel
+    for (auto& layer : layers_) {
+        if (layer->isVisible()) {
+            layer->prepare(width, height, pool);
+        }
+    }
+
+    // Anything may have changed since the split was cached
+    splitValid_ = false;
+
+    // Blend every layer onto the output in place, bottom to top; groups
+    // borrow scratch_ rather than allocating
+    output.clear();
 
     for (size_t i = 0; i < layers_.size(); i++) {
         LayerBase* layer = layers_[i].get();
@@ -261,13 +274,128 @@ void LayerStack::composite(HeightMap& output) {
             continue;  // Skip invisible layers
         }
 
-        HeightMap temp(width_, height_);
-        layer->composite(temp, below);
+        layer->compositeInPlace(output, scratch_);
+    }
+}
+
+bool LayerStack::compositeRegion(HeightMap& output, int x, int y, int width, int height,
+                                 ThreadPool* pool) {
+    if (layers_.empty()) {
+        output.clear();
+        return true;
+    }
+
+    bool splitMatches = splitValid_ && splitIndex_ == activeLayerIndex_ &&
+                        belowComposite_->getWidth() == output.getWidth() &&
+                        belowComposite_->getHeight() == output.getHeight();
+    if (!splitMatches) {
+        buildSplit(output, pool);
+        return true;
+    }
+
+    // Clip to the map
+    int x0 = std::max(0, x);
+    int y0 = std::max(0, y);
+    int x1 = std::min(output.getWidth(), x + width);
+    int y1 = std::min(output.getHeight(), y + height);
+    if (x0 >= x1 || y0 >= y1) {
+        return false;
+    }
+    CompositeRect rect{x0, y0, x1 - x0, y1 - y0};
+    int mapWidth = output.getWidth();
+
+    // Cached below, then the active layer
+    for (int row = y0; row < y1; ++row) {
+        size_t offset = static_cast<size_t>(row) * mapWidth + x0;
+        std::copy(belowComposite_->getData() + offset, belowComposite_->getData() + offset + rect.width,
+                  output.getData() + offset);
+    }
+
+    LayerBase* active = layers_[activeLayerIndex_].get();
+    if (active->isVisible()) {
+        active->compositeRegion(output, rect, scratch_);
+    }
+
+    // Then everything above it
+    if (aboveAffine_) {
+        for (int row = y0; row < y1; ++row) {
+            size_t offset = static_cast<size_t>(row) * mapWidth;
+            const float* scale = aboveScale_->getData() + offset;
+            const float* bias = aboveOffset_->getData() + offset;
+            float* out = output.getData() + offset;
+            for (int col = x0; col < x1; ++col) {
+                out[col] = out[col] * scale[col] + bias[col];
+            }
+        }
+    } else {
+        for (size_t i = activeLayerIndex_ + 1; i < layers_.size(); ++i) {
+            if (layers_[i]->isVisible()) {
+                layers_[i]->compositeRegion(output, rect, scratch_);
+            }
+        }
+    }
+
+    return false;
+}
+
+void LayerStack::buildSplit(HeightMap& output, ThreadPool* pool) {
+    int width = output.getWidth();
+    int height = output.getHeight();
 
-        // Result becomes the new "below" for next layer
-        below = temp;
+    for (auto& layer : layers_) {
+        if (layer->isVisible()) {
+            layer->prepare(width, height, pool);
+        }
+    }
+
+    auto ensureSize = [&](std::unique_ptr<HeightMap>& map) {
+        if (!map || map->getWidth() != width || map->getHeight() != height) {
+            map = std::make_unique<HeightMap>(width, height);
+        }
+    };
+
+    // Below the active layer
+    output.clear();
+    for (size_t i = 0; i < activeLayerIndex_ && i < layers_.size(); ++i) {
+        if (layers_[i]->isVisible()) {
+            layers_[i]->compositeInPlace(output, scratch_);
+        }
+    }
+    ensureSize(belowComposite_);
+    std::copy(output.getData(), output.getData() + output.getSize(), belowComposite_->getData());
+
+    if (activeLayerIndex_ < layers_.size() && layers_[activeLayerIndex_]->isVisible()) {
+        layers_[activeLayerIndex_]->compositeInPlace(output, scratch_);
+    }
+
+    // Above it: folded into scale and offset if every layer is affine
+    aboveAffine_ = true;
+    for (size_t i = activeLayerIndex_ + 1; i < layers_.size(); ++i) {
+        if (layers_[i]->isVisible() && !layers_[i]->isAffine()) {
+            aboveAffine_ = false;
+            break;
+        }
+    }
+
+    if (aboveAffine_) {
+        ensureSize(aboveScale_);
+        ensureSize(aboveOffset_);
+        aboveScale_->fill(1.0f);
+        aboveOffset_->clear();
+        for (size_t i = activeLayerIndex_ + 1; i < layers_.size(); ++i) {
+            if (layers_[i]->isVisible()) {
+                layers_[i]->composeAffine(*aboveScale_, *aboveOffset_);
+            }
+        }
+    }
+
+    // The output itself is composited directly, so it matches composite()
+    for (size_t i = activeLayerIndex_ + 1; i < layers_.size(); ++i) {
+        if (layers_[i]->isVisible()) {
+            layers_[i]->compositeInPlace(output, scratch_);
+        }
     }
 
-    // Final result
-    output = below;
+    splitIndex_ = activeLayerIndex_;
+    splitValid_ = true;
 }
@@ -4,6 +4,7 @@
 #include "TerrainLayer.h"
 #include "LayerGroup.h"
 #include "HeightMap.h"
+#include "ThreadPool.h"
 #include <vector>
 #include <memory>
 #include <string>
@@ -14,14 +15,18 @@
  * Manages a hierarchical stack of layers and groups.
  * Supports both flat layers and nested groups.
  * Layers are stored bottom-to-top (layer 0 is base, higher indices are on top).
+ *
+ * Layers keep their own resolution; the stack's width and height are just
+ * the size new layers are created at. composite() works at whatever size
+ * the output has, resampling layers that differ (cached per layer).
  */
 class LayerStack {
 public:
     /**
      * Create a new layer stack
      *
-     * @param width Heightmap width (all layers must match this)
-     * @param height Heightmap height (all layers must match this)
+     * @param width Heightmap width (size new layers are created at)
+     * @param height Heightmap height (size new layers are created at)
      */
     LayerStack(int width, int height);
 
@@ -88,11 +93,40 @@ public:
 
     // Compositing
     /**
-     * Composite all visible layers into output heightmap
+     * Composite all visible layers into output heightmap, at output's size
+     *
+     * This recursively composites groups and layers. Layers of another
+     * size are resampled first (bicubic up, bilinear down), rows split
+     * across pool (may be null); the copies are reused until a layer changes.
+     */
+    void composite(HeightMap& output, ThreadPool* pool = nullptr);
+
+    /**
+     * Recomposite only a rectangle of output (clipped to it)
+     *
+     * For repeated edits to the active layer: assumes nothing else changed
+     * since output was last composited, and the active layer only inside
+     * the rectangle. Layers below the active one are cached as a single
+     * map, and layers above it reduced to a per-pixel scale and offset when
+     * their blend modes allow (otherwise they are blended over the
+     * rectangle), so the cost follows the rectangle, not the stack. The
+     * first call after composite() or a change to the stack rebuilds the
+     * caches with a full composite.
+     *
+     * Edits made any other way (undo, generation) need composite() first.
+     *
+     * @return true if it fell back to a full composite, so all of output
+     *         changed rather than just the rectangle
+     */
+    bool compositeRegion(HeightMap& output, int x, int y, int width, int height,
+                         ThreadPool* pool = nullptr);
+
+    /**
+     * Change the size new layers are created at
      *
-     * This recursively composites groups and layers.
+     * Existing layers keep their data and native size.
      */
-    void composite(HeightMap& output);
+    void setResolution(int width, int height);
 
     // Dimensions
     int getWidth() const { return width_; }
@@ -102,4 +136,16 @@ private:
     std::vector<std::unique_ptr<LayerBase>> layers_;
     size_t activeLayerIndex_;
     int width_, height_;
+    CompositeScratch scratch_;  // Group buffers reused across composites
+
+    // Composite split around the active layer, for compositeRegion()
+    bool splitValid_ = false;
+    size_t splitIndex_ = 0;
+    bool aboveAffine_ = false;
+    std::unique_ptr<HeightMap> belowComposite_;  // Layers under the active one
+    std::unique_ptr<HeightMap> aboveScale_;      // Layers over it, as scale * v + offset
+    std::unique_ptr<HeightMap> aboveOffset_;
+
+    // Full composite of output that also fills the split caches
+    void buildSplit(HeightMap& output, ThreadPool* pool);
 };
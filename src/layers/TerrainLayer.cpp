@@ -1,7 +1,27 @@
 #include "TerrainLayer.h"
+#include "Filters.h"
 #include <algorithm>
 #include <cmath>
 
+namespace {
+// Enlarging gets the sharper filter; bilinear is enough when shrinking
+Filters::Interpolation interpolationFor(const HeightMap& src, const HeightMap& dst) {
+    return dst.getWidth() > src.getWidth() || dst.getHeight() > src.getHeight()
+        ? Filters::Interpolation::BICUBIC
+        : Filters::Interpolation::BILINEAR;
+}
+
+// Resampled samples [first, last) whose taps (at most 2 source pixels either
+// side of their position) can read source pixels [srcFirst, srcLast)
+void affectedSpan(int srcFirst, int srcLast, int srcCount, int dstCount, int& first, int& last) {
+    float ratio = static_cast<float>(srcCount) / dstCount;
+    first = static_cast<int>(std::floor((srcFirst - 1.5f) / ratio - 0.5f)) - 1;
+    last = static_cast<int>(std::ceil((srcLast + 1.5f) / ratio - 0.5f)) + 1;
+    first = std::clamp(first, 0, dstCount);
+    last = std::clamp(last, first, dstCount);
+}
+} // namespace
+
 TerrainLayer::TerrainLayer(const std::string& name, LayerType type, int width, int height)
     : type_(type)
     , heightMap_(width, height)
@@ -33,22 +53,183 @@ void TerrainLayer::composite(HeightMap& output, const HeightMap& below) {
         return;
     }
 
-    int width = heightMap_.getWidth();
-    int height = heightMap_.getHeight();
+    // Each pixel only reads its own below value, so output may alias below
+    const HeightMap* layer;
+    const HeightMap* mask;
+    sources(output.getWidth(), output.getHeight(), layer, mask);
 
     // Apply blend mode
-    applyBlendMode(output, below, blendMode_, opacity_);
+    CompositeRect rect{0, 0, output.getWidth(), output.getHeight()};
+    applyBlendMode(output, below, *layer, mask, rect, blendMode_, opacity_);
+}
+
+void TerrainLayer::compositeRegion(HeightMap& target, const CompositeRect& rect,
+                                   CompositeScratch&, size_t) {
+    if (!visible_ || opacity_ < 0.01f) {
+        return;
+    }
+
+    const HeightMap* layer;
+    const HeightMap* mask;
+    sources(target.getWidth(), target.getHeight(), layer, mask);
+    applyBlendMode(target, target, *layer, mask, rect, blendMode_, opacity_);
+}
+
+bool TerrainLayer::isAffine() const {
+    if (!visible_ || opacity_ < 0.01f) {
+        return true;  // Identity
+    }
+
+    // MAX, MIN and OVERLAY branch on the value below
+    switch (blendMode_) {
+        case BlendMode::NORMAL:
+        case BlendMode::ADD:
+        case BlendMode::SUBTRACT:
+        case BlendMode::MULTIPLY:
+        case BlendMode::SCREEN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void TerrainLayer::composeAffine(HeightMap& scale, HeightMap& offset) {
+    if (!visible_ || opacity_ < 0.01f) {
+        return;
+    }
+
+    const HeightMap* layer;
+    const HeightMap* mask;
+    sources(scale.getWidth(), scale.getHeight(), layer, mask);
+
+    // Each mode as a * below + b, rearranged from applyBlendMode
+    float* scaleData = scale.getData();
+    float* offsetData = offset.getData();
+    const float* layerData = layer->getData();
+    const float* maskData = mask ? mask->getData() : nullptr;
+
+    for (size_t i = 0; i < scale.getSize(); ++i) {
+        float layerValue = layerData[i];
+        float amount = opacity_ * (maskData ? maskData[i] : 1.0f);
+
+        float a = 1.0f;
+        float b = 0.0f;
+        switch (blendMode_) {
+            case BlendMode::NORMAL:
+                a = 1.0f - amount;
+                b = layerValue * amount;
+                break;
+            case BlendMode::ADD:
+                b = layerValue * amount;
+                break;
+            case BlendMode::SUBTRACT:
+                b = -layerValue * amount;
+                break;
+            case BlendMode::MULTIPLY:
+                a = 1.0f + (layerValue - 1.0f) * amount;
+                break;
+            case BlendMode::SCREEN:
+                a = 1.0f - layerValue * amount;
+                b = layerValue * amount;
+                break;
+            default:
+                break;  // Not affine; isAffine() rules these out
+        }
+
+        scaleData[i] *= a;
+        offsetData[i] = offsetData[i] * a + b;
+    }
+}
+
+void TerrainLayer::sources(int width, int height, const HeightMap*& layer, const HeightMap*& mask) {
+    // Native data if it matches, otherwise a resampled copy (prepared ahead
+    // by LayerStack, or made now)
+    if (isNativeSize(width, height)) {
+        layer = &heightMap_;
+        mask = hasMask_ ? &mask_ : nullptr;
+    } else {
+        const ResampledCopy& copy = resampledCopy(width, height, nullptr);
+        layer = &copy.heights;
+        mask = copy.mask.get();
+    }
+}
+
+void TerrainLayer::markModified(const CompositeRect& rect) {
+    for (auto& copy : resampled_) {
+        // Stale copies are rebuilt in full when next used anyway
+        if (copy->revision != revision_ || hasMask_ != (copy->mask != nullptr)) {
+            continue;
+        }
+
+        int x0, x1, y0, y1;
+        affectedSpan(rect.x, rect.x + rect.width, heightMap_.getWidth(), copy->heights.getWidth(), x0, x1);
+        affectedSpan(rect.y, rect.y + rect.height, heightMap_.getHeight(), copy->heights.getHeight(), y0, y1);
+
+        Filters::resampleRegion(heightMap_, copy->heights, x0, y0, x1 - x0, y1 - y0, nullptr,
+                                interpolationFor(heightMap_, copy->heights));
+        if (copy->mask) {
+            Filters::resampleRegion(mask_, *copy->mask, x0, y0, x1 - x0, y1 - y0, nullptr,
+                                    interpolationFor(mask_, *copy->mask));
+        }
+        copy->revision = revision_ + 1;
+    }
+    ++revision_;
+}
+
+void TerrainLayer::prepare(int width, int height, ThreadPool* pool) {
+    if (!isNativeSize(width, height)) {
+        resampledCopy(width, height, pool);
+    }
+}
+
+bool TerrainLayer::isNativeSize(int width, int height) const {
+    bool heightsMatch = heightMap_.getWidth() == width && heightMap_.getHeight() == height;
+    bool maskMatches = !hasMask_ || (mask_.getWidth() == width && mask_.getHeight() == height);
+    return heightsMatch && maskMatches;
 }
 
-void TerrainLayer::applyBlendMode(HeightMap& output, const HeightMap& below, BlendMode mode, float opacity) {
-    int width = heightMap_.getWidth();
-    int height = heightMap_.getHeight();
+const TerrainLayer::ResampledCopy& TerrainLayer::resampledCopy(int width, int height, ThreadPool* pool) {
+    auto it = std::find_if(resampled_.begin(), resampled_.end(), [&](const auto& copy) {
+        return copy->heights.getWidth() == width && copy->heights.getHeight() == height;
+    });
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
+    std::unique_ptr<ResampledCopy> copy;
+    bool stale = true;
+    if (it != resampled_.end()) {
+        copy = std::move(*it);
+        resampled_.erase(it);
+        stale = copy->revision != revision_ || hasMask_ != (copy->mask != nullptr);
+    } else {
+        if (resampled_.size() >= MAX_RESAMPLED) {
+            resampled_.erase(resampled_.begin());
+        }
+        copy = std::make_unique<ResampledCopy>(ResampledCopy{revision_, HeightMap(width, height), nullptr});
+    }
+
+    if (stale) {
+        Filters::resample(heightMap_, copy->heights, pool, interpolationFor(heightMap_, copy->heights));
+        if (hasMask_) {
+            if (!copy->mask) {
+                copy->mask = std::make_unique<HeightMap>(width, height);
+            }
+            Filters::resample(mask_, *copy->mask, pool, interpolationFor(mask_, *copy->mask));
+        } else {
+            copy->mask.reset();
+        }
+        copy->revision = revision_;
+    }
+
+    resampled_.push_back(std::move(copy));
+    return *resampled_.back();
+}
+
+void TerrainLayer::applyBlendMode(HeightMap& output, const HeightMap& below, const HeightMap& layer,
+                                  const HeightMap* mask, const CompositeRect& rect, BlendMode mode, float opacity) {
+    for (int y = rect.y; y < rect.y + rect.height; ++y) {
+        for (int x = rect.x; x < rect.x + rect.width; ++x) {
             float belowValue = below.at(x, y);
-            float layerValue = heightMap_.at(x, y);
-            float maskValue = hasMask_ ? mask_.at(x, y) : 1.0f;
+            float layerValue = layer.at(x, y);
+            float maskValue = mask ? mask->at(x, y) : 1.0f;
 
             float blended = belowValue;
 
@@ -109,22 +290,72 @@ void TerrainLayer::applyBlendMode(HeightMap& output, const HeightMap& below, Ble
     }
 }
 
-void TerrainLayer::createMask() {
+void TerrainLayer::resize(int width, int height, ThreadPool* pool) {
+    if (isNativeSize(width, height)) {
+        return;
+    }
+
+    HeightMap resized(width, height);
+    Filters::resample(heightMap_, resized, pool, interpolationFor(heightMap_, resized));
+    heightMap_ = std::move(resized);
+
+    // Without a mask it's all white, which needs no resampling
+    HeightMap resizedMask(width, height);
     if (hasMask_) {
-        return;  // Already has a mask
+        Filters::resample(mask_, resizedMask, pool, interpolationFor(mask_, resizedMask));
+    } else {
+        resizedMask.fill(1.0f);
     }
+    mask_ = std::move(resizedMask);
+    ++revision_;
+    resampled_.clear();
+}
 
-    // Initialize mask to white (full effect everywhere)
-    int width = heightMap_.getWidth();
-    int height = heightMap_.getHeight();
+void TerrainLayer::setHeightMap(HeightMap heights, ThreadPool* pool) {
+    int width = heights.getWidth();
+    int height = heights.getHeight();
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            mask_.at(x, y) = 1.0f;
+    if (mask_.getWidth() != width || mask_.getHeight() != height) {
+        // Without a mask it's all white, which needs no resampling
+        HeightMap resizedMask(width, height);
+        if (hasMask_) {
+            Filters::resample(mask_, resizedMask, pool, interpolationFor(mask_, resizedMask));
+        } else {
+            resizedMask.fill(1.0f);
         }
+        mask_ = std::move(resizedMask);
     }
 
+    heightMap_ = std::move(heights);
+    ++revision_;
+}
+
+void TerrainLayer::setMask(const HeightMap& mask, ThreadPool* pool) {
+    if (mask.getWidth() == heightMap_.getWidth() && mask.getHeight() == heightMap_.getHeight()) {
+        mask_ = mask;
+    } else {
+        HeightMap resizedMask(heightMap_.getWidth(), heightMap_.getHeight());
+        Filters::resample(mask, resizedMask, pool, interpolationFor(mask, resizedMask));
+        mask_ = std::move(resizedMask);
+    }
+
+    hasMask_ = true;
+    ++revision_;
+}
+
+void TerrainLayer::createMask() {
+    if (hasMask_) {
+        return;  // Already has a mask
+    }
+
+    // Initialize mask to white (full effect everywhere), at the heights' size
+    if (mask_.getWidth() != heightMap_.getWidth() || mask_.getHeight() != heightMap_.getHeight()) {
+        mask_ = HeightMap(heightMap_.getWidth(), heightMap_.getHeight());
+    }
+    mask_.fill(1.0f);
+
     hasMask_ = true;
+    ++revision_;
 }
 
 void TerrainLayer::deleteMask() {
@@ -133,16 +364,10 @@ void TerrainLayer::deleteMask() {
     }
 
     // Reset mask to white (so it doesn't affect compositing if accidentally used)
-    int width = heightMap_.getWidth();
-    int height = heightMap_.getHeight();
-
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            mask_.at(x, y) = 1.0f;
-        }
-    }
+    mask_.fill(1.0f);
 
     hasMask_ = false;
+    ++revision_;
 }
 
 void TerrainLayer::invertMask() {
@@ -150,12 +375,9 @@ void TerrainLayer::invertMask() {
         return;  // No mask to invert
     }
 
-    int width = heightMap_.getWidth();
-    int height = heightMap_.getHeight();
-
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            mask_.at(x, y) = 1.0f - mask_.at(x, y);
-        }
+    float* data = mask_.getData();
+    for (size_t i = 0; i < mask_.getSize(); ++i) {
+        data[i] = 1.0f - data[i];
     }
+    ++revision_;
 }
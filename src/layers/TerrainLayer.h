@@ -2,14 +2,23 @@
 
 #include "LayerBase.h"
 #include "HeightMap.h"
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 /**
  * Individual terrain layer
  *
  * Stores heightmap data, mask, and properties for non-destructive editing.
  * Similar to Photoshop layers or Gaea layers.
+ *
+ * Data stays at the layer's native resolution; compositing into a map of
+ * another size samples a resampled copy. Copies are cached per size and
+ * dropped once the data changes (any non-const access counts as a change,
+ * as does markModified() for writes through a pointer kept from earlier).
+ * Local edits (brushes, stamps) patch the copies instead: write through
+ * editHeightMap()/editMask() and report the area with markModified(rect).
  */
 class TerrainLayer : public LayerBase {
 public:
@@ -30,14 +39,47 @@ public:
     int getHeight() const override { return heightMap_.getHeight(); }
 
     void composite(HeightMap& output, const HeightMap& below) override;
+    void compositeRegion(HeightMap& target, const CompositeRect& rect,
+                         CompositeScratch& scratch, size_t depth = 0) override;
+    bool isAffine() const override;
+    void composeAffine(HeightMap& scale, HeightMap& offset) override;
+    void prepare(int width, int height, ThreadPool* pool) override;
+    void resize(int width, int height, ThreadPool* pool) override;
 
-    // Layer-specific data access
-    HeightMap& getHeightMap() { return heightMap_; }
+    // Layer-specific data access (non-const access invalidates resampled copies)
+    HeightMap& getHeightMap() { ++revision_; return heightMap_; }
     const HeightMap& getHeightMap() const { return heightMap_; }
 
-    HeightMap& getMask() { return mask_; }
+    HeightMap& getMask() { ++revision_; return mask_; }
     const HeightMap& getMask() const { return mask_; }
 
+    // Replace the heights at any size; the mask is resampled to match, so
+    // the two never differ in size (write through getHeightMap() only at
+    // the current size)
+    void setHeightMap(HeightMap heights, ThreadPool* pool = nullptr);
+
+    // Set (and enable) the mask from a map of any size, resampled to the heights
+    void setMask(const HeightMap& mask, ThreadPool* pool = nullptr);
+
+    // Bumped whenever the data may have changed
+    uint64_t getRevision() const { return revision_; }
+
+    // For writers that hold on to the heights or mask (undo commands):
+    // call after changing them so resampled copies are rebuilt
+    void markModified() { ++revision_; }
+
+    // Write access that leaves resampled copies valid; the caller reports
+    // what it changed with markModified(rect)
+    HeightMap& editHeightMap() { return heightMap_; }
+    HeightMap& editMask() { return mask_; }
+
+    // Record an edit inside rect (native pixels): up-to-date resampled
+    // copies are re-resampled only where they read from it
+    void markModified(const CompositeRect& rect);
+
+    // Whether heights and mask are both stored at this size
+    bool isNativeSize(int width, int height) const;
+
     // Mask operations
     bool hasMask() const { return hasMask_; }
     void createMask();
@@ -49,7 +91,26 @@ private:
     HeightMap heightMap_;
     HeightMap mask_;              // Optional layer mask (white = full effect, black = no effect)
     bool hasMask_;
+    uint64_t revision_ = 0;
+
+    // Data resampled to a composite size other than the native one
+    struct ResampledCopy {
+        uint64_t revision;
+        HeightMap heights;
+        std::unique_ptr<HeightMap> mask;  // Only when hasMask_
+    };
+
+    // Most recently used last; a preview size and a full size fit
+    static constexpr size_t MAX_RESAMPLED = 2;
+    std::vector<std::unique_ptr<ResampledCopy>> resampled_;
+
+    // Copy at this size, resampled now if missing or stale
+    const ResampledCopy& resampledCopy(int width, int height, ThreadPool* pool);
+
+    // Heights and mask (null if none) to sample at this size
+    void sources(int width, int height, const HeightMap*& layer, const HeightMap*& mask);
 
     // Helper for compositing with blend modes
-    void applyBlendMode(HeightMap& output, const HeightMap& below, BlendMode mode, float opacity);
+    void applyBlendMode(HeightMap& output, const HeightMap& below, const HeightMap& layer,
+                        const HeightMap* mask, const CompositeRect& rect, BlendMode mode, float opacity);
 };
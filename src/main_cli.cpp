@@ -0,0 +1,432 @@
+/**
+ * ymirge-cli - Headless terrain generation
+ *
+ * Runs the full generation pipeline and exports without a display or GL
+ * context. Each parameter source (JSON file or preset) is generated once per
+ * requested seed. Jobs run several at a time through BatchGenerator on one
+ * shared ThreadPool, each slot reusing its TerrainGenerator's buffers.
+ *
+ *   ymirge-cli --preset "Alpine Peaks" --seeds 1-16 --formats png16,splatmap
+ *   ymirge-cli -r 2048 -o out/ coast.json canyon.json
+ */
+
+#include "BatchGenerator.h"
+#include "TerrainGenerator.h"
+#include "TerrainParams.h"
+#include "ThreadPool.h"
+#include "ImageExporter.h"
+#include "AdvancedSplatmap.h"
+#include "PresetManager.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+enum OutputFormat : unsigned {
+    OUT_PNG16    = 1u << 0,
+    OUT_PNG8     = 1u << 1,
+    OUT_RAW16    = 1u << 2,
+    OUT_OBJ      = 1u << 3,
+    OUT_SPLATMAP = 1u << 4,
+    OUT_EROSION  = 1u << 5
+};
+
+struct FormatName {
+    const char* name;
+    OutputFormat format;
+};
+
+const FormatName FORMAT_NAMES[] = {
+    {"png16", OUT_PNG16},
+    {"png8", OUT_PNG8},
+    {"raw16", OUT_RAW16},
+    {"obj", OUT_OBJ},
+    {"splatmap", OUT_SPLATMAP},
+    {"erosion", OUT_EROSION}
+};
+
+// One parameter set to generate, before seeds are applied
+struct ParamSource {
+    std::string name;  // Output file prefix
+    TerrainParams params;
+};
+
+struct Options {
+    std::vector<ParamSource> sources;
+    std::vector<uint32_t> seeds;  // Empty: each source keeps its own seed
+    unsigned formats = OUT_PNG16;
+    int resolution = 1024;
+    size_t threads = std::thread::hardware_concurrency();
+    std::string outputDir = ".";
+    int objMaxSize = 512;
+    size_t concurrent = 0;           // 0 = BatchGenerator default
+    size_t memoryBudgetMB = 2048;
+};
+
+void printUsage() {
+    std::cout <<
+        "Usage: ymirge-cli [options] [params.json ...]\n"
+        "\n"
+        "Generates one terrain per parameter source and seed. Parameter files hold\n"
+        "TerrainParams fields by name; an optional \"preset\" key selects the base\n"
+        "values the file overrides.\n"
+        "\n"
+        "Options:\n"
+        "  -p, --preset NAME       Add a preset as a parameter source (repeatable)\n"
+        "  -r, --resolution N      Heightmap size in pixels (default 1024)\n"
+        "  -s, --seeds LIST        Seeds to generate, e.g. 1,2,10-20 (default: source seed)\n"
+        "  -f, --formats LIST      png16,png8,raw16,obj,splatmap,erosion (default png16)\n"
+        "  -o, --output DIR        Output directory (default .)\n"
+        "  -t, --threads N         Worker threads (default: hardware concurrency)\n"
+        "  -j, --jobs N            Terrains generated concurrently (default: threads / 2, min 2)\n"
+        "  -m, --memory-budget MB  RAM for concurrent terrains; caps --jobs (default 2048)\n"
+        "      --obj-max-size N    Max mesh resolution for obj export (default 512)\n"
+        "      --list-presets      Print preset names and exit\n"
+        "      --dump-params       Print the resolved parameters as JSON and exit\n"
+        "  -h, --help              Show this help\n";
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+std::vector<uint32_t> parseSeeds(const std::string& list) {
+    std::vector<uint32_t> seeds;
+    for (const std::string& item : splitList(list)) {
+        size_t dash = item.find('-', 1);
+        if (dash == std::string::npos) {
+            seeds.push_back(static_cast<uint32_t>(std::stoul(item)));
+            continue;
+        }
+        uint32_t first = static_cast<uint32_t>(std::stoul(item.substr(0, dash)));
+        uint32_t last = static_cast<uint32_t>(std::stoul(item.substr(dash + 1)));
+        if (last < first) {
+            throw std::invalid_argument("Descending seed range: " + item);
+        }
+        for (uint64_t seed = first; seed <= last; ++seed) {
+            seeds.push_back(static_cast<uint32_t>(seed));
+        }
+    }
+    return seeds;
+}
+
+unsigned parseFormats(const std::string& list) {
+    unsigned formats = 0;
+    for (const std::string& item : splitList(list)) {
+        auto it = std::find_if(std::begin(FORMAT_NAMES), std::end(FORMAT_NAMES),
+                               [&](const FormatName& f) { return item == f.name; });
+        if (it == std::end(FORMAT_NAMES)) {
+            throw std::invalid_argument("Unknown output format: " + item);
+        }
+        formats |= it->format;
+    }
+    return formats;
+}
+
+// Preset names contain spaces; file prefixes shouldn't
+std::string fileSafe(const std::string& name) {
+    std::string result = name;
+    for (char& c : result) {
+        bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                    (c >= '0' && c <= '9') || c == '-' || c == '_';
+        if (!keep) c = '_';
+    }
+    return result;
+}
+
+// File prefix for one source/seed job, relative to the output directory
+std::string outputName(const ParamSource& source, uint32_t seed) {
+    return source.name + "_" + std::to_string(seed);
+}
+
+ParamSource presetSource(PresetManager& presets, const std::string& name) {
+    ParamSource source;
+    source.name = fileSafe(name);
+    if (!presets.applyPreset(name, source.params)) {
+        throw std::invalid_argument("Unknown preset: " + name);
+    }
+    return source;
+}
+
+ParamSource fileSource(PresetManager& presets, const std::string& path) {
+    std::ifstream inFile(path);
+    if (!inFile.is_open()) {
+        throw std::runtime_error("Failed to open parameter file: " + path);
+    }
+
+    json j;
+    inFile >> j;
+    if (!j.is_object()) {
+        throw std::runtime_error("Parameter file must hold a JSON object: " + path);
+    }
+
+    ParamSource source;
+    source.name = fileSafe(fs::path(path).stem().string());
+
+    if (j.contains("preset")) {
+        std::string preset = j["preset"].get<std::string>();
+        if (!presets.applyPreset(preset, source.params)) {
+            throw std::runtime_error("Unknown preset '" + preset + "' in " + path);
+        }
+    }
+
+    std::set<std::string> known = {"preset"};
+    TerrainParams::forEachField([&](const char* key, auto member) {
+        known.insert(key);
+        if (j.contains(key)) {
+            j[key].get_to(source.params.*member);
+        }
+    });
+
+    // Catch typos instead of silently generating with defaults
+    for (const auto& item : j.items()) {
+        if (known.count(item.key()) == 0) {
+            throw std::runtime_error("Unknown parameter '" + item.key() + "' in " + path);
+        }
+    }
+
+    return source;
+}
+
+json paramsToJson(const TerrainParams& params) {
+    json j;
+    TerrainParams::forEachField([&](const char* key, auto member) {
+        j[key] = params.*member;
+    });
+    return j;
+}
+
+void parseArguments(int argc, char** argv, Options& options, bool& exitEarly) {
+    PresetManager presets;
+    std::vector<std::string> paramFiles;
+    bool dumpParams = false;
+    exitEarly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            exitEarly = true;
+            return;
+        } else if (arg == "--list-presets") {
+            for (const std::string& name : presets.getPresetNames()) {
+                std::cout << name << std::endl;
+            }
+            exitEarly = true;
+            return;
+        } else if (arg == "--dump-params") {
+            dumpParams = true;
+        } else if (arg == "-p" || arg == "--preset") {
+            options.sources.push_back(presetSource(presets, value()));
+        } else if (arg == "-r" || arg == "--resolution") {
+            options.resolution = std::stoi(value());
+        } else if (arg == "-s" || arg == "--seeds") {
+            options.seeds = parseSeeds(value());
+        } else if (arg == "-f" || arg == "--formats") {
+            options.formats = parseFormats(value());
+        } else if (arg == "-o" || arg == "--output") {
+            options.outputDir = value();
+        } else if (arg == "-t" || arg == "--threads") {
+            options.threads = static_cast<size_t>(std::stoul(value()));
+        } else if (arg == "-j" || arg == "--jobs") {
+            options.concurrent = static_cast<size_t>(std::stoul(value()));
+        } else if (arg == "-m" || arg == "--memory-budget") {
+            options.memoryBudgetMB = static_cast<size_t>(std::stoul(value()));
+        } else if (arg == "--obj-max-size") {
+            options.objMaxSize = std::stoi(value());
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("Unknown option: " + arg);
+        } else {
+            paramFiles.push_back(arg);
+        }
+    }
+
+    for (const std::string& path : paramFiles) {
+        options.sources.push_back(fileSource(presets, path));
+    }
+
+    if (options.sources.empty()) {
+        options.sources.push_back({"terrain", TerrainParams()});
+    }
+
+    if (options.resolution < 2) {
+        throw std::invalid_argument("Resolution must be at least 2");
+    }
+    if (options.formats == 0) {
+        throw std::invalid_argument("No output formats selected");
+    }
+    options.threads = std::max<size_t>(1, options.threads);
+
+    // Jobs write concurrently, so two with the same name would overwrite each other
+    std::set<std::string> outputNames;
+    for (const ParamSource& source : options.sources) {
+        std::vector<uint32_t> seeds = options.seeds;
+        if (seeds.empty()) seeds.push_back(source.params.seed);
+        for (uint32_t seed : seeds) {
+            std::string name = outputName(source, seed);
+            if (!outputNames.insert(name).second) {
+                throw std::invalid_argument("Duplicate output name: " + name +
+                                            " (repeated seed, preset or parameter file name)");
+            }
+        }
+    }
+
+    if (dumpParams) {
+        for (const ParamSource& source : options.sources) {
+            json j = paramsToJson(source.params);
+            j["name"] = source.name;
+            std::cout << j.dump(4) << std::endl;
+        }
+        exitEarly = true;
+    }
+}
+
+// Writes every requested format for one generated terrain; false if any failed
+bool exportTerrain(const TerrainGenerator& generator, const Options& options,
+                   ThreadPool* pool, const std::string& basePath) {
+    const HeightMap& map = generator.getHeightMap();
+    bool ok = true;
+
+    if (options.formats & OUT_PNG16) {
+        ok &= ImageExporter::exportHeightmap(map, basePath + ".png");
+    }
+    if (options.formats & OUT_PNG8) {
+        ok &= ImageExporter::exportHeightmap8bit(map, basePath + "_8bit.png");
+    }
+    if (options.formats & OUT_RAW16) {
+        ok &= ImageExporter::exportHeightmapRAW16(map, basePath + ".raw");
+    }
+    if (options.formats & OUT_OBJ) {
+        ok &= ImageExporter::exportMeshOBJ(map, basePath + ".obj", options.objMaxSize);
+    }
+    if (options.formats & OUT_SPLATMAP) {
+        AdvancedSplatmap::ExportParams splatParams;
+        splatParams.materials = AdvancedSplatmap::createDefaultMaterials();
+        splatParams.erosionMaps = generator.getErosionMaps();
+        splatParams.pool = pool;
+        ok &= AdvancedSplatmap::exportMultiMaterial(map, splatParams, basePath + "_splat.png");
+    }
+    if (options.formats & OUT_EROSION) {
+        if (const ErosionMaps* maps = generator.getErosionMaps()) {
+            ok &= ImageExporter::exportErosionMaps(*maps, basePath + "_erosion.png");
+        } else {
+            std::cerr << "No erosion maps for " << basePath << " (erosion disabled)" << std::endl;
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    bool exitEarly = false;
+
+    try {
+        parseArguments(argc, argv, options, exitEarly);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        std::cerr << "Run ymirge-cli --help for usage" << std::endl;
+        return 2;
+    }
+    if (exitEarly) return 0;
+
+    std::error_code ec;
+    fs::create_directories(options.outputDir, ec);
+    if (ec) {
+        std::cerr << "Failed to create output directory " << options.outputDir
+                  << ": " << ec.message() << std::endl;
+        return 1;
+    }
+
+    // Flatten sources x seeds into one job list
+    std::vector<TerrainParams> jobs;
+    std::vector<const ParamSource*> jobSources;
+    for (const ParamSource& source : options.sources) {
+        if (options.seeds.empty()) {
+            jobs.push_back(source.params);
+            jobSources.push_back(&source);
+            continue;
+        }
+        for (uint32_t seed : options.seeds) {
+            jobs.push_back(source.params);
+            jobs.back().seed = seed;
+            jobSources.push_back(&source);
+        }
+    }
+
+    // Shared by every job: worker threads are created once, and each
+    // concurrent slot keeps its generator's buffers and caches warm
+    ThreadPool pool(options.threads);
+
+    BatchGenerator::Config batchConfig;
+    batchConfig.resolution = options.resolution;
+    batchConfig.maxConcurrent = options.concurrent;
+    batchConfig.memoryBudget = options.memoryBudgetMB << 20;
+    batchConfig.captureErosionMaps = (options.formats & (OUT_SPLATMAP | OUT_EROSION)) != 0;
+    BatchGenerator batch(&pool, batchConfig);
+
+    std::cout << "Generating " << jobs.size() << " terrain(s) at " << options.resolution << "x"
+              << options.resolution << " on " << pool.getThreadCount() << " threads, "
+              << std::min(batch.concurrency(), jobs.size()) << " at a time" << std::endl;
+
+    std::mutex outputMutex;
+    std::atomic<size_t> finished{0};
+    std::atomic<size_t> exportFailures{0};
+
+    BatchGenerator::Stats stats = batch.run(jobs,
+        [&](size_t index, const TerrainGenerator& generator) {
+            const ParamSource& source = *jobSources[index];
+            uint32_t seed = jobs[index].seed;
+            std::string basePath = (fs::path(options.outputDir) / outputName(source, seed)).string();
+
+            if (!exportTerrain(generator, options, &pool, basePath)) {
+                ++exportFailures;
+            }
+
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cout << "[" << ++finished << "/" << jobs.size() << "] "
+                      << source.name << " seed " << seed << std::endl;
+        });
+
+    size_t failures = stats.failed + exportFailures.load();
+    std::cout << "Done: " << (jobs.size() - failures) << "/" << jobs.size() << " succeeded in "
+              << std::fixed << std::setprecision(2) << stats.elapsedSeconds << " s ("
+              << stats.mapsPerMinute << " maps/min, " << stats.meanLatencySeconds
+              << " s per map, ~" << (stats.bytesPerGeneration >> 20) << " MB each)" << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -34,6 +34,8 @@
 #include "GaussianBlurGPU.h"
 #include "PerlinNoise.h"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <iostream>
 #include <chrono>
@@ -419,7 +421,6 @@ public:
         , screenWidth_(1600)
         , screenHeight_(900)
         , running_(true)
-        , lastUpdateWasGenerating_(false)
         , compositeHeightMap_(512, 512) {
 
         // Initialize SDL2
@@ -575,10 +576,16 @@ public:
 
         // Create thread pool
         threadPool_ = std::make_unique<ThreadPool>(std::thread::hardware_concurrency());
+        // Background work (speculative previews) leaves cores for the rest
+        threadPool_->setLaneLimit(TaskPriority::BACKGROUND,
+                                  std::max<size_t>(1, threadPool_->getThreadCount() / 2));
 
         // Create resolution manager with thread pool
         resolutionManager_ = std::make_unique<ResolutionManager>(threadPool_.get());
         resolutionManager_->setTargetResolution(Resolution::STANDARD);
+        resolutionManager_->setCaptureErosionMaps(true);
+        resolutionManager_->setProgressive(true);
+        resolutionManager_->setTileStreaming(true);
 
         // Create undo stack (50 commands max, 100MB memory limit)
         undoStack_ = std::make_unique<UndoStack>(50, 100);
@@ -608,9 +615,6 @@ public:
         // Generate initial terrain (async)
         resolutionManager_->generateAt(Resolution::STANDARD, uiManager_->getParams());
 
-        // Mark that we're generating so update() will update renderer when complete
-        lastUpdateWasGenerating_ = true;
-
         std::cout << "YmirgeSDLApp initialized successfully" << std::endl;
     }
 
@@ -678,6 +682,9 @@ private:
                 if (event.key.keysym.sym == SDLK_f) {
                     uiManager_->setActiveTool(BrushType::FLATTEN);
                 }
+                if (event.key.keysym.sym == SDLK_e) {
+                    uiManager_->setActiveTool(BrushType::ERODE);
+                }
                 if (event.key.keysym.sym == SDLK_t) {
                     uiManager_->setActiveTool(BrushType::STAMP);
                 }
@@ -692,20 +699,21 @@ private:
                     resolutionManager_->generateAt(Resolution::HIGH, uiManager_->getParams());
                 }
 
+                // Abort a running generation (collected by a later update())
+                if (event.key.keysym.sym == SDLK_ESCAPE && resolutionManager_->isGenerating()) {
+                    resolutionManager_->abortGeneration();
+                }
+
                 // Undo/Redo
                 if (mod & KMOD_CTRL) {
                     if (event.key.keysym.sym == SDLK_z) {
                         if (undoStack_->undo()) {
-                            const HeightMap& heightMap = resolutionManager_->getHeightMap();
-                            bool monochrome = uiManager_->isMonochromeMode();
-                            renderer_->updateTexture(heightMap, monochrome);
+                            refreshAfterHistoryChange();
                         }
                     }
                     if (event.key.keysym.sym == SDLK_y) {
                         if (undoStack_->redo()) {
-                            const HeightMap& heightMap = resolutionManager_->getHeightMap();
-                            bool monochrome = uiManager_->isMonochromeMode();
-                            renderer_->updateTexture(heightMap, monochrome);
+                            refreshAfterHistoryChange();
                         }
                     }
                 }
@@ -758,16 +766,12 @@ private:
         // Handle menu requests
         if (uiManager_->isUndoRequested()) {
             if (undoStack_->undo()) {
-                const HeightMap& heightMap = resolutionManager_->getHeightMap();
-                bool monochrome = uiManager_->isMonochromeMode();
-                renderer_->updateTexture(heightMap, monochrome);
+                refreshAfterHistoryChange();
             }
         }
         if (uiManager_->isRedoRequested()) {
             if (undoStack_->redo()) {
-                const HeightMap& heightMap = resolutionManager_->getHeightMap();
-                bool monochrome = uiManager_->isMonochromeMode();
-                renderer_->updateTexture(heightMap, monochrome);
+                refreshAfterHistoryChange();
             }
         }
         if (uiManager_->isClearHistoryRequested()) {
@@ -792,6 +796,7 @@ private:
                 brushManager_->setActiveBrush(activeTool);
                 brushManager_->setBrushSize(uiManager_->getBrushSize());
                 brushManager_->setBrushStrength(uiManager_->getBrushStrength());
+                brushManager_->setErosionMode(uiManager_->getErosionMode());
                 uiManager_->clearBrushChanged();
             }
 
@@ -813,6 +818,8 @@ private:
                 // Check edit mode - are we editing heightmap or mask?
                 EditMode editMode = uiManager_->getEditMode();
                 HeightMap* targetMap = nullptr;
+                TerrainLayer* targetLayer = activeLayer;  // Owner of targetMap
+                bool editingActiveLayer = true;  // Only then can a dab recomposite just its footprint
 
                 if (editMode == EditMode::MASK) {
                     // Editing mask
@@ -820,15 +827,17 @@ private:
                     TerrainLayer* maskLayer = layerStack_->getLayerAsTerrainLayer(maskLayerIndex);
 
                     if (maskLayer && maskLayer->hasMask()) {
-                        targetMap = &maskLayer->getMask();
+                        targetMap = &maskLayer->editMask();
+                        targetLayer = maskLayer;
+                        editingActiveLayer = maskLayer == activeLayer;
                     } else {
                         // No mask to edit, switch back to layer mode
                         uiManager_->setEditMode(EditMode::LAYER);
-                        targetMap = &activeLayer->getHeightMap();
+                        targetMap = &activeLayer->editHeightMap();
                     }
                 } else {
                     // Editing heightmap (default)
-                    targetMap = &activeLayer->getHeightMap();
+                    targetMap = &activeLayer->editHeightMap();
                 }
 
                 // Proceed if we have a valid target
@@ -846,20 +855,42 @@ private:
                 );
 
                 if (cursorOnTerrain) {
+                    // The layer keeps its own resolution: dab in its pixels,
+                    // at the size the brush has on the composite
+                    int layerX = toMapPixel(heightMapX, compositeHeightMap_.getWidth(), heightMap.getWidth());
+                    int layerY = toMapPixel(heightMapY, compositeHeightMap_.getHeight(), heightMap.getHeight());
+                    float layerScale = static_cast<float>(heightMap.getWidth()) / compositeHeightMap_.getWidth();
+                    int layerRadius = static_cast<int>(std::lround(uiManager_->getBrushSize() * layerScale));
+                    brushManager_->setBrushSize(layerRadius);
+
                     // Begin stroke on mouse down
                     if (leftButton && !brushManager_->isStrokeActive()) {
-                        brushManager_->beginStroke(heightMap, heightMapX, heightMapY);
+                        // Undo/redo write through the map, so they must tell its layer
+                        brushManager_->beginStroke(heightMap, layerX, layerY,
+                                                   [targetLayer] { targetLayer->markModified(); });
                     }
 
                     // Apply brush during stroke
                     if (leftButton && brushManager_->isStrokeActive()) {
-                        if (brushManager_->applyStroke(heightMap, heightMapX, heightMapY, io.DeltaTime)) {
-                            // Recomposite layers
-                            layerStack_->composite(compositeHeightMap_);
+                        if (brushManager_->applyStroke(heightMap, layerX, layerY, io.DeltaTime)) {
+                            layerRadius = brushManager_->getBrushSize();  // After the brush's clamp
+                            targetLayer->markModified({layerX - layerRadius, layerY - layerRadius,
+                                                       2 * layerRadius + 1, 2 * layerRadius + 1});
 
-                            // Update renderer immediately for visual feedback
                             bool monochrome = uiManager_->isMonochromeMode();
-                            renderer_->updateTexture(compositeHeightMap_, monochrome);
+                            if (editingActiveLayer) {
+                                // Recomposite and re-upload just the brush footprint
+                                // (plus the reach of resampling taps)
+                                int radius = static_cast<int>(std::ceil(layerRadius / layerScale)) + 2;
+                                recompositeRegion(heightMapX - radius, heightMapY - radius,
+                                                  2 * radius + 1, 2 * radius + 1, monochrome);
+                            } else {
+                                // Recomposite layers
+                                layerStack_->composite(compositeHeightMap_, threadPool_.get());
+
+                                // Update renderer immediately for visual feedback
+                                renderer_->updateTexture(compositeHeightMap_, monochrome);
+                            }
                         }
                     }
 
@@ -907,7 +938,7 @@ private:
                     // Can't place stamp on locked layer
                     std::cout << "Cannot place stamp: layer is locked or null" << std::endl;
                 } else {
-                    HeightMap& heightMap = activeLayer->getHeightMap();
+                    HeightMap& heightMap = activeLayer->editHeightMap();
                     ImVec4 viewportRect = uiManager_->getLastViewportRect();
 
                     int heightMapX, heightMapY;
@@ -921,21 +952,28 @@ private:
                     );
 
                     if (cursorOnTerrain && stampTool_->isLoaded()) {
+                        // Placed in the layer's own pixels, at the size it
+                        // has on the composite
+                        int layerX = toMapPixel(heightMapX, compositeHeightMap_.getWidth(), heightMap.getWidth());
+                        int layerY = toMapPixel(heightMapY, compositeHeightMap_.getHeight(), heightMap.getHeight());
+                        float scale = uiManager_->getStampScale() *
+                                      heightMap.getWidth() / compositeHeightMap_.getWidth();
+
                         // Create undo command and capture affected region
                         int stampW = stampTool_->getStampWidth();
                         int stampH = stampTool_->getStampHeight();
-                        float scale = uiManager_->getStampScale();
                         int radius = static_cast<int>((std::max(stampW, stampH) / 2.0f) * scale);
 
-                        auto command = std::make_unique<HeightMapEditCommand>(&heightMap, "Stamp");
+                        auto command = std::make_unique<HeightMapEditCommand>(
+                            &heightMap, "Stamp", [activeLayer] { activeLayer->markModified(); });
                         // Use square capture for stamps (not circular)
-                        command->captureRegion(heightMapX, heightMapY, radius, true);
+                        command->captureRegion(layerX, layerY, radius, true);
 
                         // Apply stamp
                         stampTool_->applyStamp(
                             heightMap,
-                            heightMapX, heightMapY,
-                            uiManager_->getStampScale(),
+                            layerX, layerY,
+                            scale,
                             uiManager_->getStampRotation(),
                             uiManager_->getStampOpacity(),
                             uiManager_->getStampHeight()
@@ -946,7 +984,7 @@ private:
                         undoStack_->push(std::move(command));
 
                         // Recomposite layers
-                        layerStack_->composite(compositeHeightMap_);
+                        layerStack_->composite(compositeHeightMap_, threadPool_.get());
 
                         // Update renderer with composite result
                         bool monochrome = uiManager_->isMonochromeMode();
@@ -976,43 +1014,77 @@ private:
             renderer_->updateCamera(mouseX, mouseY, false, false, scrollDelta);
         }
 
-        // Update renderer if generation just completed
-        if (!resolutionManager_->isGenerating() && lastUpdateWasGenerating_) {
-            // Generation just completed
+        // Patch in finished tiles of a long generation as they arrive
+        TerrainTile tile;
+        while (resolutionManager_->popTile(tile)) {
+            renderer_->updateTile(tile, uiManager_->isMonochromeMode());
+        }
+
+        // An aborted generation was collected: undo the tiles it streamed
+        // into the mesh
+        if (resolutionManager_->hasAbortedResult()) {
+            resolutionManager_->clearAbortedResult();
+            bool monochrome = uiManager_->isMonochromeMode();
+            if (resolutionManager_->isPreviewResult()) {
+                renderer_->updateTexture(resolutionManager_->getHeightMap(), monochrome);
+            } else {
+                renderer_->updateTexture(compositeHeightMap_, monochrome);
+            }
+        }
+
+        // Update renderer if a generation completed (or was served from cache)
+        if (resolutionManager_->hasNewResult() && resolutionManager_->isPreviewResult()) {
+            // Previews and progressive levels below the target come in any
+            // size: composite them at their own size, standing in for the
+            // active layer, and leave the layers alone until the
+            // full-resolution result arrives
+            resolutionManager_->clearNewResult();
+            const HeightMap& previewMap = resolutionManager_->getHeightMap();
+            TerrainLayer* targetLayer = layerStack_->getActiveTerrainLayer();
+
+            if (targetLayer && layerStack_->getLayerCount() > 1) {
+                // Other layers sample cached copies at the preview size, so
+                // this stays cheap while a slider is dragged
+                HeightMap standIn = previewMap;
+                std::swap(targetLayer->getHeightMap(), standIn);
+                HeightMap previewComposite(previewMap.getWidth(), previewMap.getHeight());
+                layerStack_->composite(previewComposite, threadPool_.get());
+                std::swap(targetLayer->getHeightMap(), standIn);
+
+                renderer_->updateTexture(previewComposite, uiManager_->isMonochromeMode());
+            } else {
+                renderer_->updateTexture(previewMap, uiManager_->isMonochromeMode());
+            }
+            renderer_->setSeaLevel(uiManager_->getParams().seaLevel);
+        } else if (resolutionManager_->hasNewResult()) {
+            resolutionManager_->clearNewResult();
             const HeightMap& generatedMap = resolutionManager_->getHeightMap();
 
-            // Check if layer stack needs resizing
-            bool resizedStack = false;
+            // Layers keep their own resolution; only the composite (and the
+            // size new layers get) follows the generation
             if (layerStack_->getWidth() != generatedMap.getWidth() ||
                 layerStack_->getHeight() != generatedMap.getHeight()) {
-                // Recreate layer stack with new dimensions
-                layerStack_ = std::make_unique<LayerStack>(generatedMap.getWidth(), generatedMap.getHeight());
-                uiManager_->setLayerStack(layerStack_.get());
-        uiManager_->setLayerUndoStack(layerUndoStack_.get());
+                layerStack_->setResolution(generatedMap.getWidth(), generatedMap.getHeight());
                 compositeHeightMap_ = HeightMap(generatedMap.getWidth(), generatedMap.getHeight());
-                resizedStack = true;
             }
 
-            // Put generated terrain on active layer (or base layer if we just resized)
-            TerrainLayer* targetLayer;
-            if (resizedStack) {
-                // After resize, always use base layer (only layer that exists)
-                targetLayer = layerStack_->getLayerAsTerrainLayer(0);
-                std::cout << "Generated terrain on base layer (stack resized)" << std::endl;
-            } else {
-                // Use currently active layer
-                targetLayer = layerStack_->getActiveTerrainLayer();
-                if (targetLayer) {
-                    std::cout << "Generated terrain on layer: " << targetLayer->getName() << std::endl;
-                }
+            // Put generated terrain on the active layer
+            TerrainLayer* targetLayer = layerStack_->getActiveTerrainLayer();
+            if (targetLayer) {
+                std::cout << "Generated terrain on layer: " << targetLayer->getName() << std::endl;
             }
 
             if (targetLayer) {
-                targetLayer->getHeightMap() = generatedMap;
+                // Edits recorded on this layer hold pixel coordinates at its old size
+                if (targetLayer->getWidth() != generatedMap.getWidth() ||
+                    targetLayer->getHeight() != generatedMap.getHeight()) {
+                    undoStack_->clear();
+                }
+                targetLayer->setHeightMap(generatedMap, threadPool_.get());
             }
 
             // Composite all layers
-            layerStack_->composite(compositeHeightMap_);
+            layerStack_->composite(compositeHeightMap_, threadPool_.get());
 
             // Update renderer with composite result
             bool monochrome = uiManager_->isMonochromeMode();
@@ -1024,11 +1096,9 @@ private:
                       << std::endl;
         }
 
-        lastUpdateWasGenerating_ = resolutionManager_->isGenerating();
-
         // Handle layer compositing requests from UI
         if (uiManager_->isCompositeRequested()) {
-            layerStack_->composite(compositeHeightMap_);
+            layerStack_->composite(compositeHeightMap_, threadPool_.get());
 
             // Update renderer with composite result
             bool monochrome = uiManager_->isMonochromeMode();
@@ -1053,9 +1123,9 @@ private:
 
             // Only generate in real-time if enabled
             if (uiManager_->isRealTimePreviewEnabled()) {
-                // Generate at STANDARD (512x512) for meaningful real-time preview
-                // Takes ~150-300ms which provides good feedback while dragging sliders
-                resolutionManager_->generateAt(Resolution::STANDARD, params);
+                // Largest size that fits the preview budget (measured);
+                // auto-upgrade brings the full-quality terrain once idle
+                resolutionManager_->generatePreview(params);
             }
 
             // Update sea level immediately (always, even if not generating)
@@ -1064,6 +1134,16 @@ private:
             uiManager_->clearParamsChanged();
         }
 
+        // Speculation only pays off for real-time previews
+        bool speculate = uiManager_->isSpeculationEnabled() && uiManager_->isRealTimePreviewEnabled();
+        if (speculate != resolutionManager_->isSpeculative() || uiManager_->hasSpeculationChanged()) {
+            resolutionManager_->setSpeculative(speculate);
+            if (speculate) {
+                resolutionManager_->speculate(uiManager_->getSpeculativeParams());
+            }
+            uiManager_->clearSpeculationChanged();
+        }
+
         // Render ImGui
         ImGui::Render();
 
@@ -1119,6 +1199,47 @@ private:
         SDL_GL_SwapWindow(window_);
     }
 
+    // Recomposite a rectangle after an edit to the active layer and patch
+    // the mesh over it, instead of recompositing and rebuilding everything
+    void recompositeRegion(int x, int y, int width, int height, bool monochrome) {
+        if (layerStack_->compositeRegion(compositeHeightMap_, x, y, width, height, threadPool_.get())) {
+            // Caches were rebuilt with a full composite; all of it may differ
+            renderer_->updateTexture(compositeHeightMap_, monochrome);
+            return;
+        }
+
+        TerrainTile tile;
+        tile.x = std::max(0, x);
+        tile.y = std::max(0, y);
+        tile.width = std::min(compositeHeightMap_.getWidth(), x + width) - tile.x;
+        tile.height = std::min(compositeHeightMap_.getHeight(), y + height) - tile.y;
+        if (tile.width <= 0 || tile.height <= 0) return;
+
+        tile.mapWidth = compositeHeightMap_.getWidth();
+        tile.mapHeight = compositeHeightMap_.getHeight();
+        tile.heights.resize(static_cast<size_t>(tile.width) * tile.height);
+        for (int row = 0; row < tile.height; ++row) {
+            const float* src = compositeHeightMap_.getData() +
+                               static_cast<size_t>(tile.y + row) * tile.mapWidth + tile.x;
+            std::copy(src, src + tile.width, tile.heights.begin() + static_cast<size_t>(row) * tile.width);
+        }
+        renderer_->updateTile(tile, monochrome);
+    }
+
+    // Undo/redo rewrite layer data the stack doesn't see, so recomposite
+    // everything; this also drops compositeRegion's cached split
+    void refreshAfterHistoryChange() {
+        layerStack_->composite(compositeHeightMap_, threadPool_.get());
+        renderer_->updateTexture(compositeHeightMap_, uiManager_->isMonochromeMode());
+    }
+
+    // Pixel of a map mapSize wide under composite pixel compositeCoord
+    // (pixel centres aligned, as in resampling)
+    static int toMapPixel(int compositeCoord, int compositeSize, int mapSize) {
+        float position = (compositeCoord + 0.5f) * mapSize / compositeSize;
+        return std::clamp(static_cast<int>(position), 0, mapSize - 1);
+    }
+
     void importHeightmap() {
         // Open file dialog to select heightmap PNG
         std::string filename;
@@ -1303,6 +1424,15 @@ private:
         const HeightMap& heightMap = resolutionManager_->getHeightMap();
         bool success = ImageExporter::exportSplatmap(heightMap, filename);
 
+        // Erosion masks from the same generation run, if erosion was applied
+        const ErosionMaps* erosionMaps = resolutionManager_->getErosionMaps();
+        if (success && erosionMaps &&
+            erosionMaps->getWidth() == heightMap.getWidth() &&
+            erosionMaps->getHeight() == heightMap.getHeight()) {
+            std::string masksFilename = filename.substr(0, filename.size() - 4) + "_erosion.png";
+            success = ImageExporter::exportErosionMaps(*erosionMaps, masksFilename);
+        }
+
         if (success) {
             std::cout << "Splatmap exported to: " << filename << std::endl;
             uiManager_->showExportSuccess("Splatmap exported successfully!");
@@ -1326,7 +1456,7 @@ private:
         ofn.hwndOwner = NULL;
         ofn.lpstrFile = szFile;
         ofn.nMaxFile = sizeof(szFile);
-        ofn.lpstrFilter = "Ymirge Projects *.ymlayers All Files *.* ";
+        ofn.lpstrFilter = "Ymirge Projects\0*.ymlayers\0All Files\0*.*\0";
         ofn.nFilterIndex = 1;
         ofn.lpstrFileTitle = NULL;
         ofn.nMaxFileTitle = 0;
@@ -1349,7 +1479,7 @@ private:
         // Load project
         if (LayerSerializer::load(*layerStack_, filename)) {
             // Recomposite layers
-            layerStack_->composite(compositeHeightMap_);
+            layerStack_->composite(compositeHeightMap_, threadPool_.get());
 
             // Update renderer
             bool monochrome = uiManager_->isMonochromeMode();
@@ -1381,7 +1511,7 @@ private:
         ofn.hwndOwner = NULL;
         ofn.lpstrFile = szFile;
         ofn.nMaxFile = sizeof(szFile);
-        ofn.lpstrFilter = "Ymirge Projects *.ymlayers All Files *.* ";
+        ofn.lpstrFilter = "Ymirge Projects\0*.ymlayers\0All Files\0*.*\0";
         ofn.nFilterIndex = 1;
         ofn.lpstrFileTitle = NULL;
         ofn.nMaxFileTitle = 0;
@@ -1434,7 +1564,6 @@ private:
     std::unique_ptr<LayerStack> layerStack_;
     HeightMap compositeHeightMap_;  // Result of compositing all layers
 
-    bool lastUpdateWasGenerating_;
     float pendingScrollDelta_ = 0.0f;
 };
 
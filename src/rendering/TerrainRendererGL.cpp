@@ -68,6 +68,77 @@ void TerrainRendererGL::updateTexture(const HeightMap& heightMap, bool monochrom
     createSeaPlane();
 }
 
+void TerrainRendererGL::updateTile(const TerrainTile& tile, bool monochrome) {
+    if (!meshLoaded_ || tile.mapWidth <= 0 || tile.mapHeight <= 0) return;
+
+    // Vertices sample the map the same way createMesh does
+    float scaleX = static_cast<float>(tile.mapWidth) / meshWidth_;
+    float scaleZ = static_cast<float>(tile.mapHeight) / meshHeight_;
+
+    int firstRow = meshHeight_;
+    int lastRow = -1;
+    for (int z = 0; z < meshHeight_; z++) {
+        int srcY = std::clamp(static_cast<int>(z * scaleZ), 0, tile.mapHeight - 1);
+        if (srcY < tile.y || srcY >= tile.y + tile.height) continue;
+
+        for (int x = 0; x < meshWidth_; x++) {
+            int srcX = std::clamp(static_cast<int>(x * scaleX), 0, tile.mapWidth - 1);
+            if (srcX < tile.x || srcX >= tile.x + tile.width) continue;
+
+            float height = tile.heights[static_cast<size_t>(srcY - tile.y) * tile.width + (srcX - tile.x)];
+            meshVertices_[z * meshWidth_ + x].y = height * terrainHeight_;
+        }
+
+        firstRow = std::min(firstRow, z);
+        lastRow = std::max(lastRow, z);
+    }
+    if (lastRow < 0) return;
+
+    // Normals one row beyond the patch see its faces too
+    int z0 = std::max(0, firstRow - 1);
+    int z1 = std::min(meshHeight_ - 1, lastRow + 1);
+    std::vector<glm::vec3> normals(static_cast<size_t>(z1 - z0 + 1) * meshWidth_, glm::vec3(0.0f));
+
+    auto addFace = [&](int i0, int i1, int i2) {
+        glm::vec3 v0 = meshVertices_[i0];
+        glm::vec3 normal = glm::normalize(glm::cross(meshVertices_[i1] - v0, meshVertices_[i2] - v0));
+        for (int i : {i0, i1, i2}) {
+            int row = i / meshWidth_;
+            if (row >= z0 && row <= z1) {
+                normals[i - z0 * meshWidth_] += normal;
+            }
+        }
+    };
+
+    // Same triangles as createMesh, for every quad touching rows z0..z1
+    for (int z = std::max(0, z0 - 1); z <= std::min(meshHeight_ - 2, z1); z++) {
+        for (int x = 0; x < meshWidth_ - 1; x++) {
+            int topLeft = z * meshWidth_ + x;
+            int topRight = topLeft + 1;
+            int bottomLeft = (z + 1) * meshWidth_ + x;
+            int bottomRight = bottomLeft + 1;
+            addFace(topLeft, bottomLeft, topRight);
+            addFace(topRight, bottomLeft, bottomRight);
+        }
+    }
+
+    std::vector<TerrainVertex> vertices(normals.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        TerrainVertex& v = vertices[i];
+        v.position = meshVertices_[z0 * meshWidth_ + i];
+        v.normal = glm::normalize(normals[i]);
+
+        float height = v.position.y / terrainHeight_;
+        v.color = monochrome ? glm::vec4(height, height, height, 1.0f) : getTerrainColor(height);
+    }
+
+    // Rows z0..z1 are contiguous in the vertex buffer
+    glBindBuffer(GL_ARRAY_BUFFER, terrainVBO_);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(z0) * meshWidth_ * sizeof(TerrainVertex),
+                    vertices.size() * sizeof(TerrainVertex), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void TerrainRendererGL::updateCamera(int mouseX, int mouseY, bool leftButton, bool rightButton, float scrollDelta) {
     camera_.update(mouseX, mouseY, leftButton, rightButton, scrollDelta);
 }
@@ -3,6 +3,7 @@
 #ifdef YMIRGE_SDL_UI_ENABLED
 
 #include "HeightMap.h"
+#include "TileQueue.h"
 #include "Camera3D.h"
 #include "Shader.h"
 #include <glad/glad.h>
@@ -16,6 +17,11 @@ public:
     ~TerrainRendererGL();
 
     void updateTexture(const HeightMap& heightMap, bool monochrome);
+
+    // Patch one finished tile of a map being generated into the current mesh:
+    // only the vertices it covers (and the normals around them) are rebuilt
+    // and re-uploaded. The map may differ in size from the mesh's source.
+    void updateTile(const TerrainTile& tile, bool monochrome);
     void updateCamera(int mouseX, int mouseY, bool leftButton, bool rightButton, float scrollDelta);
     void resetCamera();
     void render(int viewportX, int viewportY, int viewportWidth, int viewportHeight);
@@ -1,5 +1,6 @@
 #include "BrushManager.h"
 #include <iostream>
+#include <utility>
 
 BrushManager::BrushManager(UndoStack* undoStack)
     : undoStack_(undoStack)
@@ -12,6 +13,7 @@ BrushManager::BrushManager(UndoStack* undoStack)
     lowerBrush_ = std::make_unique<LowerBrush>();
     smoothBrush_ = std::make_unique<SmoothBrush>();
     flattenBrush_ = std::make_unique<FlattenBrush>();
+    erosionBrush_ = std::make_unique<ErosionBrush>();
 
     // Set default tool (View mode)
     activeBrush_ = nullptr;
@@ -43,6 +45,14 @@ void BrushManager::setActiveBrush(BrushType type) {
             activeBrush_ = flattenBrush_.get();
             std::cout << "Brush: Switched to " << activeBrush_->getName() << std::endl;
             break;
+        case BrushType::ERODE:
+            activeBrush_ = erosionBrush_.get();
+            std::cout << "Brush: Switched to " << activeBrush_->getName() << std::endl;
+            break;
+        case BrushType::STAMP:
+            // Stamps are placed by StampTool, not through strokes
+            activeBrush_ = nullptr;
+            break;
     }
 }
 
@@ -51,6 +61,7 @@ void BrushManager::setBrushSize(int radius) {
     lowerBrush_->setRadius(radius);
     smoothBrush_->setRadius(radius);
     flattenBrush_->setRadius(radius);
+    erosionBrush_->setRadius(radius);
 }
 
 void BrushManager::setBrushStrength(float strength) {
@@ -58,9 +69,14 @@ void BrushManager::setBrushStrength(float strength) {
     lowerBrush_->setStrength(strength);
     smoothBrush_->setStrength(strength);
     flattenBrush_->setStrength(strength);
+    erosionBrush_->setStrength(strength);
+}
+
+void BrushManager::setErosionMode(ErosionBrush::Mode mode) {
+    erosionBrush_->setMode(mode);
 }
 
-void BrushManager::beginStroke(HeightMap& map, int x, int y) {
+void BrushManager::beginStroke(HeightMap& map, int x, int y, std::function<void()> onChange) {
     if (strokeActive_) {
         endStroke();  // End previous stroke if still active
     }
@@ -68,7 +84,8 @@ void BrushManager::beginStroke(HeightMap& map, int x, int y) {
     // Create new undo command
     currentCommand_ = std::make_unique<HeightMapEditCommand>(
         &map,
-        std::string("Brush: ") + activeBrush_->getName()
+        std::string("Brush: ") + activeBrush_->getName(),
+        std::move(onChange)
     );
 
     // For flatten brush, sample target height from click position
@@ -5,6 +5,7 @@
 #include "LowerBrush.h"
 #include "SmoothBrush.h"
 #include "FlattenBrush.h"
+#include "ErosionBrush.h"
 #include "UndoStack.h"
 #include "HeightMapEditCommand.h"
 
@@ -12,12 +13,13 @@
 #include "raylib.h"
 #endif
 
+#include <functional>
 #include <memory>
 
 /**
  * Tool type enumeration
  * VIEW: Camera controls (default)
- * RAISE/LOWER/SMOOTH/FLATTEN: Terrain editing brushes
+ * RAISE/LOWER/SMOOTH/FLATTEN/ERODE: Terrain editing brushes
  * STAMP: Stamp tool for placing pre-made features
  */
 enum class BrushType {
@@ -26,7 +28,8 @@ enum class BrushType {
     LOWER,     // Lower terrain (L)
     SMOOTH,    // Smooth terrain (S)
     FLATTEN,   // Flatten terrain (F)
-    STAMP      // Stamp tool (T)
+    STAMP,     // Stamp tool (T)
+    ERODE      // Local erosion (E)
 };
 
 /**
@@ -61,12 +64,18 @@ public:
      * Set brush size (radius in pixels)
      */
     void setBrushSize(int radius);
+    int getBrushSize() const { return activeBrush_->getRadius(); }
 
     /**
      * Set brush strength (0.0 - 1.0)
      */
     void setBrushStrength(float strength);
 
+    /**
+     * Set erosion brush mode (thermal, hydraulic, or both)
+     */
+    void setErosionMode(ErosionBrush::Mode mode);
+
     /**
      * Begin a new brush stroke
      *
@@ -76,8 +85,9 @@ public:
      * @param map Heightmap to edit
      * @param x Heightmap X coordinate
      * @param y Heightmap Y coordinate
+     * @param onChange Optional, called when undo/redo rewrites the map
      */
-    void beginStroke(HeightMap& map, int x, int y);
+    void beginStroke(HeightMap& map, int x, int y, std::function<void()> onChange = nullptr);
 
     /**
      * Apply brush during stroke
@@ -150,6 +160,7 @@ private:
     std::unique_ptr<LowerBrush> lowerBrush_;
     std::unique_ptr<SmoothBrush> smoothBrush_;
     std::unique_ptr<FlattenBrush> flattenBrush_;
+    std::unique_ptr<ErosionBrush> erosionBrush_;
 
     BrushTool* activeBrush_;
     BrushType activeType_;
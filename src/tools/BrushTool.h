@@ -18,7 +18,7 @@ public:
     virtual const char* getName() const = 0;
 
     void setRadius(int radius) {
-        radius_ = std::max(1, std::min(radius, 100));
+        radius_ = std::max(1, std::min(radius, 128));
     }
 
     void setStrength(float strength) {
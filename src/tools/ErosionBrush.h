@@ -0,0 +1,104 @@
+#pragma once
+
+#include "BrushTool.h"
+#include "ThermalErosion.h"
+#include "HydraulicErosion.h"
+#include <memory>
+#include <cstring>
+
+// Erodes terrain locally: runs thermal and/or hydraulic erosion on a window
+// covering the brush footprint plus a margin, then blends the eroded result
+// back by falloff. Only pixels inside the radius are written, so undo capture
+// with the brush radius covers every change.
+class ErosionBrush : public BrushTool {
+public:
+    enum class Mode {
+        THERMAL,
+        HYDRAULIC,
+        BOTH
+    };
+
+    void setMode(Mode mode) { mode_ = mode; }
+    Mode getMode() const { return mode_; }
+
+    void apply(HeightMap& map, int centerX, int centerY, float deltaTime) override {
+        int width = map.getWidth();
+        int height = map.getHeight();
+
+        // Margin lets material slide and droplets flow out of the footprint
+        // so the edge of the brush doesn't act as a wall
+        int extent = radius_ + MARGIN;
+        int x0 = std::max(0, centerX - extent);
+        int y0 = std::max(0, centerY - extent);
+        int x1 = std::min(width - 1, centerX + extent);
+        int y1 = std::min(height - 1, centerY + extent);
+
+        int regionWidth = x1 - x0 + 1;
+        int regionHeight = y1 - y0 + 1;
+        if (regionWidth < 3 || regionHeight < 3) {
+            return;
+        }
+
+        // Reuse the scratch window between dabs of the same size
+        if (!window_ || window_->getWidth() != regionWidth || window_->getHeight() != regionHeight) {
+            window_ = std::make_unique<HeightMap>(regionWidth, regionHeight);
+        }
+
+        const float* src = map.getData();
+        float* dst = window_->getData();
+        for (int y = 0; y < regionHeight; ++y) {
+            std::memcpy(dst + static_cast<size_t>(y) * regionWidth,
+                        src + static_cast<size_t>(y0 + y) * width + x0,
+                        regionWidth * sizeof(float));
+        }
+
+        if (mode_ == Mode::THERMAL || mode_ == Mode::BOTH) {
+            ThermalErosion::Params thermalParams;
+            thermalParams.talusAngle = TALUS_ANGLE;
+            thermalParams.thermalRate = 0.5f;
+            thermalParams.iterations = THERMAL_ITERATIONS;
+            ThermalErosion::apply(*window_, thermalParams, nullptr, nullptr, &thermalScratch_);
+        }
+
+        if (mode_ == Mode::HYDRAULIC || mode_ == Mode::BOTH) {
+            // Droplet count follows footprint area so density is size-independent
+            HydraulicErosion::Params hydraulicParams;
+            hydraulicParams.num_droplets = std::max(16, (regionWidth * regionHeight) / DROPLET_AREA);
+            hydraulicParams.max_lifetime = 30;
+            hydraulicParams.erosion_radius = 2;
+            HydraulicErosion::apply(*window_, hydraulicParams, nullptr);
+        }
+
+        // Blend eroded window back inside the brush footprint
+        float blend = std::min(1.0f, strength_ * deltaTime * 10.0f);
+        const float* eroded = window_->getData();
+        float* out = map.getData();
+
+        for (int y = std::max(y0, centerY - radius_); y <= std::min(y1, centerY + radius_); ++y) {
+            for (int x = std::max(x0, centerX - radius_); x <= std::min(x1, centerX + radius_); ++x) {
+                float weight = calculateFalloff(x - centerX, y - centerY);
+                if (weight <= 0.0f) {
+                    continue;
+                }
+
+                float& pixel = out[static_cast<size_t>(y) * width + x];
+                float target = eroded[static_cast<size_t>(y - y0) * regionWidth + (x - x0)];
+                pixel += (target - pixel) * weight * blend;
+            }
+        }
+    }
+
+    const char* getName() const override {
+        return "Erode";
+    }
+
+private:
+    static constexpr int MARGIN = 8;
+    static constexpr int THERMAL_ITERATIONS = 4;
+    static constexpr int DROPLET_AREA = 64;       // One droplet per 64 pixels
+    static constexpr float TALUS_ANGLE = 0.006f;  // Per-pixel slope in normalized heights
+
+    Mode mode_ = Mode::BOTH;
+    std::unique_ptr<HeightMap> window_;
+    ThermalErosion::Scratch thermalScratch_;  // Footprint-sized, reused like window_
+};
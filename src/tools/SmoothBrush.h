@@ -1,6 +1,9 @@
 #pragma once
 
 #include "BrushTool.h"
+#include "Filters.h"
+#include <memory>
+#include <cstring>
 
 // Smooths terrain using 3x3 kernel averaging
 class SmoothBrush : public BrushTool {
@@ -9,12 +12,37 @@ public:
         int width = map.getWidth();
         int height = map.getHeight();
 
-        for (int y = centerY - radius_; y <= centerY + radius_; ++y) {
-            for (int x = centerX - radius_; x <= centerX + radius_; ++x) {
-                if (x < 0 || x >= width || y < 0 || y >= height) {
-                    continue;
-                }
+        // Footprint plus a 1 px border so the 3x3 average sees real neighbors
+        int x0 = std::max(0, centerX - radius_ - 1);
+        int y0 = std::max(0, centerY - radius_ - 1);
+        int x1 = std::min(width - 1, centerX + radius_ + 1);
+        int y1 = std::min(height - 1, centerY + radius_ + 1);
+
+        int regionWidth = x1 - x0 + 1;
+        int regionHeight = y1 - y0 + 1;
+        if (regionWidth < 1 || regionHeight < 1) {
+            return;
+        }
+
+        // Reuse scratch windows between dabs of the same size
+        if (!window_ || window_->getWidth() != regionWidth || window_->getHeight() != regionHeight) {
+            window_ = std::make_unique<HeightMap>(regionWidth, regionHeight);
+            averaged_ = std::make_unique<HeightMap>(regionWidth, regionHeight);
+        }
+
+        float* out = map.getData();
+        float* src = window_->getData();
+        for (int y = 0; y < regionHeight; ++y) {
+            std::memcpy(src + static_cast<size_t>(y) * regionWidth,
+                        out + static_cast<size_t>(y0 + y) * width + x0,
+                        regionWidth * sizeof(float));
+        }
 
+        Filters::boxBlur(*window_, *averaged_, 1, nullptr);
+        const float* average = averaged_->getData();
+
+        for (int y = std::max(0, centerY - radius_); y <= std::min(height - 1, centerY + radius_); ++y) {
+            for (int x = std::max(0, centerX - radius_); x <= std::min(width - 1, centerX + radius_); ++x) {
                 int dx = x - centerX;
                 int dy = y - centerY;
                 float weight = calculateFalloff(dx, dy);
@@ -23,27 +51,11 @@ public:
                     continue;
                 }
 
-                float sum = 0.0f;
-                int count = 0;
-
-                for (int ny = -1; ny <= 1; ++ny) {
-                    for (int nx = -1; nx <= 1; ++nx) {
-                        int sx = x + nx;
-                        int sy = y + ny;
-
-                        if (sx >= 0 && sx < width && sy >= 0 && sy < height) {
-                            sum += map.at(sx, sy);
-                            count++;
-                        }
-                    }
-                }
-
-                float average = (count > 0) ? (sum / count) : map.at(x, y);
-
-                float& pixel = map.at(x, y);
+                float& pixel = out[static_cast<size_t>(y) * width + x];
                 float blendFactor = strength_ * weight * deltaTime * 5.0f;
                 blendFactor = std::min(1.0f, blendFactor);
-                pixel = pixel * (1.0f - blendFactor) + average * blendFactor;
+                pixel = pixel * (1.0f - blendFactor) +
+                        average[static_cast<size_t>(y - y0) * regionWidth + (x - x0)] * blendFactor;
             }
         }
     }
@@ -51,4 +63,8 @@ public:
     const char* getName() const override {
         return "Smooth";
     }
+
+private:
+    std::unique_ptr<HeightMap> window_;
+    std::unique_ptr<HeightMap> averaged_;
 };
@@ -4,7 +4,7 @@ PresetManager::PresetManager() {
     definePresets();
 }
 
-bool PresetManager::applyPreset(const std::string& name, TerrainParams& params) {
+bool PresetManager::applyPreset(const std::string& name, TerrainParams& params) const {
     auto it = presets_.find(name);
     if (it != presets_.end()) {
         params = it->second;
@@ -22,7 +22,7 @@ public:
      * @param params Parameters to update
      * @return true if preset was found and applied
      */
-    bool applyPreset(const std::string& name, TerrainParams& params);
+    bool applyPreset(const std::string& name, TerrainParams& params) const;
 
     /**
      * Get list of all preset names
@@ -4,6 +4,19 @@
 #include "../layers/LayerGroup.h"
 #include <SDL2/SDL.h>
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+// Value as a slider edit stores it: rounded to ImGui's default "%.3f"
+float roundToSliderFormat(float value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+    return std::strtof(buffer, nullptr);
+}
+
+} // namespace
 
 UIManagerImGui::UIManagerImGui()
     : paramsChanged_(false)
@@ -18,11 +31,15 @@ UIManagerImGui::UIManagerImGui()
     , targetResolution_(Resolution::STANDARD)
     , resolutionChanged_(false)
     , enableRealTimePreview_(true)
+    , enableSpeculation_(false)
+    , speculationChanged_(false)
+    , hoveredPreset_(-1)
     , exportFormat_(ExportFormat::PNG16)
     , activeTool_(BrushType::VIEW)
     , brushSize_(10)
     , brushStrength_(0.5f)
     , brushChanged_(false)
+    , erosionMode_(ErosionBrush::Mode::BOTH)
     , stampScale_(1.0f)
     , stampRotation_(0.0f)
     , stampOpacity_(1.0f)
@@ -162,11 +179,11 @@ void UIManagerImGui::renderToolPanel() {
 
     ImGui::Begin("Tools", nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize);
 
-    const char* tools[] = {"View (V)", "Raise (R)", "Lower (L)", "Smooth (S)", "Flatten (F)", "Stamp (T)"};
+    const char* tools[] = {"View (V)", "Raise (R)", "Lower (L)", "Smooth (S)", "Flatten (F)", "Erode (E)", "Stamp (T)"};
     BrushType toolTypes[] = {BrushType::VIEW, BrushType::RAISE, BrushType::LOWER,
-                             BrushType::SMOOTH, BrushType::FLATTEN, BrushType::STAMP};
+                             BrushType::SMOOTH, BrushType::FLATTEN, BrushType::ERODE, BrushType::STAMP};
 
-    for (int i = 0; i < 6; i++) {
+    for (int i = 0; i < 7; i++) {
         if (ImGui::Selectable(tools[i], activeTool_ == toolTypes[i])) {
             activeTool_ = toolTypes[i];
             brushChanged_ = true;
@@ -223,13 +240,22 @@ void UIManagerImGui::renderToolPanel() {
         ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "Adjust settings above");
     } else if (activeTool_ != BrushType::VIEW) {
         ImGui::Text("Brush Settings");
-        if (ImGui::SliderInt("Size", &brushSize_, 1, 50)) {
+        if (ImGui::SliderInt("Size", &brushSize_, 1, 128)) {
             brushChanged_ = true;
         }
         if (ImGui::SliderFloat("Strength", &brushStrength_, 0.0f, 1.0f)) {
             brushChanged_ = true;
         }
 
+        if (activeTool_ == BrushType::ERODE) {
+            const char* erosionModes[] = {"Thermal", "Hydraulic", "Both"};
+            int currentMode = static_cast<int>(erosionMode_);
+            if (ImGui::Combo("Erosion", &currentMode, erosionModes, 3)) {
+                erosionMode_ = static_cast<ErosionBrush::Mode>(currentMode);
+                brushChanged_ = true;
+            }
+        }
+
         ImGui::Separator();
         ImGui::TextColored(ImVec4(0.6f, 0.6f, 0.6f, 1.0f), "Shortcuts:");
         ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "Ctrl+Z: Undo");
@@ -267,13 +293,22 @@ void UIManagerImGui::renderControlPanel() {
     // Presets
     if (ImGui::CollapsingHeader("Presets", ImGuiTreeNodeFlags_DefaultOpen)) {
         auto names = presetManager_.getPresetNames();
+        int hovered = -1;
         for (size_t i = 0; i < names.size(); i++) {
             if (ImGui::Selectable(names[i].c_str(), selectedPreset_ == (int)i, 0, ImVec2(360, 0))) {
                 presetManager_.applyPreset(names[i], params_);
                 selectedPreset_ = (int)i;
                 paramsChanged_ = true;
+                speculationChanged_ = true;
+            }
+            if (ImGui::IsItemHovered()) {
+                hovered = (int)i;
             }
         }
+        if (hovered != hoveredPreset_) {
+            hoveredPreset_ = hovered;
+            speculationChanged_ = true;
+        }
     }
 
     // Real-Time Preview
@@ -284,6 +319,13 @@ void UIManagerImGui::renderControlPanel() {
                              "Disable for faster slider adjustment without regenerating.\n"
                              "When disabled, use the Generate button to update terrain.");
         }
+        if (ImGui::Checkbox("Speculative Pre-generation", &enableSpeculation_)) {
+            speculationChanged_ = true;
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Use idle cores to pre-generate previews of nearby slider\n"
+                             "values and presets, so moving to them is instant.");
+        }
     }
 
     // Resolution
@@ -326,31 +368,31 @@ void UIManagerImGui::renderControlPanel() {
 
     // Parameters
     if (ImGui::CollapsingHeader("Parameters", ImGuiTreeNodeFlags_DefaultOpen)) {
-        if (ImGui::SliderFloat("Scale", &params_.scale, 20.0f, 300.0f)) {
+        if (paramSlider("Scale", &TerrainParams::scale, 20.0f, 300.0f, 1.0f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
-        if (ImGui::SliderFloat("Peaks", &params_.peaks, 0.0f, 1.0f)) {
+        if (paramSlider("Peaks", &TerrainParams::peaks, 0.0f, 1.0f, 0.01f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
-        if (ImGui::SliderFloat("Island", &params_.island, 0.0f, 1.0f)) {
+        if (paramSlider("Island", &TerrainParams::island, 0.0f, 1.0f, 0.01f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
-        if (ImGui::SliderFloat("Island Shape", &params_.islandShape, 1.0f, 4.0f)) {
+        if (paramSlider("Island Shape", &TerrainParams::islandShape, 1.0f, 4.0f, 0.01f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
-        if (ImGui::SliderFloat("River Intensity", &params_.riverIntensity, 0.0f, 1.0f)) {
+        if (paramSlider("River Intensity", &TerrainParams::riverIntensity, 0.0f, 1.0f, 0.01f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
-        if (ImGui::SliderFloat("Erosion", &params_.erosion, 0.0f, 1.0f)) {
+        if (paramSlider("Erosion", &TerrainParams::erosion, 0.0f, 1.0f, 0.01f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
-        if (ImGui::SliderFloat("Terrain Smoothness", &params_.terrainSmoothness, 0.0f, 1.0f)) {
+        if (paramSlider("Terrain Smoothness", &TerrainParams::terrainSmoothness, 0.0f, 1.0f, 0.01f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
@@ -358,7 +400,7 @@ void UIManagerImGui::renderControlPanel() {
             ImGui::SetTooltip("Reduces slopes in low/mid elevations while preserving peaks.\nCreates gentle, buildable terrain surrounded by dramatic mountains.");
         }
         if (params_.terrainSmoothness > 0.01f) {
-            if (ImGui::SliderFloat("Softening Threshold", &params_.softeningThreshold, 0.3f, 0.9f)) {
+            if (paramSlider("Softening Threshold", &TerrainParams::softeningThreshold, 0.3f, 0.9f, 0.01f)) {
                 paramsChanged_ = true;
                 selectedPreset_ = -1;
             }
@@ -366,11 +408,11 @@ void UIManagerImGui::renderControlPanel() {
                 ImGui::SetTooltip("Elevation below which terrain gets smoothed.\n0.5 = bottom 50%%, 0.7 = bottom 70%%\nHigher values preserve more peaks.");
             }
         }
-        if (ImGui::SliderFloat("Edge Padding", &params_.edgePadding, 0.0f, 0.5f)) {
+        if (paramSlider("Edge Padding", &TerrainParams::edgePadding, 0.0f, 0.5f, 0.01f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
-        if (ImGui::SliderFloat("Sea Level", &params_.seaLevel, 0.0f, 0.5f)) {
+        if (paramSlider("Sea Level", &TerrainParams::seaLevel, 0.0f, 0.5f, 0.01f)) {
             paramsChanged_ = true;
             selectedPreset_ = -1;
         }
@@ -411,6 +453,60 @@ void UIManagerImGui::renderControlPanel() {
     }
 }
 
+bool UIManagerImGui::paramSlider(const char* label, float TerrainParams::* field, float min, float max, float step) {
+    float before = params_.*field;
+    bool changed = ImGui::SliderFloat(label, &(params_.*field), min, max);
+
+    if ((ImGui::IsItemHovered() || ImGui::IsItemActive()) && touchedSlider_.field != field) {
+        touchedSlider_ = {field, min, max, step, 1};
+        speculationChanged_ = true;
+    }
+    if (changed) {
+        touchedSlider_.direction = params_.*field < before ? -1 : 1;
+        speculationChanged_ = true;
+    }
+    return changed;
+}
+
+std::vector<TerrainParams> UIManagerImGui::getSpeculativeParams() const {
+    std::vector<TerrainParams> candidates;
+    auto names = presetManager_.getPresetNames();
+
+    auto addPreset = [&](int index) {
+        if (index < 0 || index >= (int)names.size() || index == selectedPreset_) return;
+        TerrainParams preset;
+        if (presetManager_.applyPreset(names[index], preset)) {
+            candidates.push_back(preset);
+        }
+    };
+
+    addPreset(hoveredPreset_);
+
+    if (touchedSlider_.field) {
+        float current = params_.*touchedSlider_.field;
+        float step = touchedSlider_.step;
+
+        for (int i = 1; i <= SPECULATIVE_STEPS; i++) {
+            for (int side : {touchedSlider_.direction, -touchedSlider_.direction}) {
+                float value = std::clamp(current + side * i * step, touchedSlider_.min, touchedSlider_.max);
+                value = roundToSliderFormat(value);
+                if (value == current) continue;
+
+                TerrainParams neighbour = params_;
+                neighbour.*touchedSlider_.field = value;
+                candidates.push_back(neighbour);
+            }
+        }
+    }
+
+    if (selectedPreset_ >= 0) {
+        addPreset(selectedPreset_ + 1);
+        addPreset(selectedPreset_ - 1);
+    }
+
+    return candidates;
+}
+
 void UIManagerImGui::renderAboutDialog() {
     ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x / 2 - 250 * dpiScale_, ImGui::GetIO().DisplaySize.y / 2 - 150 * dpiScale_), ImGuiCond_Always);
     ImGui::SetNextWindowSize(ImVec2(500 * dpiScale_, 300 * dpiScale_), ImGuiCond_Always);
@@ -13,6 +13,7 @@
 #include "LayerThumbnail.h"
 #include <imgui.h>
 #include <map>
+#include <vector>
 
 enum class EditMode {
     LAYER,
@@ -57,6 +58,14 @@ public:
     void clearResolutionChanged() { resolutionChanged_ = false; }
 
     bool isRealTimePreviewEnabled() const { return enableRealTimePreview_; }
+    bool isSpeculationEnabled() const { return enableSpeculation_; }
+
+    // Params the user is likely to pick next, most likely first: the hovered
+    // preset, neighbouring values of the last touched slider (in the
+    // direction it last moved first), then the presets next to the selected one
+    std::vector<TerrainParams> getSpeculativeParams() const;
+    bool hasSpeculationChanged() const { return speculationChanged_; }
+    void clearSpeculationChanged() { speculationChanged_ = false; }
 
     ExportFormat getExportFormat() const { return exportFormat_; }
 
@@ -64,6 +73,7 @@ public:
     void setActiveTool(BrushType tool) { activeTool_ = tool; brushChanged_ = true; }
     int getBrushSize() const { return brushSize_; }
     float getBrushStrength() const { return brushStrength_; }
+    ErosionBrush::Mode getErosionMode() const { return erosionMode_; }
 
     bool hasBrushChanged() const { return brushChanged_; }
     void clearBrushChanged() { brushChanged_ = false; }
@@ -119,6 +129,11 @@ private:
     void renderLayerTreeNode(LayerBase* layer, size_t layerIndex, bool isRootLevel);
     void renderAboutDialog();
     void renderShortcutsDialog();
+
+    // ImGui::SliderFloat for a TerrainParams field; records the slider as
+    // the last touched one for speculation, which tries neighbours `step` apart
+    bool paramSlider(const char* label, float TerrainParams::* field, float min, float max, float step);
+
     TerrainParams params_;
     bool paramsChanged_;
 
@@ -138,6 +153,20 @@ private:
     bool resolutionChanged_;
     bool enableRealTimePreview_;
 
+    // Speculative pre-generation
+    struct TouchedSlider {
+        float TerrainParams::* field = nullptr;  // Null until a slider is touched
+        float min = 0.0f;
+        float max = 0.0f;
+        float step = 0.0f;       // Speculation step for this parameter
+        int direction = 1;       // Sign of the last change
+    };
+    static constexpr int SPECULATIVE_STEPS = 4;  // Slider steps tried each side
+    bool enableSpeculation_;
+    bool speculationChanged_;
+    TouchedSlider touchedSlider_;
+    int hoveredPreset_;
+
     ExportFormat exportFormat_;
 
     float dpiScale_ = 1.0f;
@@ -146,6 +175,7 @@ private:
     int brushSize_;
     float brushStrength_;
     bool brushChanged_;
+    ErosionBrush::Mode erosionMode_;
 
     float stampScale_;
     float stampRotation_;
@@ -0,0 +1,88 @@
+// Stitched generateChunk() tiles must match one render over the same area
+// bit for bit, with every neighborhood stage that chunks support turned on.
+
+#include "TerrainGenerator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+constexpr int CHUNK_SIZE = 64;
+constexpr int CHUNKS = 3;
+
+// Returns the number of pixels in a CHUNKS x CHUNKS grid of tiles that
+// differ from a single render of the whole grid
+int countSeamMismatches(const char* name, const TerrainParams& params, ThreadPool* pool) {
+    const int fullSize = CHUNK_SIZE * CHUNKS;
+    HeightMap full = TerrainGenerator::generateChunk(0, 0, fullSize, params, pool);
+
+    int mismatches = 0;
+    float maxDiff = 0.0f;
+    for (int cy = 0; cy < CHUNKS; ++cy) {
+        for (int cx = 0; cx < CHUNKS; ++cx) {
+            HeightMap chunk = TerrainGenerator::generateChunk(cx, cy, CHUNK_SIZE, params, pool);
+            for (int y = 0; y < CHUNK_SIZE; ++y) {
+                for (int x = 0; x < CHUNK_SIZE; ++x) {
+                    float a = chunk.at(x, y);
+                    float b = full.at(cx * CHUNK_SIZE + x, cy * CHUNK_SIZE + y);
+                    if (a != b) {
+                        if (mismatches == 0) {
+                            std::printf("  %s: chunk (%d,%d) differs first at local (%d,%d)\n",
+                                        name, cx, cy, x, y);
+                        }
+                        ++mismatches;
+                        maxDiff = std::max(maxDiff, std::fabs(a - b));
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%s %s: %d of %d pixels differ (max %g)\n",
+                mismatches == 0 ? "[PASS]" : "[FAIL]", name,
+                mismatches, fullSize * fullSize, maxDiff);
+    return mismatches;
+}
+
+} // namespace
+
+int main() {
+    ThreadPool pool(4);
+    int failures = 0;
+
+    // Defaults: legacy erosion
+    TerrainParams defaults;
+    failures += countSeamMismatches("default params", defaults, &pool) != 0;
+
+    TerrainParams thermalShort;
+    thermalShort.thermalErosionEnabled = true;
+    thermalShort.thermalIterations = 5;
+    thermalShort.erosion = 1.0f;
+    thermalShort.thermalTalusAngle = 0.01f;
+    thermalShort.scale = 20.0f;
+    failures += countSeamMismatches("thermal x5", thermalShort, &pool) != 0;
+
+    TerrainParams thermalLong = thermalShort;
+    thermalLong.thermalIterations = 30;
+    failures += countSeamMismatches("thermal x30", thermalLong, &pool) != 0;
+
+    // Serial path uses the same bands, so it must agree too
+    failures += countSeamMismatches("thermal x30 serial", thermalLong, nullptr) != 0;
+
+    TerrainParams softened;
+    softened.erosion = 0.5f;
+    softened.terrainSmoothness = 0.8f;
+    softened.terracing = 4;
+    failures += countSeamMismatches("legacy erosion + softening", softened, &pool) != 0;
+
+    TerrainParams everything = thermalShort;
+    everything.thermalIterations = 10;
+    everything.thermalTalusAngle = 0.001f;
+    everything.scale = 8.0f;
+    everything.terrainSmoothness = 0.5f;
+    failures += countSeamMismatches("thermal + softening", everything, &pool) != 0;
+
+    return failures == 0 ? 0 : 1;
+}